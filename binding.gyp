@@ -6,8 +6,10 @@
 			'src/native/enums.cpp',
 			'src/native/global.cpp',
 			'src/native/events.cpp',
+			'src/native/histogram.cpp',
 			'src/native/video.cpp',
 			'src/native/window.cpp',
+			'src/native/texture.cpp',
 			'src/native/keyboard.cpp',
 			'src/native/mouse.cpp',
 			'src/native/touch.cpp',
@@ -17,6 +19,11 @@
 			'src/native/audio.cpp',
 			'src/native/clipboard.cpp',
 			'src/native/power.cpp',
+			'src/native/trace.cpp',
+			'src/native/render-thread.cpp',
+			'src/native/recorder.cpp',
+			'src/native/pixels.cpp',
+			'src/native/compositing.cpp',
 		],
 		'dependencies': [
 			"<!(node -p \"require('node-addon-api').targets\"):node_addon_api_except",
@@ -4,7 +4,16 @@ import path from 'node:path'
 
 export const loadImage = async (filepath, options) => (await loadVideo(filepath, options))[0]
 
-export const loadVideo = async (filepath, { width, height, framerate }) => {
+const getFrameSize = (width, height, format) => {
+	switch (format) {
+		case 'rgb24': return width * height * 3
+		// Full resolution luma followed by two quarter resolution chroma planes
+		case 'yuv420p': return width * height + 2 * Math.ceil(width / 2) * Math.ceil(height / 2)
+		default: throw new Error(`unsupported format ${format}`)
+	}
+}
+
+export const loadVideo = async (filepath, { width, height, framerate, format = 'rgb24' }) => {
 	const proc = spawn(
 		ffmpeg,
 		[
@@ -13,14 +22,14 @@ export const loadVideo = async (filepath, { width, height, framerate }) => {
 			[
 				framerate && `fps=fps=${framerate}`,
 				`scale=${width}:${height}`,
-				'format=pix_fmts=rgb24',
+				`format=pix_fmts=${format}`,
 			].filter(Boolean).join(','),
 			[ '-f', 'rawvideo' ],
 			'-',
 		].flat(),
 	)
 
-	const frameSize = width * height * 3
+	const frameSize = getFrameSize(width, height, format)
 	const frames = []
 	let chunks = []
 	let size = 0
@@ -10,9 +10,24 @@ const { pixelWidth: width, pixelHeight: height } = window
 
 const [ image, video ] = await Promise.all([
 	loadImage(path.join(import.meta.dirname, 'assets/image.png'), { width, height }),
-	loadVideo(path.join(import.meta.dirname, 'assets/video.mp4'), { width, height, framerate }),
+	loadVideo(path.join(import.meta.dirname, 'assets/video.mp4'), { width, height, framerate, format: 'yuv420p' }),
 ])
 
+// Video frames are kept as yuv420p and converted on the GPU
+const chromaWidth = Math.ceil(width / 2)
+const chromaHeight = Math.ceil(height / 2)
+const lumaSize = width * height
+const chromaSize = chromaWidth * chromaHeight
+
+const renderVideoFrame = (frame) => {
+	window.renderYUV(
+		width, height,
+		frame.subarray(0, lumaSize), width,
+		frame.subarray(lumaSize, lumaSize + chromaSize), chromaWidth,
+		frame.subarray(lumaSize + chromaSize), chromaWidth,
+	)
+}
+
 let startTime = null
 let lastIndex = null
 
@@ -44,7 +59,7 @@ const render = async () => {
 				return
 			}
 
-			window.render(width, height, width * 3, 'rgb24', video[index])
+			renderVideoFrame(video[index])
 			lastIndex = index
 		}
 
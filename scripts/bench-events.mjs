@@ -0,0 +1,175 @@
+import V8 from 'node:v8'
+import { PerformanceObserver } from 'node:perf_hooks'
+
+// Runs without a display, so it can be used to track regressions in CI.
+process.env.SDL_VIDEODRIVER ??= 'dummy'
+process.env.SDL_AUDIODRIVER ??= 'dummy'
+
+const { default: sdl } = await import('../src/javascript/index.js')
+const { default: Globals } = await import('../src/javascript/globals.js')
+const { default: Bindings } = await import('../src/javascript/bindings.js')
+
+const args = Object.fromEntries(process.argv.slice(2).map((arg) => {
+	const [ key, value = 'true' ] = arg.replace(/^--/u, '').split('=')
+	return [ key, value ]
+}))
+
+const NUM_EVENTS = Number(args.events ?? 100e3)
+const BATCH_SIZE = 10e3 // SDL's queue holds at most 65535 events
+const ALLOCATION_BATCH_SIZE = 1e3
+const ALLOCATION_SAMPLES = 15
+
+const window = sdl.video.createWindow({ visible: false })
+
+const attachVirtual = (isController) => {
+	const id = Bindings.joystick_attachVirtual(isController, 6, 16, 1)
+	const devices = isController ? sdl.controller.devices : sdl.joystick.devices
+	return devices.find((device) => device.id === id)
+}
+
+const joystickDevice = attachVirtual(false)
+const joystick = sdl.joystick.openDevice(joystickDevice)
+const controllerDevice = attachVirtual(true)
+const controller = sdl.controller.openDevice(controllerDevice)
+
+const noop = () => {}
+
+const scenarios = [
+	{
+		name: 'keyboard',
+		emitter: window,
+		types: [ 'keyDown', 'keyUp' ],
+		make: (i) => ({ type: i % 2 ? 'keyUp' : 'keyDown', window, scancode: 4 + (i % 26), shift: i % 3 === 0 }),
+	},
+	{
+		name: 'mouseMove',
+		emitter: window,
+		types: [ 'mouseMove' ],
+		make: (i) => ({ type: 'mouseMove', window, x: i % 640, y: i % 480, dx: 1, dy: 1 }),
+	},
+	{
+		name: 'mouseMove (coalesced)',
+		emitter: window,
+		types: [ 'mouseMove' ],
+		setup: () => window.setCoalesceMotion(true),
+		teardown: () => window.setCoalesceMotion(false),
+		make: (i) => ({ type: 'mouseMove', window, x: i % 640, y: i % 480, dx: 1, dy: 1 }),
+	},
+	{
+		name: 'mouseButton',
+		emitter: window,
+		types: [ 'mouseButtonDown', 'mouseButtonUp' ],
+		make: (i) => ({ type: i % 2 ? 'mouseButtonUp' : 'mouseButtonDown', window, x: 10, y: 10, button: 1 }),
+	},
+	{
+		name: 'fingerMove',
+		emitter: window,
+		types: [ 'fingerMove' ],
+		make: (i) => ({ type: 'fingerMove', window, fingerId: i % 5, x: 0.5, y: 0.5, dx: 0.01, dy: 0.01 }),
+	},
+	{
+		name: 'joystick',
+		emitter: joystick,
+		types: [ 'axisMotion', 'buttonDown', 'buttonUp' ],
+		make: (i) => i % 4
+			? { type: 'axisMotion', joystick, axis: i % 6, value: Math.sin(i) }
+			: { type: i % 8 ? 'buttonUp' : 'buttonDown', joystick, button: i % 16 },
+	},
+	{
+		name: 'controller',
+		emitter: controller,
+		types: [ 'axisMotion', 'buttonDown', 'buttonUp' ],
+		make: (i) => i % 4
+			? { type: 'axisMotion', controller, axis: 'leftStickX', value: Math.sin(i) }
+			: { type: i % 8 ? 'buttonUp' : 'buttonDown', controller, button: 'a' },
+	},
+]
+
+const usedHeap = () => V8.getHeapStatistics().used_heap_size
+
+const median = (values) => values.sort((a, b) => a - b)[Math.floor(values.length / 2)]
+
+// Heap growth is only meaningful if no GC ran in between, so take the
+// median over several small batches.
+const measureAllocations = (events) => {
+	const samples = []
+	for (let i = 0; i < ALLOCATION_SAMPLES; i++) {
+		Globals.events.poll()
+		let before = usedHeap()
+		Globals.events.poll()
+		const overhead = usedHeap() - before
+
+		sdl.events.push(events)
+		before = usedHeap()
+		Globals.events.poll()
+		samples.push(usedHeap() - before - overhead)
+	}
+	return Math.max(0, median(samples)) / events.length
+}
+
+let gcCount = 0
+const observer = new PerformanceObserver((list) => { gcCount += list.getEntries().length })
+observer.observe({ entryTypes: [ 'gc' ] })
+
+const flushObserver = () => new Promise((resolve) => { setImmediate(resolve) })
+
+const results = []
+for (const scenario of scenarios) {
+	const { name, emitter, types, setup, teardown, make } = scenario
+
+	for (const type of types) { emitter.on(type, noop) }
+	setup?.()
+	Globals.events.poll()
+
+	const events = Array.from({ length: NUM_EVENTS }, (_, i) => make(i))
+
+	let pushTime = 0
+	let pollTime = 0
+	let pushed = 0
+
+	await flushObserver()
+	const gcBefore = gcCount
+
+	for (let start = 0; start < events.length; start += BATCH_SIZE) {
+		const batch = events.slice(start, start + BATCH_SIZE)
+
+		let time = process.hrtime.bigint()
+		pushed += sdl.events.push(batch)
+		pushTime += Number(process.hrtime.bigint() - time)
+
+		time = process.hrtime.bigint()
+		Globals.events.poll()
+		pollTime += Number(process.hrtime.bigint() - time)
+	}
+
+	await flushObserver()
+	const gcs = gcCount - gcBefore
+
+	const bytesPerEvent = measureAllocations(events.slice(0, ALLOCATION_BATCH_SIZE))
+
+	teardown?.()
+	for (const type of types) { emitter.off(type, noop) }
+
+	results.push({
+		name,
+		events: pushed,
+		pushPerSecond: Math.round(pushed / (pushTime / 1e9)),
+		dispatchPerSecond: Math.round(pushed / (pollTime / 1e9)),
+		gcs,
+		bytesPerEvent: Math.round(bytesPerEvent),
+	})
+}
+
+observer.disconnect()
+
+joystick.close()
+controller.close()
+Bindings.joystick_detachVirtual(controllerDevice.id)
+Bindings.joystick_detachVirtual(joystickDevice.id)
+window.destroy()
+
+if (args.json) {
+	console.log(JSON.stringify(results, null, 2))
+} else {
+	console.table(results)
+}
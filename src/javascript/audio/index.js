@@ -4,10 +4,11 @@ const { EventsViaPoll } = require('../events/events-via-poll')
 const { AudioPlaybackInstance } = require('./audio-playback-instance')
 const { AudioRecordingInstance } = require('./audio-recording-instance')
 const { AudioFormatHelpers } = require('./format-helpers')
+const { compare: compareAudioDevice } = require('./device')
 
 
-Globals.audioDevices.playback = Bindings.audio_getDevices(false)
-Globals.audioDevices.recording = Bindings.audio_getDevices(true)
+Globals.audioDevices.playback = Bindings.audio_getDevices(false).sort(compareAudioDevice)
+Globals.audioDevices.recording = Bindings.audio_getDevices(true).sort(compareAudioDevice)
 
 
 const validEvents = [ 'deviceAdd', 'deviceRemove' ]
@@ -1,11 +1,16 @@
 const Bindings = require('./bindings')
 const Globals = require('./globals')
+const { events } = require('./events/events-module')
 
 process.on('exit', (code) => {
 	if (code !== 0) { return }
 
 	Globals.events.stopPolling()
 
+	// Make sure the trace gets written out
+	if (events.recording) { events.stopRecording() }
+	if (events.replaying) { events.stopReplay() }
+
 	// Close all windows
 	for (const window of Globals.windows.all.values()) {
 		window.destroy()
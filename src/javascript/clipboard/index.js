@@ -5,7 +5,7 @@ const { EventsViaPoll } = require('../events/events-via-poll')
 const validEvents = [ 'update' ]
 
 const clipboard = new class extends EventsViaPoll {
-	constructor () { super(validEvents) }
+	constructor () { super(validEvents, { families: { update: 'clipboard' } }) }
 
 	get text () {
 		Globals.events.poll()
@@ -1,6 +1,7 @@
 const Globals = require('../globals')
 const Bindings = require('../bindings')
-const { EventsViaPoll } = require('../events/events-via-poll')
+const Enums = require('../enums')
+const { EventsViaPoll, retainFamily, releaseFamily } = require('../events/events-via-poll')
 
 const validEvents = [
 	'axisMotion',
@@ -14,11 +15,11 @@ const validEvents = [
 
 class ControllerInstance extends EventsViaPoll {
 	constructor (device) {
-		super(validEvents)
+		super(validEvents, { pumping: true })
 
 		if (!Globals.controllerDevices.includes(device)) { throw Object.assign(new Error("invalid device"), { device }) }
 
-		const result = Bindings.controller_open(device._index)
+		const result = Bindings.controller_open(device.id)
 
 		this._firmwareVersion = result.firmwareVersion
 		this._serialNumber = result.serialNumber
@@ -34,8 +35,12 @@ class ControllerInstance extends EventsViaPoll {
 
 		this._rumbleTimeout = null
 		this._rumbleTriggersTimeout = null
+		this._coalesceAxisMotion = false
 		this._closed = false
 
+		// Instances keep their state up to date even without listeners
+		retainFamily('controller')
+
 		Globals.controllerInstances.all.add(this)
 		let collection = Globals.controllerInstances.byId.get(this._device.id)
 		if (!collection) {
@@ -139,6 +144,30 @@ class ControllerInstance extends EventsViaPoll {
 		Globals.events.poll()
 	}
 
+	get coalesceAxisMotion () { return this._coalesceAxisMotion }
+	setCoalesceAxisMotion (coalesceAxisMotion) {
+		if (this._closed) { throw Object.assign(new Error("instance is closed"), { id: this._device.id }) }
+
+		if (typeof coalesceAxisMotion !== 'boolean') { throw Object.assign(new Error("coalesceAxisMotion must be a boolean"), { coalesceAxisMotion }) }
+
+		this._coalesceAxisMotion = coalesceAxisMotion
+		this._updateCoalescing()
+	}
+
+	_updateCoalescing () {
+		const collection = Globals.controllerInstances.byId.get(this._device.id)
+		let enabled = false
+		if (collection) {
+			for (const instance of collection) {
+				if (instance._coalesceAxisMotion) {
+					enabled = true
+					break
+				}
+			}
+		}
+		Bindings.events_setCoalescing(Enums.eventFamilies.controller, this._device.id, enabled)
+	}
+
 	get closed () { return this._closed }
 	close () {
 		if (this._closed) { throw Object.assign(new Error("instance is closed"), { id: this._device.id }) }
@@ -147,9 +176,12 @@ class ControllerInstance extends EventsViaPoll {
 		this.removeAllListeners()
 		this._closed = true
 
+		releaseFamily('controller')
+
 		Globals.controllerInstances.all.delete(this)
 		const collection = Globals.controllerInstances.byId.get(this._device.id)
 		collection.delete(this)
+		if (this._coalesceAxisMotion) { this._updateCoalescing() }
 		if (collection.size === 0) {
 			Bindings.controller_close(this._device.id)
 			Globals.controllerInstances.byId.delete(this._device.id)
@@ -6,7 +6,7 @@ const { ControllerInstance } = require('./controller-instance')
 const validEvents = [ 'deviceAdd', 'deviceRemove' ]
 
 const controller = new class extends EventsViaPoll {
-	constructor () { super(validEvents) }
+	constructor () { super(validEvents, { pumping: true }) }
 
 	get devices () {
 		Globals.events.poll()
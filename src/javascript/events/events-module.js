@@ -0,0 +1,202 @@
+const Bindings = require('../bindings')
+const Enums = require('../enums')
+
+const {
+	eventFamilies: FAMILIES,
+	eventTypes: TYPES,
+	eventRecord: RECORD,
+	eventModifiers: MODIFIERS,
+	hatPositions,
+	controllerAxes,
+	controllerButtons,
+} = Enums
+
+const keyboardTypes = [ 'keyDown', 'keyUp' ]
+const mouseTypes = [ 'mouseMove', 'mouseButtonDown', 'mouseButtonUp', 'mouseWheel' ]
+const touchTypes = [ 'fingerDown', 'fingerUp', 'fingerMove' ]
+
+const CAPACITY = 1024
+const records = new Float64Array(CAPACITY * RECORD.size)
+
+const getFamily = (event) => {
+	const { type } = event
+	if (keyboardTypes.includes(type)) { return 'keyboard' }
+	if (mouseTypes.includes(type)) { return 'mouse' }
+	if (touchTypes.includes(type)) { return 'touch' }
+	if (event.controller) { return 'controller' }
+	if (event.joystick) { return 'joystick' }
+	throw Object.assign(new Error("invalid event"), { event })
+}
+
+const getModifiers = (event) => 0
+	| (event.alt ? MODIFIERS.alt : 0)
+	| (event.ctrl ? MODIFIERS.ctrl : 0)
+	| (event.shift ? MODIFIERS.shift : 0)
+	| (event.super ? MODIFIERS.super : 0)
+	| (event.altgr ? MODIFIERS.altgr : 0)
+	| (event.numlock ? MODIFIERS.numlock : 0)
+	| (event.capslock ? MODIFIERS.capslock : 0)
+
+// Packs an event object into the same record layout that the bindings use
+// for polling. Fields that don't apply to the event's type are left at 0.
+const packEvent = (event, offset) => {
+	const family = getFamily(event)
+	const type = TYPES[event.type]
+	const data = offset + RECORD.data
+
+	records.fill(0, offset, offset + RECORD.size)
+	records[offset + RECORD.family] = FAMILIES[family]
+	records[offset + RECORD.type] = type
+
+	switch (family) {
+		case 'keyboard': {
+			records[offset + RECORD.id] = event.window?.id ?? 0
+			records[data + 0] = event.scancode
+			records[data + 2] = event.repeat ? 1 : 0
+			records[data + 3] = getModifiers(event)
+		} break
+
+		case 'mouse': {
+			records[offset + RECORD.id] = event.window?.id ?? 0
+			records[data + 1] = event.x ?? 0
+			records[data + 2] = event.y ?? 0
+			if (event.type === 'mouseMove' || event.type === 'mouseWheel') {
+				records[data + 3] = event.dx ?? 0
+				records[data + 4] = event.dy ?? 0
+				records[data + 5] = event.flipped ? 1 : 0
+			} else {
+				records[data + 3] = event.button
+			}
+		} break
+
+		case 'touch': {
+			records[offset + RECORD.id] = event.window?.id ?? 0
+			records[data + 1] = event.device?.id ?? 0
+			records[data + 2] = event.fingerId
+			records[data + 3] = event.x
+			records[data + 4] = event.y
+			records[data + 5] = event.dx ?? 0
+			records[data + 6] = event.dy ?? 0
+			records[data + 7] = event.pressure ?? 1
+		} break
+
+		case 'joystick': {
+			if (event.joystick._closed) { throw Object.assign(new Error("instance is closed"), { event }) }
+			records[offset + RECORD.id] = event.joystick.device.id
+			switch (event.type) {
+				case 'axisMotion': {
+					records[data + 0] = event.axis
+					records[data + 1] = event.value
+				} break
+				case 'ballMotion': {
+					records[data + 0] = event.ball
+					records[data + 1] = event.x
+					records[data + 2] = event.y
+				} break
+				case 'buttonDown':
+				case 'buttonUp': {
+					records[data + 0] = event.button
+				} break
+				case 'hatMotion': {
+					records[data + 0] = event.hat
+					records[data + 1] = hatPositions[event.value]
+				} break
+				default: throw Object.assign(new Error("invalid event"), { event })
+			}
+		} break
+
+		case 'controller': {
+			if (event.controller._closed) { throw Object.assign(new Error("instance is closed"), { event }) }
+			records[offset + RECORD.id] = event.controller.device.id
+			switch (event.type) {
+				case 'axisMotion': {
+					records[data + 0] = controllerAxes[event.axis]
+					records[data + 1] = event.value
+				} break
+				case 'buttonDown':
+				case 'buttonUp': {
+					records[data + 0] = controllerButtons[event.button]
+				} break
+				default: throw Object.assign(new Error("invalid event"), { event })
+			}
+		} break
+
+		// No default
+	}
+
+	for (let i = offset; i < offset + RECORD.size; i++) {
+		if (!Number.isFinite(records[i])) {
+			throw Object.assign(new Error("invalid event"), { event })
+		}
+	}
+}
+
+let recording = false
+let replaying = false
+
+const events = {
+	push (_events) {
+		if (!Array.isArray(_events)) { throw Object.assign(new Error("events must be an array"), { events: _events }) }
+
+		let pushed = 0
+		for (let start = 0; start < _events.length; start += CAPACITY) {
+			const count = Math.min(_events.length - start, CAPACITY)
+			for (let i = 0; i < count; i++) {
+				packEvent(_events[start + i], i * RECORD.size)
+			}
+
+			const batch = Bindings.events_push(records, count)
+			pushed += batch
+			if (batch < count) { break }
+		}
+
+		return pushed
+	},
+
+	get recording () { return recording },
+
+	startRecording (path) {
+		if (typeof path !== 'string') { throw Object.assign(new Error("path must be a string"), { path }) }
+		if (recording) { throw new Error("already recording") }
+
+		Bindings.trace_startRecording(path)
+		recording = true
+	},
+
+	stopRecording () {
+		if (!recording) { throw new Error("not recording") }
+
+		recording = false
+		return Bindings.trace_stopRecording()
+	},
+
+	get replaying () { return replaying },
+
+	replay (path, options = {}) {
+		const { speed = 1 } = options
+
+		if (typeof path !== 'string') { throw Object.assign(new Error("path must be a string"), { path }) }
+		if (typeof speed !== 'number' || Number.isNaN(speed)) { throw Object.assign(new Error("speed must be a number"), { speed }) }
+		if (speed <= 0) { throw Object.assign(new Error("invalid speed"), { speed }) }
+		if (replaying) { throw new Error("already replaying") }
+
+		let resolve
+		const promise = new Promise((_resolve) => { resolve = _resolve })
+
+		Bindings.trace_startReplay(path, speed, () => {
+			replaying = false
+			resolve()
+		})
+		replaying = true
+
+		return promise
+	},
+
+	stopReplay () {
+		if (!replaying) { throw new Error("not replaying") }
+
+		Bindings.trace_stopReplay()
+	},
+}
+
+module.exports = { events }
@@ -1,17 +1,65 @@
 const Globals = require('../globals')
+const Bindings = require('../bindings')
+const Enums = require('../enums')
 const { EventEmitter } = require('events')
 
 let _ID = 0
 const activeEmitters = new Set()
+const pumpingEmitters = new Set()
+
+const updatePolling = () => {
+	Globals.events.updatePolling(activeEmitters.size !== 0, pumpingEmitters.size !== 0)
+}
+
+// These families only exist to be emitted, so the bindings can drop them
+// until something retains them. All other families update internal state.
+const familyCounts = new Map([
+	[ 'keyboard', 0 ],
+	[ 'text', 0 ],
+	[ 'mouse', 0 ],
+	[ 'touch', 0 ],
+	[ 'drop', 0 ],
+	[ 'keymap', 0 ],
+	[ 'clipboard', 0 ],
+	[ 'sensor', 0 ],
+	[ 'joystick', 0 ],
+	[ 'controller', 0 ],
+])
+
+const updateFamilies = () => {
+	let mask = 0
+	for (const [ family, code ] of Object.entries(Enums.eventFamilies)) {
+		if (familyCounts.get(family) === 0) { continue }
+		mask |= 1 << code
+	}
+	Bindings.events_setEnabledFamilies(mask)
+}
+
+const retainFamily = (family) => {
+	const count = familyCounts.get(family) + 1
+	familyCounts.set(family, count)
+	if (count === 1) { updateFamilies() }
+}
+
+const releaseFamily = (family) => {
+	const count = familyCounts.get(family) - 1
+	familyCounts.set(family, count)
+	if (count === 0) { updateFamilies() }
+}
 
 const commonEvents = [ 'newListener', 'removeListener', '*' ]
 
 class EventsViaPoll extends EventEmitter {
-	constructor (validEvents) {
+	// Emitters with `pumping` set get their events from devices that SDL only
+	// reads while pumping the event loop, so we can't wait for a wakeup.
+	// `families` maps event types to the optional family they come from.
+	constructor (validEvents, { pumping = false, families = {} } = {}) {
 		super()
 
 		this._validEvents = validEvents
 
+		const allFamilies = [ ...new Set(Object.values(families)) ]
+
 		const id = _ID++
 		let count = 0
 
@@ -21,13 +69,18 @@ class EventsViaPoll extends EventEmitter {
 				throw Object.assign(new Error("invalid event"), { type })
 			}
 
+			if (type === '*') {
+				for (const family of allFamilies) { releaseFamily(family) }
+			} else if (families[type]) {
+				releaseFamily(families[type])
+			}
+
 			count--
 			if (count !== 0) { return }
 
 			activeEmitters.delete(id)
-			if (activeEmitters.size !== 0) { return }
-
-			Globals.events.switchToPollingSlow()
+			if (pumping) { pumpingEmitters.delete(id) }
+			updatePolling()
 		})
 
 		this.on('newListener', (type) => {
@@ -35,16 +88,25 @@ class EventsViaPoll extends EventEmitter {
 				throw Object.assign(new Error("invalid event"), { type })
 			}
 
+			if (type === '*') {
+				for (const family of allFamilies) { retainFamily(family) }
+			} else if (families[type]) {
+				retainFamily(families[type])
+			}
+
 			count++
 			if (count !== 1) { return }
 
 			activeEmitters.add(id)
-			if (activeEmitters.size !== 1) { return }
-
-			Globals.events.switchToPollingFast()
+			if (pumping) { pumpingEmitters.add(id) }
+			updatePolling()
 		})
 	}
 
+	_hasListeners (type) {
+		return this.listenerCount(type) !== 0 || this.listenerCount('*') !== 0
+	}
+
 	emit (type, ...args) {
 		const isCommon = commonEvents.includes(type)
 		const isValid = this._validEvents.includes(type)
@@ -60,4 +122,9 @@ class EventsViaPoll extends EventEmitter {
 	}
 }
 
-module.exports = { EventsViaPoll }
+module.exports = {
+	EventsViaPoll,
+	updateFamilies,
+	retainFamily,
+	releaseFamily,
+}
@@ -1,18 +1,85 @@
 const Globals = require('../globals')
 const Bindings = require('../bindings')
+const Enums = require('../enums')
 const { video: videoModule } = require('../video')
 const { reconcileDisplays } = require('./reconcile-displays')
 const { keyboard: keyboardModule } = require('../keyboard')
 const { mapping } = require('../keyboard/key-mapping')
-const { reconcileAudioDevices } = require('./reconcile-audio-devices')
-const { reconcileJoystickAndControllerDevices } = require('./reconcile-joystick-and-controller-devices')
+const {
+	reconcileAudioDevices,
+	addAudioDevice,
+} = require('./reconcile-audio-devices')
+const {
+	addJoystickAndControllerDevice,
+	removeJoystickAndControllerDevice,
+} = require('./reconcile-joystick-and-controller-devices')
 const { clipboard: clipboardModule } = require('../clipboard')
+const { updateFamilies } = require('./events-via-poll')
+
+
+const {
+	eventFamilies,
+	eventTypes,
+	eventRecord: RECORD,
+	eventModifiers: MODIFIERS,
+	hatPositions,
+	powerLevels,
+	orientations,
+	controllerAxes,
+	controllerButtons,
+} = Enums
+
+const invert = (object) => {
+	const result = []
+	for (const [ name, code ] of Object.entries(object)) { result[code] = name }
+	return result
+}
 
+const familyNames = invert(eventFamilies)
+const typeNames = invert(eventTypes)
+const hatPositionNames = invert(hatPositions)
+const powerLevelNames = invert(powerLevels)
+const orientationNames = invert(orientations)
+const controllerAxisNames = invert(controllerAxes)
+const controllerButtonNames = invert(controllerButtons)
+
+const CAPACITY = 256
+const records = new Float64Array(CAPACITY * RECORD.size)
+const extras = []
+
+const keyNames = new Map()
+const getKeyName = (keycode) => {
+	let key = keyNames.get(keycode)
+	if (key === undefined) {
+		const _key = Bindings.keyboard_getKeyName(keycode)
+		key = mapping[_key] ?? (_key?.length === 1 ? _key : null)
+		keyNames.set(keycode, key)
+	}
+	return key
+}
 
-const handleEvent = (event) => {
-	const { family, type } = event
-	if (family === undefined || type === undefined) { return }
-	delete event.family
+const getTouchDevice = (touchId) => {
+	let device = Globals.touchDevices.find(({ id }) => id === touchId)
+	if (device === undefined) {
+		Globals.touchDevices = Bindings.touch_getDevices()
+		device = Globals.touchDevices.find(({ id }) => id === touchId)
+	}
+	return device
+}
+
+const getExtra = (offset) => {
+	const index = records[offset + RECORD.extra]
+	return index === -1 ? undefined : extras[index]
+}
+
+// Event objects only get created if someone is listening for them.
+// Internal state is updated directly from the record.
+const handleRecord = (offset) => {
+	const family = familyNames[records[offset + RECORD.family]]
+	const type = typeNames[records[offset + RECORD.type]]
+	const id = records[offset + RECORD.id]
+	const timestamp = records[offset + RECORD.timestamp]
+	const data = offset + RECORD.data
 
 	switch (family) {
 		case 'app': {
@@ -25,68 +92,74 @@ const handleEvent = (event) => {
 
 		// TODO: this also needs a reconcile function
 		case 'display': {
-			const { displayIndex } = event
-			delete event.displayIndex
+			const displayIndex = id
 
 			switch (type) {
 				case 'displayAdd':
 				case 'displayRemove':
 				{
-					const { displays } = event
-					delete event.displays
-
-					reconcileDisplays(displays)
+					reconcileDisplays(getExtra(offset))
 					return
 				}
 
 				case 'displayOrient': {
+					const orientation = orientationNames[records[data + 0]] ?? null
 					const display = Globals.displays[displayIndex]
-					display.orientation = event.orientation
+					display.orientation = orientation
+
+					if (!videoModule._hasListeners(type)) { return }
+					videoModule.emit(type, { type, timestamp, orientation })
 				} break
 
 				case 'displayMove': {
-					const { geometryX, geometryY, usableX, usableY } = event
-					delete event.geometryX
-					delete event.geometryY
-					delete event.usableX
-					delete event.usableY
-
 					const display = Globals.displays[displayIndex]
-					display.geometry.x = geometryX
-					display.geometry.y = geometryY
-					display.usable.x = usableX
-					display.usable.y = usableY
+					display.geometry.x = records[data + 0]
+					display.geometry.y = records[data + 1]
+					display.usable.x = records[data + 2]
+					display.usable.y = records[data + 3]
+
+					if (!videoModule._hasListeners(type)) { return }
+					videoModule.emit(type, { type, timestamp })
 				} break
 
 				// No default
 			}
-
-			videoModule.emit(type, event)
 		} break
 
 		case 'window': {
-			const { windowId } = event
-			delete event.windowId
-
-			const window = Globals.windows.all.get(windowId)
+			const window = Globals.windows.all.get(id)
 			if (!window) { return }
 
 			switch (type) {
 				case 'move': {
-					window._x = event.x
-					window._y = event.y
-				} break
+					window._x = records[data + 0]
+					window._y = records[data + 1]
+
+					if (!window._hasListeners(type)) { return }
+					window.emit(type, { type, timestamp, x: window._x, y: window._y })
+				} return
 				case 'resize': {
-					window._width = event.width
-					window._height = event.height
-					window._pixelWidth = event.pixelWidth
-					window._pixelHeight = event.pixelHeight
-				} break
+					window._width = records[data + 0]
+					window._height = records[data + 1]
+					window._pixelWidth = records[data + 2]
+					window._pixelHeight = records[data + 3]
+
+					if (!window._hasListeners(type)) { return }
+					window.emit(type, {
+						type,
+						timestamp,
+						width: window._width,
+						height: window._height,
+						pixelWidth: window._pixelWidth,
+						pixelHeight: window._pixelHeight,
+					})
+				} return
 				case 'displayChange': {
-					window._displayIndex = event.displayIndex
-					delete event.displayIndex
-					event.display = window.display
-				} break
+					window._displayIndex = records[data + 0]
+
+					if (!window._hasListeners(type)) { return }
+					window.emit(type, { type, timestamp, display: window.display })
+				} return
 
 				case 'show': {
 					window._visible = true
@@ -139,62 +212,153 @@ const handleEvent = (event) => {
 				default: return
 			}
 
-			window.emit(type, event)
+			if (!window._hasListeners(type)) { return }
+			window.emit(type, { type, timestamp })
 		} break
 
 		case 'keymap': {
-			keyboardModule.emit(type, event)
+			if (!keyboardModule._hasListeners(type)) { return }
+			keyboardModule.emit(type, { type, timestamp })
 		} break
 
 		case 'keyboard': {
-			const { windowId } = event
-			delete event.windowId
+			const window = Globals.windows.all.get(id)
+			if (!window) { return }
+			window._latencyTracker?.dispatched(timestamp)
+			if (!window._hasListeners(type)) { return }
+
+			// Each type gets its final shape up front so that V8 can keep a
+			// single hidden class per event type.
+			const scancode = records[data + 0]
+			const key = getKeyName(records[data + 1])
+			const modifiers = records[data + 3]
+			const alt = (modifiers & MODIFIERS.alt) !== 0
+			const ctrl = (modifiers & MODIFIERS.ctrl) !== 0
+			const shift = (modifiers & MODIFIERS.shift) !== 0
+			const _super = (modifiers & MODIFIERS.super) !== 0
+			const altgr = (modifiers & MODIFIERS.altgr) !== 0
+			const numlock = (modifiers & MODIFIERS.numlock) !== 0
+			const capslock = (modifiers & MODIFIERS.capslock) !== 0
+
+			if (type === 'keyDown') {
+				const repeat = records[data + 2] !== 0
+				window.emit(type, { type, timestamp, scancode, key, repeat, alt, ctrl, shift, super: _super, altgr, numlock, capslock })
+			} else {
+				window.emit(type, { type, timestamp, scancode, key, alt, ctrl, shift, super: _super, altgr, numlock, capslock })
+			}
+		} break
 
-			const window = Globals.windows.all.get(windowId)
+		case 'mouse': {
+			const window = Globals.windows.all.get(id)
 			if (!window) { return }
+			window._latencyTracker?.dispatched(timestamp)
+			if (!window._hasListeners(type)) { return }
 
-			const { key } = event
-			event.key = mapping[key] ?? (key?.length === 1 ? key : null)
+			const touch = records[data + 0] !== 0
+			const x = records[data + 1]
+			const y = records[data + 2]
 
-			window.emit(type, event)
-		} break
+			switch (type) {
+				case 'mouseMove': {
+					window.emit(type, {
+						type,
+						timestamp,
+						touch,
+						x,
+						y,
+						dx: records[data + 3],
+						dy: records[data + 4],
+						merged: records[offset + RECORD.merged],
+					})
+				} break
 
-		case 'mouse':
-		case 'text':
-		case 'drop': {
-			const { windowId } = event
-			delete event.windowId
+				case 'mouseButtonDown':
+				case 'mouseButtonUp': {
+					window.emit(type, { type, timestamp, touch, button: records[data + 3], x, y })
+				} break
+
+				case 'mouseWheel': {
+					window.emit(type, {
+						type,
+						timestamp,
+						touch,
+						x,
+						y,
+						dx: records[data + 3],
+						dy: records[data + 4],
+						flipped: records[data + 5],
+					})
+				} break
+
+				// No default
+			}
+		} break
 
-			const window = Globals.windows.all.get(windowId)
+		case 'text': {
+			const window = Globals.windows.all.get(id)
 			if (!window) { return }
+			window._latencyTracker?.dispatched(timestamp)
+			if (!window._hasListeners(type)) { return }
 
-			window.emit(type, event)
+			window.emit(type, { type, timestamp, text: getExtra(offset) })
 		} break
 
-		case 'touch': {
-			const { touchId } = event
-			delete event.touchId
+		case 'drop': {
+			const window = Globals.windows.all.get(id)
+			if (!window) { return }
+			window._latencyTracker?.dispatched(timestamp)
+			if (!window._hasListeners(type)) { return }
 
-			let device = Globals.touchState.devices.find(({ id }) => id === touchId)
-			if (device === undefined) {
-				Globals.touchDevices = Bindings.touch_getDevices()
-				device = Globals.touchState.devices.find(({ id }) => id === touchId)
-			}
+			switch (type) {
+				case 'dropFile': {
+					window.emit(type, { type, timestamp, file: getExtra(offset) })
+				} break
 
-			const { windowId } = event
-			delete event.windowId
+				case 'dropText': {
+					window.emit(type, { type, timestamp, text: getExtra(offset) })
+				} break
 
-			const window = Globals.windows.all.get(windowId)
-			if (!window) { return }
+				default: {
+					window.emit(type, { type, timestamp })
+				}
+			}
+		} break
 
-			event.device = device
-			window.emit(type, event)
+		case 'touch': {
+			const window = Globals.windows.all.get(id)
+			if (!window) { return }
+			window._latencyTracker?.dispatched(timestamp)
+			if (!window._hasListeners(type)) { return }
+
+			const mouse = records[data + 0] !== 0
+			const device = getTouchDevice(records[data + 1])
+			const fingerId = records[data + 2]
+			const x = records[data + 3]
+			const y = records[data + 4]
+			const pressure = records[data + 7]
+
+			if (type === 'fingerMove') {
+				window.emit(type, {
+					type,
+					timestamp,
+					mouse,
+					fingerId,
+					x,
+					y,
+					dx: records[data + 5],
+					dy: records[data + 6],
+					pressure,
+					device,
+					merged: records[offset + RECORD.merged],
+				})
+			} else {
+				window.emit(type, { type, timestamp, mouse, fingerId, x, y, pressure, device })
+			}
 		} break
 
 		case 'joystickDevice': {
 			if (type === 'deviceRemove') {
-				const { joystickId } = event
-				delete event.joystickId
+				const joystickId = id
 
 				closeJoysticks: {
 					const collection = Globals.joystickInstances.byId.get(joystickId)
@@ -211,69 +375,84 @@ const handleEvent = (event) => {
 						controllerInstance.close()
 					}
 				}
-			}
-
-			const { devices } = event
-			delete event.devices
 
-			reconcileJoystickAndControllerDevices(devices)
+				removeJoystickAndControllerDevice(joystickId)
+			} else {
+				addJoystickAndControllerDevice(getExtra(offset))
+			}
 		} break
 
 		case 'joystick': {
-			const { joystickId } = event
-			delete event.joystickId
-
-			const collection = Globals.joystickInstances.byId.get(joystickId)
+			const collection = Globals.joystickInstances.byId.get(id)
 			if (!collection) { return }
 
+			let event = null
+
 			switch (type) {
 				case 'axisMotion': {
+					const axis = records[data + 0]
+					const value = records[data + 1]
 					for (const joystickInstance of collection) {
-						joystickInstance._axes[event.axis] = event.value
+						joystickInstance._axes[axis] = value
+						if (!joystickInstance._hasListeners(type)) { continue }
+						event ??= { type, timestamp, axis, value, merged: records[offset + RECORD.merged] }
 						joystickInstance.emit(type, event)
 					}
 				} break
 
 				case 'ballMotion': {
+					const ball = records[data + 0]
+					const x = records[data + 1]
+					const y = records[data + 2]
 					for (const joystickInstance of collection) {
-						const ball = joystickInstance._balls[event.ball]
-						ball.x = event.x
-						ball.y = event.y
+						const _ball = joystickInstance._balls[ball]
+						_ball.x = x
+						_ball.y = y
+						if (!joystickInstance._hasListeners(type)) { continue }
+						event ??= { type, timestamp, ball, x, y }
 						joystickInstance.emit(type, event)
 					}
 				} break
 
-				case 'buttonDown': {
-					for (const joystickInstance of collection) {
-						joystickInstance._buttons[event.button] = true
-						joystickInstance.emit(type, event)
-					}
-				} break
+				case 'buttonDown':
 				case 'buttonUp': {
+					const button = records[data + 0]
+					const pressed = type === 'buttonDown'
 					for (const joystickInstance of collection) {
-						joystickInstance._buttons[event.button] = false
+						joystickInstance._buttons[button] = pressed
+						if (!joystickInstance._hasListeners(type)) { continue }
+						event ??= { type, timestamp, button }
 						joystickInstance.emit(type, event)
 					}
 				} break
 
 				case 'hatMotion': {
+					const hat = records[data + 0]
+					const value = hatPositionNames[records[data + 1]]
 					for (const joystickInstance of collection) {
-						joystickInstance._hats[event.hat] = event.value
+						joystickInstance._hats[hat] = value
+						if (!joystickInstance._hasListeners(type)) { continue }
+						event ??= { type, timestamp, hat, value }
 						joystickInstance.emit(type, event)
 					}
 				} break
 
 				case 'powerUpdate': {
+					const power = powerLevelNames[records[data + 0]] ?? null
 					for (const joystickInstance of collection) {
-						joystickInstance._power = event.power
+						joystickInstance._power = power
+						if (!joystickInstance._hasListeners(type)) { continue }
+						event ??= { type, timestamp, power }
 						joystickInstance.emit(type, event)
 					}
 
-					const otherCollection = Globals.controllerInstances.byId.get(joystickId)
+					const otherCollection = Globals.controllerInstances.byId.get(id)
 					if (!otherCollection) { break }
 
 					for (const controllerInstance of otherCollection) {
-						controllerInstance._power = event.power
+						controllerInstance._power = power
+						if (!controllerInstance._hasListeners(type)) { continue }
+						event ??= { type, timestamp, power }
 						controllerInstance.emit(type, event)
 					}
 				} break
@@ -283,49 +462,52 @@ const handleEvent = (event) => {
 		} break
 
 		case 'controller': {
-			const { controllerId } = event
-			delete event.controllerId
-
-			const collection = Globals.controllerInstances.byId.get(controllerId)
+			const collection = Globals.controllerInstances.byId.get(id)
 			if (!collection) { return }
 
+			let event = null
+
 			switch (type) {
 				case 'axisMotion': {
+					const axis = controllerAxisNames[records[data + 0]]
+					const value = records[data + 1]
 					for (const controllerInstance of collection.values()) {
-						controllerInstance._axes[event.axis] = event.value
-						controllerInstance.emit(type, event)
-					}
-				} break
-
-				case 'buttonDown': {
-					for (const controllerInstance of collection.values()) {
-						controllerInstance._buttons[event.button] = true
+						controllerInstance._axes[axis] = value
+						if (!controllerInstance._hasListeners(type)) { continue }
+						event ??= { type, timestamp, axis, value, merged: records[offset + RECORD.merged] }
 						controllerInstance.emit(type, event)
 					}
 				} break
 
+				case 'buttonDown':
 				case 'buttonUp': {
+					const button = controllerButtonNames[records[data + 0]]
+					const pressed = type === 'buttonDown'
 					for (const controllerInstance of collection.values()) {
-						controllerInstance._buttons[event.button] = false
+						controllerInstance._buttons[button] = pressed
+						if (!controllerInstance._hasListeners(type)) { continue }
+						event ??= { type, timestamp, button }
 						controllerInstance.emit(type, event)
 					}
 				} break
 
 				case 'steamHandleUpdate': {
+					const steamHandle = getExtra(offset)
 					for (const controllerInstance of collection.values()) {
-						controllerInstance._steamHandle = event.steamHandle
+						controllerInstance._steamHandle = steamHandle
+						if (!controllerInstance._hasListeners(type)) { continue }
+						event ??= { type, timestamp, steamHandle }
 						controllerInstance.emit(type, event)
 					}
 				} break
 
 				case 'remap': {
-					const { axes, buttons } = event
-					delete event.axes
-					delete event.buttons
-
+					const { axes, buttons } = getExtra(offset)
 					for (const controllerInstance of collection.values()) {
 						Object.assign(controllerInstance._axes, axes)
 						Object.assign(controllerInstance._buttons, buttons)
+						if (!controllerInstance._hasListeners(type)) { continue }
+						event ??= { type, timestamp }
 						controllerInstance.emit(type, event)
 					}
 				} break
@@ -335,15 +517,16 @@ const handleEvent = (event) => {
 		} break
 
 		case 'sensor': {
-			const { sensorId } = event
-			delete event.sensorId
-
-			const collection = Globals.sensorInstances.byId.get(sensorId)
+			const collection = Globals.sensorInstances.byId.get(id)
 			if (!collection) { return }
 
+			let event = null
+
 			switch (type) {
 				case 'update': {
 					for (const sensorInstance of collection.values()) {
+						if (!sensorInstance._hasListeners(type)) { continue }
+						event ??= { type, timestamp }
 						sensorInstance.emit(type, event)
 					}
 				} break
@@ -353,31 +536,33 @@ const handleEvent = (event) => {
 		} break
 
 		case 'audioDevice': {
-			const { audioDeviceType } = event
-			delete event.audioDeviceType
+			const audioDeviceType = records[data + 0] ? 'recording' : 'playback'
 
 			if (type === 'deviceRemove') {
-				const { audioId } = event
-				delete event.audioId
-
-				const audioInstance = Globals.audioInstances.get(audioId)
+				const audioInstance = Globals.audioInstances.get(id)
 				if (audioInstance) { audioInstance.close() }
-			}
 
-			const { devices } = event
-			delete event.devices
-
-			reconcileAudioDevices(devices, audioDeviceType)
+				reconcileAudioDevices(getExtra(offset), audioDeviceType)
+			} else {
+				addAudioDevice(getExtra(offset), audioDeviceType)
+			}
 		} break
 
 		case 'clipboard': {
-			clipboardModule.emit(type, event)
+			if (!clipboardModule._hasListeners(type)) { return }
+			clipboardModule.emit(type, { type, timestamp })
 		} break
 
 		// No default
 	}
 }
 
+const handleRecords = (start, end) => {
+	for (let i = start; i < end; i++) {
+		handleRecord(i * RECORD.size)
+	}
+}
+
 
 let polling = false
 
@@ -385,35 +570,74 @@ const poll = () => {
 	if (polling) { return }
 	polling = true
 
-	Bindings.events_poll(handleEvent)
-
-	polling = false
+	try {
+		let count
+		do {
+			count = Bindings.events_poll(records, extras, handleRecords)
+			handleRecords(0, count)
+			extras.length = 0
+		} while (count === CAPACITY)
+	}
+	finally {
+		extras.length = 0
+		polling = false
+	}
 }
 
+// While waiting, SDL and the connection watcher wake us up whenever events
+// arrive. The interval only keeps Node alive while there are listeners.
+const WAIT_INTERVAL = 1e3
+
 let pollInterval = null
+let pollMode = null
+let isActive = false
+let isPumping = false
+
+const setPollMode = (mode) => {
+	if (mode === pollMode) { return }
+	pollMode = mode
 
-const switchToPollingFast = () => {
 	clearInterval(pollInterval)
-	pollInterval = setInterval(poll, 0)
+	switch (mode) {
+		case 'fast': {
+			pollInterval = setInterval(poll, 0)
+		} break
+		case 'wait': {
+			pollInterval = setInterval(poll, WAIT_INTERVAL)
+		} break
+		case 'slow': {
+			pollInterval = setInterval(poll, 1e3)
+			pollInterval.unref()
+		} break
+		default: {
+			pollInterval = null
+		}
+	}
 }
 
-const switchToPollingSlow = () => {
-	clearInterval(pollInterval)
-	pollInterval = setInterval(poll, 1e3)
-	pollInterval.unref()
+const updatePolling = (active = isActive, pumping = isPumping) => {
+	isActive = active
+	isPumping = pumping
+
+	if (pollMode === 'stopped') { return }
+
+	setPollMode(!active ? 'slow'
+		: pumping || !Bindings.events_isWatching() ? 'fast'
+		: 'wait')
 }
 
 const stopPolling = () => {
-	clearInterval(pollInterval)
-	pollInterval = null
+	setPollMode('stopped')
+	Bindings.events_stopWatching()
 }
 
-switchToPollingSlow()
+updateFamilies()
+Bindings.events_startWatching(poll)
+updatePolling()
 poll()
 
 Globals.events = {
 	poll,
-	switchToPollingFast,
-	switchToPollingSlow,
+	updatePolling,
 	stopPolling,
 }
@@ -0,0 +1,68 @@
+const Bindings = require('../bindings')
+const Enums = require('../enums')
+
+const {
+	pumpToDispatch: PUMP_TO_DISPATCH,
+	dispatchToRender: DISPATCH_TO_RENDER,
+} = Enums.latencyKinds
+
+const CAPACITY = 256
+
+// Same clock as the timestamps on events
+const now = () => Number(process.hrtime.bigint()) / 1e6
+
+// Collects samples for a window and hands them to the native histograms in
+// batches. Events dispatched since the last render wait in `_pending` until
+// the next call to `window.render()`.
+class LatencyTracker {
+	constructor (windowId) {
+		this._windowId = windowId
+		this._dispatched = new Float64Array(CAPACITY)
+		this._dispatchedCount = 0
+		this._pending = new Float64Array(CAPACITY)
+		this._pendingCount = 0
+	}
+
+	dispatched (timestamp) {
+		const time = now()
+
+		if (this._dispatchedCount === CAPACITY) { this._flushDispatched() }
+		this._dispatched[this._dispatchedCount++] = time - timestamp
+
+		// If we fall this far behind, the oldest events are the ones that matter
+		if (this._pendingCount === CAPACITY) { return }
+		this._pending[this._pendingCount++] = time
+	}
+
+	rendered () {
+		if (this._pendingCount !== 0) {
+			const time = now()
+			for (let i = 0; i < this._pendingCount; i++) {
+				this._pending[i] = time - this._pending[i]
+			}
+			Bindings.events_addLatencySamples(this._windowId, DISPATCH_TO_RENDER, this._pending, this._pendingCount)
+			this._pendingCount = 0
+		}
+
+		this._flushDispatched()
+	}
+
+	getStats () {
+		this._flushDispatched()
+		return Bindings.events_getLatency(this._windowId)
+	}
+
+	reset () {
+		this._dispatchedCount = 0
+		this._pendingCount = 0
+		Bindings.events_resetLatency(this._windowId)
+	}
+
+	_flushDispatched () {
+		if (this._dispatchedCount === 0) { return }
+		Bindings.events_addLatencySamples(this._windowId, PUMP_TO_DISPATCH, this._dispatched, this._dispatchedCount)
+		this._dispatchedCount = 0
+	}
+}
+
+module.exports = { LatencyTracker }
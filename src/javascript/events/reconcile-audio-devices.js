@@ -1,5 +1,5 @@
 const Globals = require('../globals')
-const { reconcileDevices } = require('./reconcile')
+const { reconcileDevices, addDevice } = require('./reconcile')
 
 const { audio: audioModule } = require('../audio')
 const { compare: compareAudioDevice } = require('../audio/device')
@@ -13,4 +13,16 @@ const reconcileAudioDevices = (audioDevices, audioDeviceType) => {
 	)
 }
 
-module.exports = { reconcileAudioDevices }
+const addAudioDevice = (audioDevice, audioDeviceType) => {
+	addDevice(
+		audioModule,
+		Globals.audioDevices[audioDeviceType],
+		audioDevice,
+		compareAudioDevice,
+	)
+}
+
+module.exports = {
+	reconcileAudioDevices,
+	addAudioDevice,
+}
@@ -1,5 +1,5 @@
 const Globals = require('../globals')
-const { reconcileDevices } = require('./reconcile')
+const { reconcileDevices, addDevice, removeDevice } = require('./reconcile')
 
 const { joystick: joystickModule } = require('../joystick')
 const {
@@ -37,4 +37,32 @@ const reconcileJoystickAndControllerDevices = (devices) => {
 	)
 }
 
-module.exports = { reconcileJoystickAndControllerDevices }
+const addJoystickAndControllerDevice = (device) => {
+	addDevice(
+		joystickModule,
+		Globals.joystickDevices,
+		makeJoystickDevice(device),
+		compareJoystickDevice,
+	)
+
+	if (!filterControllerDevice(device)) { return }
+
+	addDevice(
+		controllerModule,
+		Globals.controllerDevices,
+		makeControllerDevice(device),
+		compareControllerDevice,
+	)
+}
+
+const removeJoystickAndControllerDevice = (id) => {
+	const predicate = (device) => device.id === id
+	removeDevice(joystickModule, Globals.joystickDevices, predicate)
+	removeDevice(controllerModule, Globals.controllerDevices, predicate)
+}
+
+module.exports = {
+	reconcileJoystickAndControllerDevices,
+	addJoystickAndControllerDevice,
+	removeJoystickAndControllerDevice,
+}
@@ -58,4 +58,46 @@ const reconcileDevices = (
 	}
 }
 
-module.exports = { reconcileDevices }
+// Applies a single added device to a list that is kept sorted. New devices
+// usually sort last, so the search starts from the end.
+const addDevice = (
+	emitter,
+	mainList,
+	device,
+	compare,
+	prefix = 'device',
+) => {
+	let index = mainList.length
+	while (index > 0 && compare(mainList[index - 1], device) > 0) { index-- }
+
+	if (index > 0 && compare(mainList[index - 1], device) === 0) {
+		Object.assign(mainList[index - 1], device)
+		return
+	}
+
+	mainList.splice(index, 0, device)
+	const type = `${prefix}Add`
+	const event = { type, device }
+	emitter.emit(type, event)
+}
+
+const removeDevice = (
+	emitter,
+	mainList,
+	predicate,
+	prefix = 'device',
+) => {
+	const index = mainList.findIndex(predicate)
+	if (index === -1) { return }
+
+	const [ device ] = mainList.splice(index, 1)
+	const type = `${prefix}Remove`
+	const event = { type, device }
+	emitter.emit(type, event)
+}
+
+module.exports = {
+	reconcileDevices,
+	addDevice,
+	removeDevice,
+}
@@ -15,6 +15,8 @@ const { sensor } = require('./sensor')
 const { audio } = require('./audio')
 const { clipboard } = require('./clipboard')
 const { power } = require('./power')
+const { pixels } = require('./pixels')
+const { events } = require('./events/events-module')
 
 require('./events')
 require('./cleanup')
@@ -31,4 +33,6 @@ module.exports = {
 	audio,
 	clipboard,
 	power,
+	pixels,
+	events,
 }
@@ -4,24 +4,30 @@ const { EventsViaPoll } = require('../events/events-via-poll')
 const { JoystickInstance } = require('./joystick-instance')
 
 
-const { make: makeJoystickDevice } = require('./device')
+const {
+	make: makeJoystickDevice,
+	compare: compareJoystickDevice,
+} = require('./device')
 const {
 	make: makeControllerDevice,
+	compare: compareControllerDevice,
 	filter: filterControllerDevice,
 } = require('../controller/device')
 
 const devices = Bindings.joystick_getDevices()
 Globals.joystickDevices = devices
 	.map(makeJoystickDevice)
+	.sort(compareJoystickDevice)
 Globals.controllerDevices = devices
 	.filter(filterControllerDevice)
 	.map(makeControllerDevice)
+	.sort(compareControllerDevice)
 
 
 const validEvents = [ 'deviceAdd', 'deviceRemove' ]
 
 const joystick = new class extends EventsViaPoll {
-	constructor () { super(validEvents) }
+	constructor () { super(validEvents, { pumping: true }) }
 
 	get devices () {
 		Globals.events.poll()
@@ -1,6 +1,7 @@
 const Globals = require('../globals')
 const Bindings = require('../bindings')
-const { EventsViaPoll } = require('../events/events-via-poll')
+const Enums = require('../enums')
+const { EventsViaPoll, retainFamily, releaseFamily } = require('../events/events-via-poll')
 
 const validEvents = [
 	'axisMotion',
@@ -14,11 +15,11 @@ const validEvents = [
 
 class JoystickInstance extends EventsViaPoll {
 	constructor (device) {
-		super(validEvents)
+		super(validEvents, { pumping: true })
 
 		if (!Globals.joystickDevices.includes(device)) { throw Object.assign(new Error("invalid device"), { device }) }
 
-		const result = Bindings.joystick_open(device._index)
+		const result = Bindings.joystick_open(device.id)
 
 		this._firmwareVersion = result.firmwareVersion
 		this._serialNumber = result.serialNumber
@@ -35,8 +36,12 @@ class JoystickInstance extends EventsViaPoll {
 
 		this._rumbleTimeout = null
 		this._rumbleTriggersTimeout = null
+		this._coalesceAxisMotion = false
 		this._closed = false
 
+		// Instances keep their state up to date even without listeners
+		retainFamily('joystick')
+
 		Globals.joystickInstances.all.add(this)
 		let collection = Globals.joystickInstances.byId.get(this._device.id)
 		if (!collection) {
@@ -149,6 +154,30 @@ class JoystickInstance extends EventsViaPoll {
 		Globals.events.poll()
 	}
 
+	get coalesceAxisMotion () { return this._coalesceAxisMotion }
+	setCoalesceAxisMotion (coalesceAxisMotion) {
+		if (this._closed) { throw Object.assign(new Error("instance is closed"), { id: this._device.id }) }
+
+		if (typeof coalesceAxisMotion !== 'boolean') { throw Object.assign(new Error("coalesceAxisMotion must be a boolean"), { coalesceAxisMotion }) }
+
+		this._coalesceAxisMotion = coalesceAxisMotion
+		this._updateCoalescing()
+	}
+
+	_updateCoalescing () {
+		const collection = Globals.joystickInstances.byId.get(this._device.id)
+		let enabled = false
+		if (collection) {
+			for (const instance of collection) {
+				if (instance._coalesceAxisMotion) {
+					enabled = true
+					break
+				}
+			}
+		}
+		Bindings.events_setCoalescing(Enums.eventFamilies.joystick, this._device.id, enabled)
+	}
+
 	get closed () { return this._closed }
 	close () {
 		if (this._closed) { throw Object.assign(new Error("instance is closed"), { id: this._device.id }) }
@@ -157,9 +186,12 @@ class JoystickInstance extends EventsViaPoll {
 		this.removeAllListeners()
 		this._closed = true
 
+		releaseFamily('joystick')
+
 		Globals.joystickInstances.all.delete(this)
 		const collection = Globals.joystickInstances.byId.get(this._device.id)
 		collection.delete(this)
+		if (this._coalesceAxisMotion) { this._updateCoalescing() }
 		if (collection.size === 0) {
 			Bindings.joystick_close(this._device.id)
 			Globals.joystickInstances.byId.delete(this._device.id)
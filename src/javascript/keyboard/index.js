@@ -7,7 +7,7 @@ const { mapping, reverseMapping } = require('./key-mapping')
 const validEvents = [ 'keymapChange' ]
 
 const keyboard = new class extends EventsViaPoll {
-	constructor () { super(validEvents) }
+	constructor () { super(validEvents, { families: { keymapChange: 'keymap' } }) }
 
 	get SCANCODE () { return Enums.scancodes }
 
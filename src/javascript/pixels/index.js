@@ -0,0 +1,224 @@
+const Bindings = require('../bindings')
+const Enums = require('../enums')
+
+const validateImage = (width, height, stride, format, buffer) => {
+	if (!Number.isInteger(width)) { throw Object.assign(new Error("width must be an integer"), { width }) }
+	if (width <= 0) { throw Object.assign(new Error("invalid width"), { width }) }
+	if (!Number.isInteger(height)) { throw Object.assign(new Error("height must be an integer"), { height }) }
+	if (height <= 0) { throw Object.assign(new Error("invalid height"), { height }) }
+	if (typeof format !== 'string') { throw Object.assign(new Error("format must be a string"), { format }) }
+
+	const _format = Enums.pixelFormat[format]
+	if (_format === undefined) { throw Object.assign(new Error("invalid format"), { format }) }
+	const bytesPerPixel = Enums.pixelFormatBytes[format]
+	if (bytesPerPixel === undefined) { throw Object.assign(new Error("yuv formats are not supported"), { format }) }
+
+	if (!Number.isInteger(stride)) { throw Object.assign(new Error("stride must be an integer"), { stride }) }
+	if (stride < width * bytesPerPixel) { throw Object.assign(new Error("invalid stride"), { stride, width }) }
+	if (!(buffer instanceof Buffer)) { throw Object.assign(new Error("buffer must be a Buffer"), { buffer }) }
+	if (buffer.length < stride * height) { throw Object.assign(new Error("buffer is smaller than expected"), { buffer, stride, height }) }
+
+	return { _format, bytesPerPixel }
+}
+
+// The compositing functions take whole images, like the ones returned by
+// convert() and scale(). They only work on 32-bit formats.
+const validateImageObject = (image, name) => {
+	if (typeof image !== 'object' || image === null) { throw Object.assign(new Error(`${name} must be an object`), { [name]: image }) }
+	const { width, height, stride, format, buffer } = image
+	const { _format, bytesPerPixel } = validateImage(width, height, stride, format, buffer)
+	if (bytesPerPixel !== 4 || format === 'argb2101010') { throw Object.assign(new Error("only 32-bit formats with 8 bits per channel are supported"), { format }) }
+	return _format
+}
+
+const validateRect = (rect, name) => {
+	if (typeof rect !== 'object' || rect === null) { throw Object.assign(new Error(`${name} must be an object`), { [name]: rect }) }
+	if (!Number.isInteger(rect.x)) { throw Object.assign(new Error(`${name}.x must be an integer`), { [name]: rect }) }
+	if (!Number.isInteger(rect.y)) { throw Object.assign(new Error(`${name}.y must be an integer`), { [name]: rect }) }
+	if (!Number.isInteger(rect.width)) { throw Object.assign(new Error(`${name}.width must be an integer`), { [name]: rect }) }
+	if (rect.width < 0) { throw Object.assign(new Error(`invalid ${name}.width`), { [name]: rect }) }
+	if (!Number.isInteger(rect.height)) { throw Object.assign(new Error(`${name}.height must be an integer`), { [name]: rect }) }
+	if (rect.height < 0) { throw Object.assign(new Error(`invalid ${name}.height`), { [name]: rect }) }
+}
+
+const validatePosition = (x, y) => {
+	if (!Number.isInteger(x)) { throw Object.assign(new Error("x must be an integer"), { x }) }
+	if (!Number.isInteger(y)) { throw Object.assign(new Error("y must be an integer"), { y }) }
+}
+
+// Clips the copy of srcRect to (x, y) against both images. Returns null if
+// nothing is left.
+const clip = (dst, src, x, y, srcRect) => {
+	let { x: srcX, y: srcY, width, height } = srcRect ?? { x: 0, y: 0, width: src.width, height: src.height }
+
+	if (srcX < 0) { x -= srcX; width += srcX; srcX = 0 }
+	if (srcY < 0) { y -= srcY; height += srcY; srcY = 0 }
+	width = Math.min(width, src.width - srcX)
+	height = Math.min(height, src.height - srcY)
+
+	if (x < 0) { srcX -= x; width += x; x = 0 }
+	if (y < 0) { srcY -= y; height += y; y = 0 }
+	width = Math.min(width, dst.width - x)
+	height = Math.min(height, dst.height - y)
+
+	if (width <= 0 || height <= 0) { return null }
+	return { x, y, srcX, srcY, width, height }
+}
+
+const validateCopyOptions = (options) => {
+	const {
+		x = 0,
+		y = 0,
+		srcRect = null,
+		async = false,
+	} = options
+
+	validatePosition(x, y)
+	if (srcRect !== null) { validateRect(srcRect, 'srcRect') }
+	if (typeof async !== 'boolean') { throw Object.assign(new Error("async must be a boolean"), { async }) }
+
+	return { x, y, srcRect, async }
+}
+
+const pixels = {
+	convert (width, height, stride, format, buffer, dstFormat, options = {}) {
+		const { _format } = validateImage(width, height, stride, format, buffer)
+
+		if (typeof dstFormat !== 'string') { throw Object.assign(new Error("dstFormat must be a string"), { dstFormat }) }
+		const _dstFormat = Enums.pixelFormat[dstFormat]
+		if (_dstFormat === undefined) { throw Object.assign(new Error("invalid dstFormat"), { dstFormat }) }
+		const dstBytesPerPixel = Enums.pixelFormatBytes[dstFormat]
+		if (dstBytesPerPixel === undefined) { throw Object.assign(new Error("yuv formats are not supported"), { dstFormat }) }
+
+		const { stride: dstStride = width * dstBytesPerPixel } = options
+		if (!Number.isInteger(dstStride)) { throw Object.assign(new Error("stride must be an integer"), { stride: dstStride }) }
+		if (dstStride < width * dstBytesPerPixel) { throw Object.assign(new Error("invalid stride"), { stride: dstStride, width }) }
+		const { buffer: dstBuffer = Buffer.alloc(dstStride * height) } = options
+
+		validateImage(width, height, dstStride, dstFormat, dstBuffer)
+
+		Bindings.pixels_convert(width, height, stride, _format, buffer, dstStride, _dstFormat, dstBuffer)
+
+		return { width, height, stride: dstStride, format: dstFormat, buffer: dstBuffer }
+	},
+
+	scale (width, height, stride, format, buffer, dstWidth, dstHeight, options = {}) {
+		const { bytesPerPixel } = validateImage(width, height, stride, format, buffer)
+
+		if (!Number.isInteger(dstWidth)) { throw Object.assign(new Error("dstWidth must be an integer"), { dstWidth }) }
+		if (dstWidth <= 0) { throw Object.assign(new Error("invalid dstWidth"), { dstWidth }) }
+		if (!Number.isInteger(dstHeight)) { throw Object.assign(new Error("dstHeight must be an integer"), { dstHeight }) }
+		if (dstHeight <= 0) { throw Object.assign(new Error("invalid dstHeight"), { dstHeight }) }
+
+		const {
+			scaling = 'nearest',
+			stride: dstStride = dstWidth * bytesPerPixel,
+		} = options
+		if (!Number.isInteger(dstStride)) { throw Object.assign(new Error("stride must be an integer"), { stride: dstStride }) }
+		if (dstStride < dstWidth * bytesPerPixel) { throw Object.assign(new Error("invalid stride"), { stride: dstStride, width: dstWidth }) }
+		const { buffer: dstBuffer = Buffer.alloc(dstStride * dstHeight) } = options
+
+		if (scaling !== 'nearest' && scaling !== 'linear') { throw Object.assign(new Error("invalid scaling"), { scaling }) }
+		// Linear scaling blends each byte on its own
+		if (scaling === 'linear' && (bytesPerPixel < 3 || format === 'argb2101010')) { throw Object.assign(new Error("linear scaling needs 8 bits per channel"), { format }) }
+
+		validateImage(dstWidth, dstHeight, dstStride, format, dstBuffer)
+
+		Bindings.pixels_scale(width, height, stride, Enums.pixelFormat[format], buffer, dstWidth, dstHeight, dstStride, dstBuffer, scaling === 'linear')
+
+		return { width: dstWidth, height: dstHeight, stride: dstStride, format, buffer: dstBuffer }
+	},
+
+	blit (dst, src, options = {}) {
+		const _dstFormat = validateImageObject(dst, 'dst')
+		const _srcFormat = validateImageObject(src, 'src')
+		const { x, y, srcRect, async } = validateCopyOptions(options)
+
+		const rect = clip(dst, src, x, y, srcRect)
+		if (!rect) { return async ? Promise.resolve() : undefined }
+
+		return Bindings.compositing_copy(
+			dst.buffer, dst.stride, _dstFormat, rect.x, rect.y,
+			src.buffer, src.stride, _srcFormat, rect.srcX, rect.srcY,
+			rect.width, rect.height,
+			async,
+		)
+	},
+
+	copyRect (image, srcRect, x, y, options = {}) {
+		const _format = validateImageObject(image, 'image')
+		validateRect(srcRect, 'srcRect')
+		validatePosition(x, y)
+
+		const { async = false } = options
+		if (typeof async !== 'boolean') { throw Object.assign(new Error("async must be a boolean"), { async }) }
+
+		const rect = clip(image, image, x, y, srcRect)
+		if (!rect) { return async ? Promise.resolve() : undefined }
+
+		return Bindings.compositing_copy(
+			image.buffer, image.stride, _format, rect.x, rect.y,
+			image.buffer, image.stride, _format, rect.srcX, rect.srcY,
+			rect.width, rect.height,
+			async,
+		)
+	},
+
+	blend (dst, src, options = {}) {
+		const _format = validateImageObject(dst, 'dst')
+		if (validateImageObject(src, 'src') !== _format) { throw Object.assign(new Error("src and dst must have the same format"), { src: src.format, dst: dst.format }) }
+		const { x, y, srcRect, async } = validateCopyOptions(options)
+
+		const {
+			alpha = 'straight',
+			opacity = 1,
+		} = options
+		if (alpha !== 'straight' && alpha !== 'premultiplied') { throw Object.assign(new Error("invalid alpha"), { alpha }) }
+		if (typeof opacity !== 'number') { throw Object.assign(new Error("opacity must be a number"), { opacity }) }
+		if (!(opacity >= 0 && opacity <= 1)) { throw Object.assign(new Error("invalid opacity"), { opacity }) }
+
+		const rect = clip(dst, src, x, y, srcRect)
+		if (!rect) { return async ? Promise.resolve() : undefined }
+
+		return Bindings.compositing_blend(
+			dst.buffer, dst.stride, rect.x, rect.y,
+			src.buffer, src.stride, rect.srcX, rect.srcY,
+			rect.width, rect.height,
+			_format,
+			alpha === 'premultiplied',
+			Math.round(opacity * 255),
+			async,
+		)
+	},
+
+	fillRect (dst, rect, color, options = {}) {
+		const _format = validateImageObject(dst, 'dst')
+		if (rect !== null) { validateRect(rect, 'rect') }
+
+		if (typeof color !== 'object' || color === null) { throw Object.assign(new Error("color must be an object"), { color }) }
+		const { r, g, b, a = 255 } = color
+		for (const value of [ r, g, b, a ]) {
+			if (!Number.isInteger(value)) { throw Object.assign(new Error("color components must be integers"), { color }) }
+			if (value < 0 || value > 255) { throw Object.assign(new Error("invalid color"), { color }) }
+		}
+
+		const { async = false } = options
+		if (typeof async !== 'boolean') { throw Object.assign(new Error("async must be a boolean"), { async }) }
+
+		const { x, y, width, height } = rect ?? { x: 0, y: 0, width: dst.width, height: dst.height }
+		const left = Math.max(x, 0)
+		const top = Math.max(y, 0)
+		const right = Math.min(x + width, dst.width)
+		const bottom = Math.min(y + height, dst.height)
+		if (right <= left || bottom <= top) { return async ? Promise.resolve() : undefined }
+
+		return Bindings.compositing_fill(
+			dst.buffer, dst.stride, _format,
+			left, top, right - left, bottom - top,
+			r, g, b, a,
+			async,
+		)
+	},
+}
+
+module.exports = { pixels }
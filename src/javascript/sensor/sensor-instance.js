@@ -9,7 +9,7 @@ const validEvents = [
 
 class SensorInstance extends EventsViaPoll {
 	constructor (device) {
-		super(validEvents)
+		super(validEvents, { pumping: true, families: { update: 'sensor' } })
 
 		if (!Globals.sensorDevices.includes(device)) { throw Object.assign(new Error("invalid device"), { device }) }
 
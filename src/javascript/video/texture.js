@@ -0,0 +1,90 @@
+const Bindings = require('../bindings')
+const Enums = require('../enums')
+
+class Texture {
+	constructor (window, id, width, height, format, target) {
+		this._window = window
+		this._id = id
+		this._width = width
+		this._height = height
+		this._format = format
+		this._target = target
+		this._destroyed = false
+	}
+
+	get id () { return this._id }
+	get window () { return this._window }
+	get width () { return this._width }
+	get height () { return this._height }
+	get format () { return this._format }
+	get target () { return this._target }
+
+	update (buffer, stride, rect = null) {
+		if (this._destroyed) { throw Object.assign(new Error("texture is destroyed"), { id: this._id }) }
+
+		if (this._window._renderThread) { throw new Error("can't call update with asyncRender") }
+
+		if (!(buffer instanceof Buffer)) { throw Object.assign(new Error("buffer must be a Buffer"), { buffer }) }
+		if (!Number.isInteger(stride)) { throw Object.assign(new Error("stride must be an integer"), { stride }) }
+
+		let width = this._width
+		let height = this._height
+		if (rect !== null) {
+			if (typeof rect !== 'object') { throw Object.assign(new Error("rect must be an object"), { rect }) }
+			if (!Number.isInteger(rect.x)) { throw Object.assign(new Error("rect.x must be an integer"), { rect }) }
+			if (!Number.isInteger(rect.y)) { throw Object.assign(new Error("rect.y must be an integer"), { rect }) }
+			if (!Number.isInteger(rect.width)) { throw Object.assign(new Error("rect.width must be an integer"), { rect }) }
+			if (!Number.isInteger(rect.height)) { throw Object.assign(new Error("rect.height must be an integer"), { rect }) }
+			if (rect.x < 0 || rect.width <= 0 || rect.x + rect.width > this._width) { throw Object.assign(new Error("rect is out of bounds"), { rect }) }
+			if (rect.y < 0 || rect.height <= 0 || rect.y + rect.height > this._height) { throw Object.assign(new Error("rect is out of bounds"), { rect }) }
+			width = rect.width
+			height = rect.height
+		}
+
+		const bytesPerPixel = Enums.pixelFormatBytes[this._format]
+		if (bytesPerPixel === undefined) { throw Object.assign(new Error("yuv formats are not supported"), { format: this._format }) }
+		if (stride < width * bytesPerPixel) { throw Object.assign(new Error("invalid stride"), { stride, width }) }
+		if (buffer.length < (height - 1) * stride + width * bytesPerPixel) { throw Object.assign(new Error("buffer is smaller than expected"), { buffer, stride, height }) }
+
+		Bindings.texture_update(this._id, stride, buffer, rect)
+	}
+
+	readPixels (rect = null) {
+		if (this._destroyed) { throw Object.assign(new Error("texture is destroyed"), { id: this._id }) }
+
+		if (!this._target) { throw new Error("texture is not a render target") }
+		if (this._window._renderThread) { throw new Error("can't call readPixels with asyncRender") }
+
+		let width = this._width
+		let height = this._height
+		if (rect !== null) {
+			if (typeof rect !== 'object') { throw Object.assign(new Error("rect must be an object"), { rect }) }
+			if (!Number.isInteger(rect.x)) { throw Object.assign(new Error("rect.x must be an integer"), { rect }) }
+			if (!Number.isInteger(rect.y)) { throw Object.assign(new Error("rect.y must be an integer"), { rect }) }
+			if (!Number.isInteger(rect.width)) { throw Object.assign(new Error("rect.width must be an integer"), { rect }) }
+			if (!Number.isInteger(rect.height)) { throw Object.assign(new Error("rect.height must be an integer"), { rect }) }
+			if (rect.x < 0 || rect.width <= 0 || rect.x + rect.width > this._width) { throw Object.assign(new Error("rect is out of bounds"), { rect }) }
+			if (rect.y < 0 || rect.height <= 0 || rect.y + rect.height > this._height) { throw Object.assign(new Error("rect is out of bounds"), { rect }) }
+			width = rect.width
+			height = rect.height
+		}
+
+		const { buffer, stride } = Bindings.texture_readPixels(this._id, rect)
+		return { width, height, stride, format: this._format, buffer }
+	}
+
+	get destroyed () { return this._destroyed }
+	destroy () {
+		if (this._destroyed) { return }
+
+		if (this._window._renderThread) { throw new Error("can't call destroy with asyncRender") }
+
+		this._window._textures.delete(this)
+		// SDL switches back to drawing to the window
+		if (this._window._renderTarget === this) { this._window._renderTarget = null }
+		Bindings.texture_destroy(this._id)
+		this._destroyed = true
+	}
+}
+
+module.exports = { Texture }
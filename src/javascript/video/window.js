@@ -2,6 +2,8 @@ const Globals = require('../globals')
 const Bindings = require('../bindings')
 const Enums = require('../enums')
 const { EventsViaPoll } = require('../events/events-via-poll')
+const { LatencyTracker } = require('../events/latency-tracker')
+const { Texture } = require('./texture')
 
 const validEvents = [
 	'show',
@@ -33,11 +35,71 @@ const validEvents = [
 	'dropText',
 	'dropFile',
 	'dropComplete',
+	'framePresented',
 ]
 
+const families = {
+	keyDown: 'keyboard',
+	keyUp: 'keyboard',
+	textInput: 'text',
+	mouseButtonDown: 'mouse',
+	mouseButtonUp: 'mouse',
+	mouseMove: 'mouse',
+	mouseWheel: 'mouse',
+	fingerDown: 'touch',
+	fingerUp: 'touch',
+	fingerMove: 'touch',
+	dropBegin: 'drop',
+	dropText: 'drop',
+	dropFile: 'drop',
+	dropComplete: 'drop',
+}
+
+// Each vertex is x, y, a packed RGBA color, u, v
+const VERTEX_FLOATS = 5
+
+const validatePresentOptions = (scaling, dstRect) => {
+	if (scaling !== undefined && typeof scaling !== 'string') { throw Object.assign(new Error("scaling must be a string"), { scaling }) }
+
+	if (dstRect !== null) {
+		if (typeof dstRect !== 'object') { throw Object.assign(new Error("dstRect must be an object"), { dstRect }) }
+		if (!Number.isInteger(dstRect.x)) { throw Object.assign(new Error("dstRect.x must be an integer"), { dstRect }) }
+		if (!Number.isInteger(dstRect.y)) { throw Object.assign(new Error("dstRect.y must be an integer"), { dstRect }) }
+		if (!Number.isInteger(dstRect.width)) { throw Object.assign(new Error("dstRect.width must be an integer"), { dstRect }) }
+		if (dstRect.width <= 0) { throw Object.assign(new Error("invalid dstRect.width"), { dstRect }) }
+		if (!Number.isInteger(dstRect.height)) { throw Object.assign(new Error("dstRect.height must be an integer"), { dstRect }) }
+		if (dstRect.height <= 0) { throw Object.assign(new Error("invalid dstRect.height"), { dstRect }) }
+	}
+
+	const _scaling = Enums.scaleMode[scaling]
+	if (_scaling === undefined) { throw Object.assign(new Error("invalid scaling"), { scaling }) }
+	return _scaling
+}
+
+const validatePlane = (name, buffer, stride, width, height) => {
+	if (!(buffer instanceof Buffer)) { throw Object.assign(new Error(`${name} must be a Buffer`), { [name]: buffer }) }
+	if (!Number.isInteger(stride)) { throw Object.assign(new Error(`${name} stride must be an integer`), { stride }) }
+	if (stride < width) { throw Object.assign(new Error(`invalid ${name} stride`), { stride, width }) }
+	if (buffer.length < stride * height) { throw Object.assign(new Error(`${name} is smaller than expected`), { [name]: buffer, stride, height }) }
+}
+
+const validateFrameSize = (width, height) => {
+	if (!Number.isInteger(width)) { throw Object.assign(new Error("width must be an integer"), { width }) }
+	if (width <= 0) { throw Object.assign(new Error("invalid width"), { width }) }
+	if (!Number.isInteger(height)) { throw Object.assign(new Error("height must be an integer"), { height }) }
+	if (height <= 0) { throw Object.assign(new Error("invalid height"), { height }) }
+}
+
+const validateConversion = (conversion) => {
+	if (typeof conversion !== 'string') { throw Object.assign(new Error("conversion must be a string"), { conversion }) }
+	const _conversion = Enums.yuvConversionMode[conversion]
+	if (_conversion === undefined) { throw Object.assign(new Error("invalid conversion"), { conversion }) }
+	return _conversion
+}
+
 class Window extends EventsViaPoll {
 	constructor (options = {}) {
-		super(validEvents)
+		super(validEvents, { families })
 
 		const {
 			title = "",
@@ -53,10 +115,13 @@ class Window extends EventsViaPoll {
 			vsync = true,
 			opengl = false,
 			webgpu = false,
+			renderDriver = null,
+			renderBatching = true,
 			skipTaskbar = false,
 			popupMenu = false,
 			tooltip = false,
 			utility = false,
+			coalesceMotion = false,
 		} = options
 
 		if (typeof title !== 'string') { throw Object.assign(new Error("title must be a string"), { title }) }
@@ -80,13 +145,17 @@ class Window extends EventsViaPoll {
 		if (typeof vsync !== 'boolean') { throw Object.assign(new Error("vsync must be a boolean"), { vsync }) }
 		if (typeof opengl !== 'boolean') { throw Object.assign(new Error("opengl must be a boolean"), { opengl }) }
 		if (typeof webgpu !== 'boolean') { throw Object.assign(new Error("webgpu must be a boolean"), { webgpu }) }
+		if (renderDriver !== null && typeof renderDriver !== 'string') { throw Object.assign(new Error("renderDriver must be a string"), { renderDriver }) }
+		if (typeof renderBatching !== 'boolean') { throw Object.assign(new Error("renderBatching must be a boolean"), { renderBatching }) }
 		if (typeof skipTaskbar !== 'boolean') { throw Object.assign(new Error("skipTaskbar must be a boolean"), { skipTaskbar }) }
 		if (typeof popupMenu !== 'boolean') { throw Object.assign(new Error("popupMenu must be a boolean"), { popupMenu }) }
 		if (typeof tooltip !== 'boolean') { throw Object.assign(new Error("tooltip must be a boolean"), { tooltip }) }
 		if (typeof utility !== 'boolean') { throw Object.assign(new Error("utility must be a boolean"), { utility }) }
+		if (typeof coalesceMotion !== 'boolean') { throw Object.assign(new Error("coalesceMotion must be a boolean"), { coalesceMotion }) }
 		if (display !== null && (x !== null || y !== null)) { throw Object.assign(new Error("display and x/y are mutually exclusive"), { display, x, y }) }
 		if (resizable && borderless) { throw Object.assign(new Error("resizable and borderless are mutually exclusive"), { resizable, borderless }) }
 		if (opengl && webgpu) { throw Object.assign(new Error("opengl and webgpu are mutually exclusive"), { opengl, webgpu }) }
+		if ((opengl || webgpu) && renderDriver !== null) { throw Object.assign(new Error("renderDriver can't be used with opengl or webgpu"), { renderDriver, opengl, webgpu }) }
 
 		let displayIndex = 0
 		if (display) {
@@ -116,9 +185,12 @@ class Window extends EventsViaPoll {
 			popupMenu,
 			tooltip,
 			utility,
+			renderDriver,
+			renderBatching,
 		)
 
 		this._id = result.id
+		this._handle = result.handle
 		this._x = result.x
 		this._y = result.y
 		this._width = result.width
@@ -132,6 +204,7 @@ class Window extends EventsViaPoll {
 		this._alwaysOnTop = result.alwaysOnTop
 		this._accelerated = result.accelerated
 		this._vsync = result.vsync
+		this._renderer = result.renderer
 		this._native = result.native
 		this._skipTaskbar = result.skipTaskbar
 		this._popupMenu = result.popupMenu
@@ -142,6 +215,16 @@ class Window extends EventsViaPoll {
 		this._visible = visible
 		this._opengl = opengl
 		this._webgpu = webgpu
+		this._coalesceMotion = false
+		this._latencyTracker = null
+		this._lockedPixels = null
+		this._damage = null
+		this._renderThread = null
+		this._textures = new Set()
+		this._renderTarget = null
+		this._frameCapture = null
+		this._capture = null
+		this._frameStarted = false
 
 		this._minimized = false
 		this._maximized = false
@@ -149,12 +232,24 @@ class Window extends EventsViaPoll {
 
 		Globals.windows.all.set(this._id, this)
 
+		if (coalesceMotion) { this.setCoalesceMotion(true) }
+
+		// Creating the first window might have made it possible to wait for events
+		Globals.events.updatePolling()
+
 		// This also keeps Node.js alive while windows are open
 		this.on('close', () => {
 			if (Globals.windows.hovered === this) { Globals.windows.hovered = null }
 			if (Globals.windows.focused === this) { Globals.windows.focused = null }
 
-			Bindings.window_destroy(this._id)
+			if (this._coalesceMotion) { Bindings.events_setCoalescing(Enums.eventFamilies.window, this._id, false) }
+			if (this._latencyTracker) { this._latencyTracker.reset() }
+			this._lockedPixels = null
+			if (this._renderThread) { this._stopRenderThread() }
+			// Destroying the window also flushes and closes the capture
+			this._capture = null
+			this._forgetTextures()
+			Bindings.window_destroy(this._handle)
 			this._destroyed = true
 
 			Globals.windows.all.delete(this._id)
@@ -182,7 +277,7 @@ class Window extends EventsViaPoll {
 
 		if (typeof title !== 'string') { throw Object.assign(new Error("title must be a string"), { title }) }
 
-		Bindings.window_setTitle(this._id, title)
+		Bindings.window_setTitle(this._handle, title)
 		this._title = title
 	}
 
@@ -194,7 +289,7 @@ class Window extends EventsViaPoll {
 		if (!Number.isInteger(x)) { throw Object.assign(new Error("x must be an integer"), { x }) }
 		if (!Number.isInteger(y)) { throw Object.assign(new Error("y must be an integer"), { y }) }
 
-		Bindings.window_setPosition(this._id, x, y)
+		Bindings.window_setPosition(this._handle, x, y)
 		this._x = x
 		this._y = y
 	}
@@ -209,7 +304,7 @@ class Window extends EventsViaPoll {
 		if (!Number.isInteger(height)) { throw Object.assign(new Error("height must be an integer"), { height }) }
 		if (height <= 0) { throw Object.assign(new Error("invalid height"), { height }) }
 
-		const { pixelWidth, pixelHeight } = Bindings.window_setSize(this._id, width, height)
+		const { pixelWidth, pixelHeight } = Bindings.window_setSize(this._handle, width, height)
 		this._width = Math.floor(width)
 		this._height = Math.floor(height)
 		this._pixelWidth = pixelWidth
@@ -232,7 +327,7 @@ class Window extends EventsViaPoll {
 		if (!Number.isInteger(width)) { throw Object.assign(new Error(`pixelWidth must be a multiple of ${xRatio}`), { pixelWidth }) }
 		if (!Number.isInteger(height)) { throw Object.assign(new Error(`pixelWidth must be a multiple of ${yRatio}`), { pixelWidth }) }
 
-		Bindings.window_setSize(this._id, width, height)
+		Bindings.window_setSize(this._handle, width, height)
 		this._width = width
 		this._height = height
 		this._pixelWidth = pixelWidth
@@ -252,7 +347,7 @@ class Window extends EventsViaPoll {
 
 		if (typeof show !== 'boolean') { throw Object.assign(new Error("show must be a boolean"), { show }) }
 
-		show ? Bindings.window_show(this._id) : Bindings.window_hide(this._id)
+		show ? Bindings.window_show(this._handle) : Bindings.window_hide(this._handle)
 		this._visible = show
 	}
 
@@ -264,7 +359,7 @@ class Window extends EventsViaPoll {
 
 		if (typeof fullscreen !== 'boolean') { throw Object.assign(new Error("fullscreen must be a boolean"), { fullscreen }) }
 
-		this._fullscreen = Bindings.window_setFullscreen(this._id, fullscreen)
+		this._fullscreen = Bindings.window_setFullscreen(this._handle, fullscreen)
 	}
 
 	get resizable () { return this._resizable }
@@ -273,7 +368,7 @@ class Window extends EventsViaPoll {
 
 		if (typeof resizable !== 'boolean') { throw Object.assign(new Error("resizable must be a boolean"), { resizable }) }
 
-		this._resizable = Bindings.window_setResizable(this._id, resizable)
+		this._resizable = Bindings.window_setResizable(this._handle, resizable)
 	}
 
 	get borderless () { return this._borderless }
@@ -282,7 +377,7 @@ class Window extends EventsViaPoll {
 
 		if (typeof borderless !== 'boolean') { throw Object.assign(new Error("borderless must be a boolean"), { borderless }) }
 
-		this._borderless = Bindings.window_setBorderless(this._id, borderless)
+		this._borderless = Bindings.window_setBorderless(this._handle, borderless)
 	}
 
 	get alwaysOnTop () { return this._alwaysOnTop }
@@ -296,9 +391,17 @@ class Window extends EventsViaPoll {
 
 		if (typeof accelerated !== 'boolean') { throw Object.assign(new Error("accelerated must be a boolean"), { accelerated }) }
 
-		const result = Bindings.window_setAcceleratedAndVsync(this._id, accelerated, this._vsync)
+		// Recreating the renderer also unlocks the texture and destroys all textures
+		this._lockedPixels = null
+		const renderThread = this._renderThread
+		if (renderThread) { this._stopRenderThread() }
+		this._forgetTextures()
+		const result = Bindings.window_setAcceleratedAndVsync(this._handle, accelerated, this._vsync)
 		this._accelerated = result.accelerated
 		this._vsync = result.vsync
+		this._renderer = result.renderer
+		if (renderThread) { this._startRenderThread(renderThread) }
+		if (this._frameCapture) { this._startFrameCapture(this._frameCapture) }
 	}
 
 	get vsync () { return this._vsync }
@@ -310,11 +413,30 @@ class Window extends EventsViaPoll {
 
 		if (typeof vsync !== 'boolean') { throw Object.assign(new Error("vsync must be a boolean"), { vsync }) }
 
-		const result = Bindings.window_setAcceleratedAndVsync(this._id, this._accelerated, vsync)
-		this._accelerated = result.accelerated
-		this._vsync = result.vsync
+		const renderThread = this._renderThread
+		if (renderThread) { this._stopRenderThread() }
+
+		// Switching in place keeps the renderer and its textures
+		const actual = Bindings.window_setVsync(this._handle, vsync)
+		if (actual !== null) {
+			this._vsync = actual
+		}
+		else {
+			// Recreating the renderer also unlocks the texture and destroys all textures
+			this._lockedPixels = null
+			this._forgetTextures()
+			const result = Bindings.window_setAcceleratedAndVsync(this._handle, this._accelerated, vsync)
+			this._accelerated = result.accelerated
+			this._vsync = result.vsync
+			this._renderer = result.renderer
+			if (this._frameCapture) { this._startFrameCapture(this._frameCapture) }
+		}
+
+		if (renderThread) { this._startRenderThread(renderThread) }
 	}
 
+	get renderer () { return this._renderer }
+
 	get opengl () { return this._opengl }
 	get webgpu () { return this._webgpu }
 	get native () { return this._native }
@@ -323,7 +445,7 @@ class Window extends EventsViaPoll {
 	minimize () {
 		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
 
-		Bindings.window_minimize(this._id)
+		Bindings.window_minimize(this._handle)
 		this._visible = false
 		this._minimized = true
 		this._maximized = false
@@ -334,7 +456,7 @@ class Window extends EventsViaPoll {
 	maximize () {
 		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
 
-		Bindings.window_maximize(this._id)
+		Bindings.window_maximize(this._handle)
 		this._visible = true
 		this._minimized = false
 		this._maximized = true
@@ -344,7 +466,7 @@ class Window extends EventsViaPoll {
 	restore () {
 		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
 
-		Bindings.window_restore(this._id)
+		Bindings.window_restore(this._handle)
 		this._visible = true
 		this._minimized = false
 		this._maximized = false
@@ -355,7 +477,7 @@ class Window extends EventsViaPoll {
 	focus () {
 		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
 
-		Bindings.window_focus(this._id)
+		Bindings.window_focus(this._handle)
 		Globals.windows.focused = this
 	}
 
@@ -371,10 +493,14 @@ class Window extends EventsViaPoll {
 
 		if (this._opengl) { throw new Error("can't call render in opengl mode") }
 		if (this._webgpu) { throw new Error("can't call render in webgpu mode") }
+		if (this._renderTarget) { throw new Error("can't call render while a render target is set") }
+		if (this._lockedPixels) { throw new Error("can't call render while pixels are locked") }
 
 		const {
 			scaling = 'nearest',
 			dstRect = null,
+			dirtyRects = null,
+			detectDamage = false,
 		} = options
 
 		if (!Number.isInteger(width)) { throw Object.assign(new Error("width must be an integer"), { width }) }
@@ -386,25 +512,507 @@ class Window extends EventsViaPoll {
 		if (typeof format !== 'string') { throw Object.assign(new Error("format must be a string"), { format }) }
 		if (!(buffer instanceof Buffer)) { throw Object.assign(new Error("buffer must be a Buffer"), { buffer }) }
 		if (buffer.length < stride * height) { throw Object.assign(new Error("buffer is smaller than expected"), { buffer, stride, height }) }
-		if (scaling !== undefined && typeof scaling !== 'string') { throw Object.assign(new Error("scaling must be a string"), { scaling }) }
-
-		if (dstRect !== null) {
-			if (typeof dstRect !== 'object') { throw Object.assign(new Error("dstRect must be an object"), { dstRect }) }
-			if (!Number.isInteger(dstRect.x)) { throw Object.assign(new Error("dstRect.x must be an integer"), { dstRect }) }
-			if (!Number.isInteger(dstRect.y)) { throw Object.assign(new Error("dstRect.y must be an integer"), { dstRect }) }
-			if (!Number.isInteger(dstRect.width)) { throw Object.assign(new Error("dstRect.width must be an integer"), { dstRect }) }
-			if (dstRect.width <= 0) { throw Object.assign(new Error("invalid dstRect.width"), { dstRect }) }
-			if (!Number.isInteger(dstRect.height)) { throw Object.assign(new Error("dstRect.height must be an integer"), { dstRect }) }
-			if (dstRect.height <= 0) { throw Object.assign(new Error("invalid dstRect.height"), { dstRect }) }
+
+		const _format = Enums.pixelFormat[format]
+		if (_format === undefined) { throw Object.assign(new Error("invalid format"), { format }) }
+
+		const _scaling = validatePresentOptions(scaling, dstRect)
+
+		if (dirtyRects !== null) {
+			if (!Array.isArray(dirtyRects)) { throw Object.assign(new Error("dirtyRects must be an array"), { dirtyRects }) }
+			for (const rect of dirtyRects) {
+				if (typeof rect !== 'object' || rect === null) { throw Object.assign(new Error("dirtyRects must contain objects"), { rect }) }
+				if (!Number.isInteger(rect.x)) { throw Object.assign(new Error("rect.x must be an integer"), { rect }) }
+				if (!Number.isInteger(rect.y)) { throw Object.assign(new Error("rect.y must be an integer"), { rect }) }
+				if (!Number.isInteger(rect.width)) { throw Object.assign(new Error("rect.width must be an integer"), { rect }) }
+				if (!Number.isInteger(rect.height)) { throw Object.assign(new Error("rect.height must be an integer"), { rect }) }
+				if (rect.x < 0 || rect.width <= 0 || rect.x + rect.width > width) { throw Object.assign(new Error("rect is out of bounds"), { rect, width }) }
+				if (rect.y < 0 || rect.height <= 0 || rect.y + rect.height > height) { throw Object.assign(new Error("rect is out of bounds"), { rect, height }) }
+			}
+		}
+
+		if (typeof detectDamage !== 'boolean') { throw Object.assign(new Error("detectDamage must be a boolean"), { detectDamage }) }
+		if (detectDamage && dirtyRects !== null) { throw Object.assign(new Error("detectDamage and dirtyRects are mutually exclusive"), { detectDamage, dirtyRects }) }
+
+		if (this._renderThread) {
+			if (dirtyRects !== null) { throw new Error("dirtyRects can't be used with asyncRender") }
+			if (detectDamage) { throw new Error("detectDamage can't be used with asyncRender") }
+
+			const id = this._renderThread.nextFrame++
+			const promise = new Promise((resolve, reject) => {
+				this._renderThread.frames.set(id, { resolve, reject })
+			})
+			const dropped = Bindings.renderThread_render(this._handle, width, height, stride, _format, buffer, _scaling, dstRect, id)
+			this._dropFrames(dropped)
+			return promise
+		}
+
+		this._frameStarted = false
+		this._damage = Bindings.window_render(this._handle, width, height, stride, _format, buffer, _scaling, dstRect, dirtyRects, detectDamage) ?? null
+		this._latencyTracker?.rendered()
+	}
+
+	renderYUV (width, height, yBuffer, yStride, uBuffer, uStride, vBuffer, vStride, options = {}) {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._opengl) { throw new Error("can't call renderYUV in opengl mode") }
+		if (this._webgpu) { throw new Error("can't call renderYUV in webgpu mode") }
+		if (this._renderTarget) { throw new Error("can't call renderYUV while a render target is set") }
+		if (this._renderThread) { throw new Error("can't call renderYUV with asyncRender") }
+		if (this._lockedPixels) { throw new Error("can't call renderYUV while pixels are locked") }
+
+		const {
+			scaling = 'nearest',
+			dstRect = null,
+			conversion = 'automatic',
+		} = options
+
+		validateFrameSize(width, height)
+		const chromaWidth = Math.ceil(width / 2)
+		const chromaHeight = Math.ceil(height / 2)
+		validatePlane('yBuffer', yBuffer, yStride, width, height)
+		validatePlane('uBuffer', uBuffer, uStride, chromaWidth, chromaHeight)
+		validatePlane('vBuffer', vBuffer, vStride, chromaWidth, chromaHeight)
+
+		const _conversion = validateConversion(conversion)
+		const _scaling = validatePresentOptions(scaling, dstRect)
+
+		this._frameStarted = false
+		this._damage = null
+		Bindings.window_renderYUV(this._handle, width, height, yBuffer, yStride, uBuffer, uStride, vBuffer, vStride, _conversion, _scaling, dstRect)
+		this._latencyTracker?.rendered()
+	}
+
+	renderNV (width, height, yBuffer, yStride, uvBuffer, uvStride, options = {}) {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._opengl) { throw new Error("can't call renderNV in opengl mode") }
+		if (this._webgpu) { throw new Error("can't call renderNV in webgpu mode") }
+		if (this._renderTarget) { throw new Error("can't call renderNV while a render target is set") }
+		if (this._renderThread) { throw new Error("can't call renderNV with asyncRender") }
+		if (this._lockedPixels) { throw new Error("can't call renderNV while pixels are locked") }
+
+		const {
+			format = 'nv12',
+			scaling = 'nearest',
+			dstRect = null,
+			conversion = 'automatic',
+		} = options
+
+		if (format !== 'nv12' && format !== 'nv21') { throw Object.assign(new Error("invalid format"), { format }) }
+
+		validateFrameSize(width, height)
+		validatePlane('yBuffer', yBuffer, yStride, width, height)
+		validatePlane('uvBuffer', uvBuffer, uvStride, Math.ceil(width / 2) * 2, Math.ceil(height / 2))
+
+		const _conversion = validateConversion(conversion)
+		const _scaling = validatePresentOptions(scaling, dstRect)
+
+		this._frameStarted = false
+		this._damage = null
+		Bindings.window_renderNV(this._handle, width, height, Enums.pixelFormat[format], yBuffer, yStride, uvBuffer, uvStride, _conversion, _scaling, dstRect)
+		this._latencyTracker?.rendered()
+	}
+
+	get damage () { return this._damage }
+
+	get asyncRender () { return this._renderThread !== null }
+	setAsyncRender (asyncRender, options = {}) {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._opengl) { throw new Error("can't call setAsyncRender in opengl mode") }
+		if (this._webgpu) { throw new Error("can't call setAsyncRender in webgpu mode") }
+		if (this._lockedPixels) { throw new Error("can't call setAsyncRender while pixels are locked") }
+		if (this._renderTarget) { throw new Error("can't call setAsyncRender while a render target is set") }
+
+		if (typeof asyncRender !== 'boolean') { throw Object.assign(new Error("asyncRender must be a boolean"), { asyncRender }) }
+
+		const {
+			queueDepth = 1,
+			dropOldest = true,
+		} = options
+
+		if (!Number.isInteger(queueDepth)) { throw Object.assign(new Error("queueDepth must be an integer"), { queueDepth }) }
+		if (queueDepth <= 0) { throw Object.assign(new Error("invalid queueDepth"), { queueDepth }) }
+		if (typeof dropOldest !== 'boolean') { throw Object.assign(new Error("dropOldest must be a boolean"), { dropOldest }) }
+
+		if (asyncRender && process.platform === 'darwin') { throw new Error("asyncRender is not supported on macOS") }
+		if (asyncRender && this._frameCapture) { throw new Error("asyncRender can't be used with frameCapture") }
+
+		if (this._renderThread) { this._stopRenderThread() }
+		if (asyncRender) { this._startRenderThread({ queueDepth, dropOldest }) }
+	}
+
+	_startRenderThread ({ queueDepth, dropOldest }) {
+		const renderThread = {
+			queueDepth,
+			dropOldest,
+			nextFrame: 0,
+			frames: new Map(),
+		}
+
+		Bindings.renderThread_start(this._handle, queueDepth, dropOldest, (id, error) => {
+			const frame = renderThread.frames.get(id)
+			renderThread.frames.delete(id)
+			if (error) {
+				frame.reject(error)
+				return
+			}
+
+			frame.resolve(true)
+			if (this._destroyed) { return }
+			this._latencyTracker?.rendered()
+			this.emit('framePresented', { type: 'framePresented' })
+		})
+
+		this._renderThread = renderThread
+	}
+
+	_stopRenderThread () {
+		const dropped = Bindings.renderThread_stop(this._handle)
+		this._dropFrames(dropped)
+		this._renderThread = null
+	}
+
+	_dropFrames (ids) {
+		const { frames } = this._renderThread
+		for (const id of ids) {
+			frames.get(id).resolve(false)
+			frames.delete(id)
+		}
+	}
+
+	lockPixels (width, height, format) {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._opengl) { throw new Error("can't call lockPixels in opengl mode") }
+		if (this._webgpu) { throw new Error("can't call lockPixels in webgpu mode") }
+		if (this._renderTarget) { throw new Error("can't call lockPixels while a render target is set") }
+		if (this._renderThread) { throw new Error("can't call lockPixels with asyncRender") }
+		if (this._lockedPixels) { throw new Error("pixels are already locked") }
+
+		if (!Number.isInteger(width)) { throw Object.assign(new Error("width must be an integer"), { width }) }
+		if (width <= 0) { throw Object.assign(new Error("invalid width"), { width }) }
+		if (!Number.isInteger(height)) { throw Object.assign(new Error("height must be an integer"), { height }) }
+		if (height <= 0) { throw Object.assign(new Error("invalid height"), { height }) }
+		if (typeof format !== 'string') { throw Object.assign(new Error("format must be a string"), { format }) }
+
+		const _format = Enums.pixelFormat[format]
+		if (_format === undefined) { throw Object.assign(new Error("invalid format"), { format }) }
+
+		const { pixels, stride } = Bindings.window_lockTexture(this._handle, width, height, _format)
+		this._lockedPixels = { buffer: Buffer.from(pixels), stride }
+		return this._lockedPixels
+	}
+
+	present (options = {}) {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._opengl) { throw new Error("can't call present in opengl mode") }
+		if (this._webgpu) { throw new Error("can't call present in webgpu mode") }
+		if (this._renderThread) { throw new Error("can't call present with asyncRender") }
+		if (this._renderTarget) { throw new Error("can't call present while a render target is set") }
+
+		const {
+			scaling = 'nearest',
+			dstRect = null,
+		} = options
+
+		const _scaling = validatePresentOptions(scaling, dstRect)
+
+		if (!this._lockedPixels && !this._frameStarted) { Bindings.window_clear(this._handle) }
+
+		this._lockedPixels = null
+		this._frameStarted = false
+		this._damage = null
+		Bindings.window_present(this._handle, _scaling, dstRect)
+		this._latencyTracker?.rendered()
+	}
+
+	createTexture (width, height, format) {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._opengl) { throw new Error("can't call createTexture in opengl mode") }
+		if (this._webgpu) { throw new Error("can't call createTexture in webgpu mode") }
+		if (this._renderThread) { throw new Error("can't call createTexture with asyncRender") }
+
+		if (!Number.isInteger(width)) { throw Object.assign(new Error("width must be an integer"), { width }) }
+		if (width <= 0) { throw Object.assign(new Error("invalid width"), { width }) }
+		if (!Number.isInteger(height)) { throw Object.assign(new Error("height must be an integer"), { height }) }
+		if (height <= 0) { throw Object.assign(new Error("invalid height"), { height }) }
+		if (typeof format !== 'string') { throw Object.assign(new Error("format must be a string"), { format }) }
+
+		const _format = Enums.pixelFormat[format]
+		if (_format === undefined) { throw Object.assign(new Error("invalid format"), { format }) }
+
+		const id = Bindings.texture_create(this._handle, width, height, _format, false)
+		const texture = new Texture(this, id, width, height, format, false)
+		this._textures.add(texture)
+		return texture
+	}
+
+	createRenderTarget (width, height, format = 'rgba32') {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._opengl) { throw new Error("can't call createRenderTarget in opengl mode") }
+		if (this._webgpu) { throw new Error("can't call createRenderTarget in webgpu mode") }
+		if (this._renderThread) { throw new Error("can't call createRenderTarget with asyncRender") }
+
+		if (!Number.isInteger(width)) { throw Object.assign(new Error("width must be an integer"), { width }) }
+		if (width <= 0) { throw Object.assign(new Error("invalid width"), { width }) }
+		if (!Number.isInteger(height)) { throw Object.assign(new Error("height must be an integer"), { height }) }
+		if (height <= 0) { throw Object.assign(new Error("invalid height"), { height }) }
+		if (typeof format !== 'string') { throw Object.assign(new Error("format must be a string"), { format }) }
+
+		const _format = Enums.pixelFormat[format]
+		if (_format === undefined) { throw Object.assign(new Error("invalid format"), { format }) }
+
+		const id = Bindings.texture_create(this._handle, width, height, _format, true)
+		const texture = new Texture(this, id, width, height, format, true)
+		this._textures.add(texture)
+		return texture
+	}
+
+	get renderTarget () { return this._renderTarget }
+	setRenderTarget (target) {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._opengl) { throw new Error("can't call setRenderTarget in opengl mode") }
+		if (this._webgpu) { throw new Error("can't call setRenderTarget in webgpu mode") }
+		if (this._renderThread) { throw new Error("can't call setRenderTarget with asyncRender") }
+		if (this._lockedPixels) { throw new Error("can't call setRenderTarget while pixels are locked") }
+
+		if (target !== null) {
+			if (!(target instanceof Texture)) { throw Object.assign(new Error("target must be a Texture"), { target }) }
+			if (target.window !== this) { throw Object.assign(new Error("target belongs to another window"), { target }) }
+			if (target.destroyed) { throw Object.assign(new Error("target is destroyed"), { target }) }
+			if (!target.target) { throw Object.assign(new Error("texture is not a render target"), { target }) }
 		}
 
+		Bindings.texture_setTarget(this._handle, target?.id ?? null)
+		this._renderTarget = target
+		this._frameStarted = false
+	}
+
+	get frameCapture () { return this._frameCapture !== null }
+	setFrameCapture (frameCapture, options = {}) {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._opengl) { throw new Error("can't call setFrameCapture in opengl mode") }
+		if (this._webgpu) { throw new Error("can't call setFrameCapture in webgpu mode") }
+		if (this._renderThread) { throw new Error("can't call setFrameCapture with asyncRender") }
+		if (this._capture) { throw new Error("can't call setFrameCapture while capturing") }
+
+		if (typeof frameCapture !== 'boolean') { throw Object.assign(new Error("frameCapture must be a boolean"), { frameCapture }) }
+
+		const {
+			width = this._pixelWidth,
+			height = this._pixelHeight,
+			format = 'rgba32',
+		} = options
+
+		if (!Number.isInteger(width)) { throw Object.assign(new Error("width must be an integer"), { width }) }
+		if (width <= 0) { throw Object.assign(new Error("invalid width"), { width }) }
+		if (!Number.isInteger(height)) { throw Object.assign(new Error("height must be an integer"), { height }) }
+		if (height <= 0) { throw Object.assign(new Error("invalid height"), { height }) }
+		if (typeof format !== 'string') { throw Object.assign(new Error("format must be a string"), { format }) }
+
 		const _format = Enums.pixelFormat[format]
 		if (_format === undefined) { throw Object.assign(new Error("invalid format"), { format }) }
 
+		if (!frameCapture) {
+			Bindings.window_setFrameCapture(this._handle, false, 0, 0, 0)
+			this._frameCapture = null
+			return
+		}
+
+		this._startFrameCapture({ width, height, format, _format })
+	}
+
+	_startFrameCapture (frameCapture) {
+		const { width, height, _format } = frameCapture
+		this._frameCapture = null
+		Bindings.window_setFrameCapture(this._handle, true, width, height, _format)
+		this._frameCapture = frameCapture
+	}
+
+	readPixels () {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (!this._frameCapture) { throw new Error("frameCapture is not enabled") }
+
+		const frame = Bindings.window_readFrame(this._handle)
+		if (!frame) { return null }
+		frame.format = this._frameCapture.format
+		return frame
+	}
+
+	get capturing () { return this._capture !== null }
+	get captureStats () {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (!this._capture) { return null }
+		return Bindings.recorder_getStats(this._handle)
+	}
+
+	startCapture (target, options = {}) {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._opengl) { throw new Error("can't call startCapture in opengl mode") }
+		if (this._webgpu) { throw new Error("can't call startCapture in webgpu mode") }
+		if (this._renderThread) { throw new Error("can't call startCapture with asyncRender") }
+		if (this._frameCapture) { throw new Error("can't call startCapture with frameCapture") }
+
+		if (typeof target !== 'string' && !Number.isInteger(target)) { throw Object.assign(new Error("target must be a path or a file descriptor"), { target }) }
+
+		const {
+			format = 'y4m',
+			fps = 30,
+			width = this._pixelWidth,
+			height = this._pixelHeight,
+			queueDepth = 8,
+		} = options
+
+		if (format !== 'y4m' && format !== 'rgb') { throw Object.assign(new Error("invalid format"), { format }) }
+		if (!Number.isInteger(fps)) { throw Object.assign(new Error("fps must be an integer"), { fps }) }
+		if (fps <= 0) { throw Object.assign(new Error("invalid fps"), { fps }) }
+		if (!Number.isInteger(width)) { throw Object.assign(new Error("width must be an integer"), { width }) }
+		if (width <= 0) { throw Object.assign(new Error("invalid width"), { width }) }
+		if (!Number.isInteger(height)) { throw Object.assign(new Error("height must be an integer"), { height }) }
+		if (height <= 0) { throw Object.assign(new Error("invalid height"), { height }) }
+		if (format === 'y4m' && (width % 2 !== 0 || height % 2 !== 0)) { throw Object.assign(new Error("y4m needs an even width and height"), { width, height }) }
+		if (!Number.isInteger(queueDepth)) { throw Object.assign(new Error("queueDepth must be an integer"), { queueDepth }) }
+		if (queueDepth <= 0) { throw Object.assign(new Error("invalid queueDepth"), { queueDepth }) }
+
+		this._startFrameCapture({ width, height, format: 'rgba32', _format: Enums.pixelFormat.rgba32 })
+		try {
+			Bindings.recorder_start(this._handle, target, format === 'y4m', fps, queueDepth)
+		} catch (error) {
+			Bindings.window_setFrameCapture(this._handle, false, 0, 0, 0)
+			this._frameCapture = null
+			throw error
+		}
+		this._capture = { format, fps }
+	}
+
+	stopCapture () {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (!this._capture) { throw new Error("not capturing") }
+
+		this._capture = null
+		try {
+			return Bindings.recorder_stop(this._handle)
+		} finally {
+			Bindings.window_setFrameCapture(this._handle, false, 0, 0, 0)
+			this._frameCapture = null
+		}
+	}
+
+	clear () {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._opengl) { throw new Error("can't call clear in opengl mode") }
+		if (this._webgpu) { throw new Error("can't call clear in webgpu mode") }
+		if (this._renderThread) { throw new Error("can't call clear with asyncRender") }
+		if (this._lockedPixels) { throw new Error("can't call clear while pixels are locked") }
+
+		Bindings.window_clear(this._handle)
+		this._frameStarted = true
+	}
+
+	draw (texture, options = {}) {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._renderThread) { throw new Error("can't call draw with asyncRender") }
+		if (this._lockedPixels) { throw new Error("can't call draw while pixels are locked") }
+
+		if (!(texture instanceof Texture)) { throw Object.assign(new Error("texture must be a Texture"), { texture }) }
+		if (texture._window !== this) { throw Object.assign(new Error("texture belongs to another window"), { texture }) }
+		if (texture._destroyed) { throw Object.assign(new Error("texture is destroyed"), { id: texture._id }) }
+
+		const {
+			srcRect = null,
+			dstRect = null,
+			scaling = 'nearest',
+			blend = 'blend',
+			alpha = 1,
+			angle = 0,
+			flipX = false,
+			flipY = false,
+		} = options
+
+		if (srcRect !== null) {
+			if (typeof srcRect !== 'object') { throw Object.assign(new Error("srcRect must be an object"), { srcRect }) }
+			if (!Number.isInteger(srcRect.x)) { throw Object.assign(new Error("srcRect.x must be an integer"), { srcRect }) }
+			if (!Number.isInteger(srcRect.y)) { throw Object.assign(new Error("srcRect.y must be an integer"), { srcRect }) }
+			if (!Number.isInteger(srcRect.width)) { throw Object.assign(new Error("srcRect.width must be an integer"), { srcRect }) }
+			if (srcRect.width <= 0) { throw Object.assign(new Error("invalid srcRect.width"), { srcRect }) }
+			if (!Number.isInteger(srcRect.height)) { throw Object.assign(new Error("srcRect.height must be an integer"), { srcRect }) }
+			if (srcRect.height <= 0) { throw Object.assign(new Error("invalid srcRect.height"), { srcRect }) }
+		}
+
+		const _scaling = validatePresentOptions(scaling, dstRect)
+
+		if (typeof blend !== 'string') { throw Object.assign(new Error("blend must be a string"), { blend }) }
+		const _blend = Enums.blendMode[blend]
+		if (_blend === undefined) { throw Object.assign(new Error("invalid blend"), { blend }) }
+
+		if (typeof alpha !== 'number') { throw Object.assign(new Error("alpha must be a number"), { alpha }) }
+		if (alpha < 0 || alpha > 1) { throw Object.assign(new Error("invalid alpha"), { alpha }) }
+		if (!Number.isFinite(angle)) { throw Object.assign(new Error("angle must be a number"), { angle }) }
+		if (typeof flipX !== 'boolean') { throw Object.assign(new Error("flipX must be a boolean"), { flipX }) }
+		if (typeof flipY !== 'boolean') { throw Object.assign(new Error("flipY must be a boolean"), { flipY }) }
+
+		Bindings.texture_draw(this._handle, texture._id, srcRect, dstRect, _scaling, _blend, Math.round(alpha * 255), angle, flipX, flipY, !this._frameStarted)
+		this._frameStarted = true
+	}
+
+	drawGeometry (texture, vertices, indices = null, options = {}) {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._opengl) { throw new Error("can't call drawGeometry in opengl mode") }
+		if (this._webgpu) { throw new Error("can't call drawGeometry in webgpu mode") }
+		if (this._renderThread) { throw new Error("can't call drawGeometry with asyncRender") }
+		if (this._lockedPixels) { throw new Error("can't call drawGeometry while pixels are locked") }
+
+		if (texture !== null) {
+			if (!(texture instanceof Texture)) { throw Object.assign(new Error("texture must be a Texture"), { texture }) }
+			if (texture._window !== this) { throw Object.assign(new Error("texture belongs to another window"), { texture }) }
+			if (texture._destroyed) { throw Object.assign(new Error("texture is destroyed"), { id: texture._id }) }
+		}
+
+		if (!(vertices instanceof Float32Array)) { throw Object.assign(new Error("vertices must be a Float32Array"), { vertices }) }
+		if (vertices.length % VERTEX_FLOATS !== 0) { throw Object.assign(new Error("invalid vertices length"), { length: vertices.length }) }
+
+		if (indices !== null) {
+			if (!(indices instanceof Uint8Array || indices instanceof Uint16Array || indices instanceof Uint32Array)) { throw Object.assign(new Error("indices must be a Uint8Array, Uint16Array, or Uint32Array"), { indices }) }
+			if (indices.length % 3 !== 0) { throw Object.assign(new Error("invalid indices length"), { length: indices.length }) }
+		} else if (vertices.length % (3 * VERTEX_FLOATS) !== 0) {
+			throw Object.assign(new Error("invalid vertices length"), { length: vertices.length })
+		}
+
+		const {
+			scaling = 'nearest',
+			blend = 'blend',
+		} = options
+
+		if (typeof scaling !== 'string') { throw Object.assign(new Error("scaling must be a string"), { scaling }) }
 		const _scaling = Enums.scaleMode[scaling]
 		if (_scaling === undefined) { throw Object.assign(new Error("invalid scaling"), { scaling }) }
 
-		Bindings.window_render(this._id, width, height, stride, _format, buffer, _scaling, dstRect)
+		if (typeof blend !== 'string') { throw Object.assign(new Error("blend must be a string"), { blend }) }
+		const _blend = Enums.blendMode[blend]
+		if (_blend === undefined) { throw Object.assign(new Error("invalid blend"), { blend }) }
+
+		Bindings.texture_drawGeometry(this._handle, texture?._id ?? null, vertices, indices, _scaling, _blend, !this._frameStarted)
+		this._frameStarted = true
+	}
+
+	_forgetTextures () {
+		for (const texture of this._textures) { texture._destroyed = true }
+		this._textures.clear()
+		this._renderTarget = null
 	}
 
 	setIcon (width, height, stride, format, buffer) {
@@ -423,7 +1031,7 @@ class Window extends EventsViaPoll {
 		const _format = Enums.pixelFormat[format]
 		if (_format === undefined) { throw Object.assign(new Error("invalid format"), { format }) }
 
-		Bindings.window_setIcon(this._id, width, height, stride, _format, buffer)
+		Bindings.window_setIcon(this._handle, width, height, stride, _format, buffer)
 	}
 
 	flash (untilFocused = false) {
@@ -431,13 +1039,67 @@ class Window extends EventsViaPoll {
 
 		if (typeof untilFocused !== 'boolean') { throw Object.assign(new Error("untilFocused must be a boolean"), { untilFocused }) }
 
-		Bindings.window_flash(this._id, untilFocused ? 2 : 1)
+		Bindings.window_flash(this._handle, untilFocused ? 2 : 1)
 	}
 
 	stopFlashing () {
 		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
 
-		Bindings.window_flash(this._id, 0)
+		Bindings.window_flash(this._handle, 0)
+	}
+
+	get coalesceMotion () { return this._coalesceMotion }
+	setCoalesceMotion (coalesceMotion) {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (typeof coalesceMotion !== 'boolean') { throw Object.assign(new Error("coalesceMotion must be a boolean"), { coalesceMotion }) }
+
+		Bindings.events_setCoalescing(Enums.eventFamilies.window, this._id, coalesceMotion)
+		this._coalesceMotion = coalesceMotion
+	}
+
+	get latencyTracking () { return this._latencyTracker !== null }
+	setLatencyTracking (latencyTracking) {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (typeof latencyTracking !== 'boolean') { throw Object.assign(new Error("latencyTracking must be a boolean"), { latencyTracking }) }
+
+		if (latencyTracking === (this._latencyTracker !== null)) { return }
+
+		if (latencyTracking) {
+			this._latencyTracker = new LatencyTracker(this._id)
+		} else {
+			this._latencyTracker.reset()
+			this._latencyTracker = null
+		}
+	}
+
+	get latency () {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (!this._latencyTracker) { return null }
+		Globals.events.poll()
+		return this._latencyTracker.getStats()
+	}
+
+	resetLatency () {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		this._latencyTracker?.reset()
+	}
+
+	get frameStats () {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		if (this._opengl || this._webgpu) { return null }
+
+		return Bindings.window_getFrameStats(this._handle)
+	}
+
+	resetFrameStats () {
+		if (this._destroyed) { throw Object.assign(new Error("window is destroyed"), { id: this._id }) }
+
+		Bindings.window_resetFrameStats(this._handle)
 	}
 
 	get destroyed () { return this._destroyed }
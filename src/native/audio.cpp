@@ -8,6 +8,24 @@
 std::map<bool, std::string> audio::device_types;
 
 
+Napi::Object
+audio::_getDevice(Napi::Env &env, int index, bool is_capture)
+{
+	const char *name = SDL_GetAudioDeviceName(index, is_capture);
+	if (name == nullptr) {
+		std::ostringstream message;
+		message << "SDL_GetAudioDeviceName(" << index << ", " << is_capture << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	Napi::Object device = Napi::Object::New(env);
+	device.Set("name", name);
+	device.Set("type", audio::device_types[is_capture]);
+
+	return device;
+}
+
 Napi::Array
 audio::_getDevices(Napi::Env &env, bool is_capture)
 {
@@ -26,22 +44,8 @@ audio::_getDevices(Napi::Env &env, bool is_capture)
 
 	Napi::Array devices = Napi::Array::New(env, num_devices);
 
-	std::string device_type = audio::device_types[is_capture];
-
 	for (int i = 0; i < num_devices; i++) {
-		const char *name = SDL_GetAudioDeviceName(i, is_capture);
-		if (name == nullptr) {
-			std::ostringstream message;
-			message << "SDL_GetAudioDeviceName(" << i << ", " << is_capture << ") error: " << SDL_GetError();
-			SDL_ClearError();
-			throw Napi::Error::New(env, message.str());
-		}
-
-		Napi::Object device = Napi::Object::New(env);
-		device.Set("name", name);
-		device.Set("type", device_type);
-
-		devices.Set(i, device);
+		devices.Set(i, audio::_getDevice(env, i, is_capture));
 	}
 
 	return devices;
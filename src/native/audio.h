@@ -9,6 +9,7 @@ namespace audio {
 
 	extern std::map<bool, std::string> device_types;
 
+	Napi::Object _getDevice(Napi::Env &env, int index, bool is_capture);
 	Napi::Array _getDevices(Napi::Env &env, bool is_capture);
 
 	Napi::Value getDevices(const Napi::CallbackInfo &info);
@@ -0,0 +1,617 @@
+#include "compositing.h"
+#include "pixels.h"
+#include <SDL.h>
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define COMPOSITING_SSE2
+	#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define COMPOSITING_NEON
+	#include <arm_neon.h>
+#endif
+
+// Jobs smaller than this are done right away, even if they were asked to
+// run in the background. Larger ones are split into bands of rows, one per
+// threadpool thread.
+#define ASYNC_MIN_PIXELS (256 * 256)
+#define MAX_BANDS 4
+
+
+// All images are 32-bit, 8 bits per channel. Pointers are at the top-left
+// corner of the rectangle that is worked on.
+enum JobKind {
+	JOB_COPY,
+	JOB_BLEND,
+	JOB_FILL,
+};
+
+struct Job {
+	JobKind kind;
+	int width;
+	int height;
+	Uint8 *dst;
+	int dst_stride;
+	unsigned int dst_format;
+	const Uint8 *src;
+	int src_stride;
+	unsigned int src_format;
+	// Set when the source and destination share memory. The rows are then
+	// processed in an order that doesn't overwrite pixels before they are
+	// read, and the job is never split.
+	bool is_overlapping;
+	// Byte of each pixel that holds alpha. For the formats without alpha
+	// it's the padding byte, and alpha_fill is 0xff so the source is opaque.
+	int alpha_index;
+	Uint8 alpha_fill;
+	bool is_premultiplied;
+	int opacity;
+	Uint32 pixel;
+};
+
+// Finds the byte of a pixel that holds alpha, for the 32-bit formats with
+// 8 bits per channel.
+static bool
+getAlphaIndex (unsigned int format, int *index, bool *has_alpha)
+{
+	int bpp;
+	Uint32 r, g, b, a;
+	if (SDL_BYTESPERPIXEL(format) != 4) { return false; }
+	if (!SDL_PixelFormatEnumToMasks(format, &bpp, &r, &g, &b, &a)) { return false; }
+
+	*has_alpha = a != 0;
+	if (a == 0) { a = ~(r | g | b); }
+	if (a == 0) { return false; }
+
+	int shift = 0;
+	while (((a >> shift) & 1) == 0) { shift++; }
+	if ((a >> shift) != 0xff || shift % 8 != 0) { return false; }
+
+	*index = SDL_BYTEORDER == SDL_LIL_ENDIAN ? shift / 8 : 3 - shift / 8;
+	return true;
+}
+
+static bool
+isOverlapping (const Job &job)
+{
+	size_t row_size = job.width * 4;
+	const Uint8 *dst_end = job.dst + (size_t) (job.height - 1) * job.dst_stride + row_size;
+	const Uint8 *src_end = job.src + (size_t) (job.height - 1) * job.src_stride + row_size;
+	return job.dst < src_end && job.src < dst_end;
+}
+
+static std::string
+getConvertError (const Job &job)
+{
+	std::ostringstream message;
+	message << "SDL_ConvertPixels(" << job.src_format << ", " << job.dst_format << ") error: " << SDL_GetError();
+	SDL_ClearError();
+	return message.str();
+}
+
+
+static bool
+copyRows (const Job &job, int from, int to)
+{
+	const Uint8 *src = job.src + (size_t) from * job.src_stride;
+	Uint8 *dst = job.dst + (size_t) from * job.dst_stride;
+
+	if (job.src_format != job.dst_format) {
+		int height = to - from;
+		if (pixels::convertRect(job.width, height, job.src_format, src, job.src_stride, job.dst_format, dst, job.dst_stride)) {
+			return true;
+		}
+		return SDL_ConvertPixels(job.width, height, job.src_format, src, job.src_stride, job.dst_format, dst, job.dst_stride) == 0;
+	}
+
+	size_t row_size = job.width * 4;
+
+	if (!job.is_overlapping) {
+		for (int y = from; y < to; y++) {
+			memcpy(dst, src, row_size);
+			src += job.src_stride;
+			dst += job.dst_stride;
+		}
+		return true;
+	}
+
+	// Scrolling down, or right within the same rows
+	if (job.dst > job.src) {
+		for (int y = to - 1; y >= from; y--) {
+			memmove(job.dst + (size_t) y * job.dst_stride, job.src + (size_t) y * job.src_stride, row_size);
+		}
+		return true;
+	}
+
+	for (int y = from; y < to; y++) {
+		memmove(dst, src, row_size);
+		src += job.src_stride;
+		dst += job.dst_stride;
+	}
+	return true;
+}
+
+
+// Rounds x / 255 exactly, for x up to 255 * 255
+static inline int
+div255 (int x)
+{
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+// Straight alpha works like SDL_BLENDMODE_BLEND:
+//   dstRGB = srcRGB * srcA + dstRGB * (1 - srcA)
+//   dstA = srcA + dstA * (1 - srcA)
+// Premultiplied alpha skips the first multiplication:
+//   dstRGBA = srcRGBA + dstRGBA * (1 - srcA)
+// Opacity scales srcA, or all of srcRGBA if premultiplied. The vector
+// kernels round the same way, so results don't depend on the CPU.
+static void
+blendPixelsScalar (Uint8 *dst, const Uint8 *src, int count, const Job &job)
+{
+	int index = job.alpha_index;
+
+	for (int x = 0; x < count; x++) {
+		int source[4] = { src[0], src[1], src[2], src[3] };
+		source[index] |= job.alpha_fill;
+
+		if (job.is_premultiplied) {
+			if (job.opacity < 255) {
+				for (int i = 0; i < 4; i++) { source[i] = div255(source[i] * job.opacity); }
+			}
+			int inverse = 255 - source[index];
+			for (int i = 0; i < 4; i++) { dst[i] = std::min(255, source[i] + div255(dst[i] * inverse)); }
+		}
+		else {
+			int alpha = div255(source[index] * job.opacity);
+			int inverse = 255 - alpha;
+			source[index] = 255;
+			for (int i = 0; i < 4; i++) { dst[i] = div255(source[i] * alpha + dst[i] * inverse); }
+		}
+
+		src += 4;
+		dst += 4;
+	}
+}
+
+#if defined(COMPOSITING_SSE2)
+
+static inline __m128i
+div255Sse2 (__m128i x)
+{
+	x = _mm_add_epi16(x, _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Copies the alpha lane of each pixel to its other three lanes. The shuffle
+// immediates have to be known at compile time, hence the template.
+template <int ALPHA>
+static inline __m128i
+broadcastAlpha (__m128i value)
+{
+	value = _mm_shufflelo_epi16(value, ALPHA * 0x55);
+	return _mm_shufflehi_epi16(value, ALPHA * 0x55);
+}
+
+// Two pixels, widened to 16 bits per channel
+template <int ALPHA>
+static inline __m128i
+blendHalfSse2 (__m128i src, __m128i dst, const Job &job, __m128i opacity, __m128i alpha_lanes)
+{
+	__m128i max = _mm_set1_epi16(255);
+
+	if (job.is_premultiplied) {
+		if (job.opacity < 255) { src = div255Sse2(_mm_mullo_epi16(src, opacity)); }
+		__m128i inverse = _mm_sub_epi16(max, broadcastAlpha<ALPHA>(src));
+		return _mm_add_epi16(src, div255Sse2(_mm_mullo_epi16(dst, inverse)));
+	}
+
+	__m128i alpha = broadcastAlpha<ALPHA>(src);
+	if (job.opacity < 255) { alpha = div255Sse2(_mm_mullo_epi16(alpha, opacity)); }
+	__m128i inverse = _mm_sub_epi16(max, alpha);
+	src = _mm_or_si128(src, alpha_lanes);
+	return div255Sse2(_mm_add_epi16(_mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dst, inverse)));
+}
+
+template <int ALPHA>
+static int
+blendRowSse2 (Uint8 *dst, const Uint8 *src, int width, const Job &job)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i fill = _mm_set1_epi32((Uint32) job.alpha_fill << (ALPHA * 8));
+	__m128i alpha_mask = _mm_set1_epi32(0xffu << (ALPHA * 8));
+	__m128i alpha_lanes = _mm_set1_epi64x((Sint64) 0xff << (ALPHA * 16));
+	__m128i opacity = _mm_set1_epi16(job.opacity);
+
+	int x = 0;
+	for (; x + 4 <= width; x += 4) {
+		__m128i src_pixels = _mm_or_si128(_mm_loadu_si128((const __m128i *) (src + x * 4)), fill);
+
+		// Runs of fully opaque or fully transparent pixels are common in
+		// sprites and don't need any arithmetic.
+		__m128i alphas = _mm_and_si128(src_pixels, alpha_mask);
+		if (job.opacity == 255 && _mm_movemask_epi8(_mm_cmpeq_epi8(alphas, alpha_mask)) == 0xffff) {
+			_mm_storeu_si128((__m128i *) (dst + x * 4), src_pixels);
+			continue;
+		}
+		__m128i empty = job.is_premultiplied ? src_pixels : alphas;
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(empty, zero)) == 0xffff) { continue; }
+
+		__m128i dst_pixels = _mm_loadu_si128((const __m128i *) (dst + x * 4));
+		__m128i low = blendHalfSse2<ALPHA>(
+			_mm_unpacklo_epi8(src_pixels, zero), _mm_unpacklo_epi8(dst_pixels, zero),
+			job, opacity, alpha_lanes
+		);
+		__m128i high = blendHalfSse2<ALPHA>(
+			_mm_unpackhi_epi8(src_pixels, zero), _mm_unpackhi_epi8(dst_pixels, zero),
+			job, opacity, alpha_lanes
+		);
+		_mm_storeu_si128((__m128i *) (dst + x * 4), _mm_packus_epi16(low, high));
+	}
+	return x;
+}
+
+#elif defined(COMPOSITING_NEON)
+
+// Same rounding as div255()
+static inline uint8x8_t
+div255Neon (uint16x8_t x)
+{
+	return vraddhn_u16(x, vrshrq_n_u16(x, 8));
+}
+
+static inline uint8x16_t
+multiplyNeon (uint8x16_t a, uint8x16_t b)
+{
+	uint8x8_t low = div255Neon(vmull_u8(vget_low_u8(a), vget_low_u8(b)));
+	uint8x8_t high = div255Neon(vmull_u8(vget_high_u8(a), vget_high_u8(b)));
+	return vcombine_u8(low, high);
+}
+
+static inline uint8x16_t
+mixNeon (uint8x16_t src, uint8x16_t alpha, uint8x16_t dst, uint8x16_t inverse)
+{
+	uint16x8_t low = vmlal_u8(vmull_u8(vget_low_u8(src), vget_low_u8(alpha)), vget_low_u8(dst), vget_low_u8(inverse));
+	uint16x8_t high = vmlal_u8(vmull_u8(vget_high_u8(src), vget_high_u8(alpha)), vget_high_u8(dst), vget_high_u8(inverse));
+	return vcombine_u8(div255Neon(low), div255Neon(high));
+}
+
+// Channels are de-interleaved on load, so the alpha byte can be picked at
+// run time.
+static int
+blendRowNeon (Uint8 *dst, const Uint8 *src, int width, const Job &job)
+{
+	int index = job.alpha_index;
+	uint8x16_t max = vdupq_n_u8(255);
+	uint8x16_t opacity = vdupq_n_u8(job.opacity);
+	uint8x16_t fill = vdupq_n_u8(job.alpha_fill);
+
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x16x4_t source = vld4q_u8(src + x * 4);
+		uint8x16x4_t result = vld4q_u8(dst + x * 4);
+		source.val[index] = vorrq_u8(source.val[index], fill);
+
+		if (job.is_premultiplied) {
+			if (job.opacity < 255) {
+				for (int i = 0; i < 4; i++) { source.val[i] = multiplyNeon(source.val[i], opacity); }
+			}
+			uint8x16_t inverse = vsubq_u8(max, source.val[index]);
+			for (int i = 0; i < 4; i++) {
+				result.val[i] = vqaddq_u8(source.val[i], multiplyNeon(result.val[i], inverse));
+			}
+		}
+		else {
+			uint8x16_t alpha = source.val[index];
+			if (job.opacity < 255) { alpha = multiplyNeon(alpha, opacity); }
+			uint8x16_t inverse = vsubq_u8(max, alpha);
+			source.val[index] = max;
+			for (int i = 0; i < 4; i++) {
+				result.val[i] = mixNeon(source.val[i], alpha, result.val[i], inverse);
+			}
+		}
+
+		vst4q_u8(dst + x * 4, result);
+	}
+	return x;
+}
+
+#endif
+
+static void
+blendRow (Uint8 *dst, const Uint8 *src, int width, const Job &job)
+{
+	int x = 0;
+
+#if defined(COMPOSITING_SSE2)
+	switch (job.alpha_index) {
+		case 0: x = blendRowSse2<0>(dst, src, width, job); break;
+		case 1: x = blendRowSse2<1>(dst, src, width, job); break;
+		case 2: x = blendRowSse2<2>(dst, src, width, job); break;
+		case 3: x = blendRowSse2<3>(dst, src, width, job); break;
+	}
+#elif defined(COMPOSITING_NEON)
+	x = blendRowNeon(dst, src, width, job);
+#endif
+
+	blendPixelsScalar(dst + x * 4, src + x * 4, width - x, job);
+}
+
+static void
+blendRows (const Job &job, int from, int to)
+{
+	// Rows are blended from a copy of the source row, since within the same
+	// rows the destination can start to the right of the source.
+	if (job.is_overlapping) {
+		size_t row_size = job.width * 4;
+		std::vector<Uint8> row(row_size);
+		bool is_bottom_up = job.dst > job.src;
+		for (int i = from; i < to; i++) {
+			int y = is_bottom_up ? to - 1 - (i - from) : i;
+			memcpy(row.data(), job.src + (size_t) y * job.src_stride, row_size);
+			blendRow(job.dst + (size_t) y * job.dst_stride, row.data(), job.width, job);
+		}
+		return;
+	}
+
+	for (int y = from; y < to; y++) {
+		blendRow(job.dst + (size_t) y * job.dst_stride, job.src + (size_t) y * job.src_stride, job.width, job);
+	}
+}
+
+
+static void
+fillRow (Uint8 *dst, int width, Uint32 pixel)
+{
+	int x = 0;
+
+#if defined(COMPOSITING_SSE2)
+	__m128i value = _mm_set1_epi32(pixel);
+	for (; x + 4 <= width; x += 4) {
+		_mm_storeu_si128((__m128i *) (dst + x * 4), value);
+	}
+#elif defined(COMPOSITING_NEON)
+	uint8x16_t value = vreinterpretq_u8_u32(vdupq_n_u32(pixel));
+	for (; x + 4 <= width; x += 4) {
+		vst1q_u8(dst + x * 4, value);
+	}
+#endif
+
+	for (; x < width; x++) {
+		memcpy(dst + x * 4, &pixel, 4);
+	}
+}
+
+
+static bool
+runJob (const Job &job, int from, int to)
+{
+	switch (job.kind) {
+		case JOB_COPY: return copyRows(job, from, to);
+		case JOB_BLEND: blendRows(job, from, to); return true;
+		case JOB_FILL: {
+			for (int y = from; y < to; y++) {
+				fillRow(job.dst + (size_t) y * job.dst_stride, job.width, job.pixel);
+			}
+			return true;
+		}
+	}
+	return true;
+}
+
+struct Batch {
+	Napi::Promise::Deferred deferred;
+	// Keeps the buffers alive until every band is done
+	std::vector<Napi::Reference<Napi::Buffer<Uint8>>> buffers;
+	int pending;
+	std::string error;
+
+	Batch (Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)), pending(0) {}
+};
+
+class BandWorker : public Napi::AsyncWorker {
+public:
+	BandWorker (Napi::Env env, std::shared_ptr<Batch> batch, const Job &job, int from, int to)
+	: Napi::AsyncWorker(env, "@kmamal/sdl:pixels"), batch(batch), job(job), from(from), to(to) {}
+
+	void Execute () override {
+		if (!runJob(job, from, to)) { SetError(getConvertError(job)); }
+	}
+
+	void OnOK () override { finish(); }
+
+	void OnError (const Napi::Error &error) override {
+		batch->error = error.Message();
+		finish();
+	}
+
+private:
+	void finish () {
+		if (--batch->pending > 0) { return; }
+
+		Napi::Env env = Env();
+		if (batch->error.empty()) {
+			batch->deferred.Resolve(env.Undefined());
+		}
+		else {
+			batch->deferred.Reject(Napi::Error::New(env, batch->error).Value());
+		}
+		batch->buffers.clear();
+	}
+
+	std::shared_ptr<Batch> batch;
+	Job job;
+	int from;
+	int to;
+};
+
+// Runs the job right away, or on the libuv threadpool if it's asynchronous
+// and large enough. Asynchronous jobs always return a Promise.
+static Napi::Value
+startJob (Napi::Env env, const Job &job, bool is_async, std::initializer_list<Napi::Buffer<Uint8>> buffers)
+{
+	Sint64 pixels = (Sint64) job.width * job.height;
+
+	if (!is_async || pixels < ASYNC_MIN_PIXELS) {
+		bool is_done = runJob(job, 0, job.height);
+		if (!is_async) {
+			if (!is_done) { throw Napi::Error::New(env, getConvertError(job)); }
+			return env.Undefined();
+		}
+
+		Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+		if (is_done) { deferred.Resolve(env.Undefined()); }
+		else { deferred.Reject(Napi::Error::New(env, getConvertError(job)).Value()); }
+		return deferred.Promise();
+	}
+
+	int bands = job.is_overlapping ? 1 : (int) std::min<Sint64>(MAX_BANDS, pixels / ASYNC_MIN_PIXELS);
+	bands = std::min(bands, job.height);
+
+	auto batch = std::make_shared<Batch>(env);
+	for (const Napi::Buffer<Uint8> &buffer : buffers) {
+		batch->buffers.push_back(Napi::Reference<Napi::Buffer<Uint8>>::New(buffer, 1));
+	}
+	batch->pending = bands;
+
+	for (int i = 0; i < bands; i++) {
+		int from = job.height * i / bands;
+		int to = job.height * (i + 1) / bands;
+		(new BandWorker(env, batch, job, from, to))->Queue();
+	}
+
+	return batch->deferred.Promise();
+}
+
+
+Napi::Value
+compositing::copy (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	Napi::Buffer<Uint8> dst_buffer = info[0].As<Napi::Buffer<Uint8>>();
+	int dst_stride = info[1].As<Napi::Number>().Int32Value();
+	unsigned int dst_format = info[2].As<Napi::Number>().Int32Value();
+	int dst_x = info[3].As<Napi::Number>().Int32Value();
+	int dst_y = info[4].As<Napi::Number>().Int32Value();
+	Napi::Buffer<Uint8> src_buffer = info[5].As<Napi::Buffer<Uint8>>();
+	int src_stride = info[6].As<Napi::Number>().Int32Value();
+	unsigned int src_format = info[7].As<Napi::Number>().Int32Value();
+	int src_x = info[8].As<Napi::Number>().Int32Value();
+	int src_y = info[9].As<Napi::Number>().Int32Value();
+	int width = info[10].As<Napi::Number>().Int32Value();
+	int height = info[11].As<Napi::Number>().Int32Value();
+	bool is_async = info[12].As<Napi::Boolean>().Value();
+
+	Job job = {};
+	job.kind = JOB_COPY;
+	job.width = width;
+	job.height = height;
+	job.dst = dst_buffer.Data() + (size_t) dst_y * dst_stride + dst_x * 4;
+	job.dst_stride = dst_stride;
+	job.dst_format = dst_format;
+	job.src = src_buffer.Data() + (size_t) src_y * src_stride + src_x * 4;
+	job.src_stride = src_stride;
+	job.src_format = src_format;
+	job.is_overlapping = isOverlapping(job);
+
+	if (job.is_overlapping && src_format != dst_format) {
+		throw Napi::Error::New(env, "pixels_copy() error: overlapping images must have the same format");
+	}
+
+	return startJob(env, job, is_async, { dst_buffer, src_buffer });
+}
+
+Napi::Value
+compositing::blend (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	Napi::Buffer<Uint8> dst_buffer = info[0].As<Napi::Buffer<Uint8>>();
+	int dst_stride = info[1].As<Napi::Number>().Int32Value();
+	int dst_x = info[2].As<Napi::Number>().Int32Value();
+	int dst_y = info[3].As<Napi::Number>().Int32Value();
+	Napi::Buffer<Uint8> src_buffer = info[4].As<Napi::Buffer<Uint8>>();
+	int src_stride = info[5].As<Napi::Number>().Int32Value();
+	int src_x = info[6].As<Napi::Number>().Int32Value();
+	int src_y = info[7].As<Napi::Number>().Int32Value();
+	int width = info[8].As<Napi::Number>().Int32Value();
+	int height = info[9].As<Napi::Number>().Int32Value();
+	unsigned int format = info[10].As<Napi::Number>().Int32Value();
+	bool is_premultiplied = info[11].As<Napi::Boolean>().Value();
+	int opacity = info[12].As<Napi::Number>().Int32Value();
+	bool is_async = info[13].As<Napi::Boolean>().Value();
+
+	int alpha_index;
+	bool has_alpha;
+	if (!getAlphaIndex(format, &alpha_index, &has_alpha)) {
+		std::ostringstream message;
+		message << "pixels_blend(" << format << ") error: unsupported format";
+		throw Napi::Error::New(env, message.str());
+	}
+
+	Job job = {};
+	job.kind = JOB_BLEND;
+	job.width = width;
+	job.height = height;
+	job.dst = dst_buffer.Data() + (size_t) dst_y * dst_stride + dst_x * 4;
+	job.dst_stride = dst_stride;
+	job.dst_format = format;
+	job.src = src_buffer.Data() + (size_t) src_y * src_stride + src_x * 4;
+	job.src_stride = src_stride;
+	job.src_format = format;
+	job.is_overlapping = isOverlapping(job);
+	job.alpha_index = alpha_index;
+	job.alpha_fill = has_alpha ? 0 : 0xff;
+	job.is_premultiplied = is_premultiplied;
+	job.opacity = std::clamp(opacity, 0, 255);
+
+	return startJob(env, job, is_async, { dst_buffer, src_buffer });
+}
+
+Napi::Value
+compositing::fill (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	Napi::Buffer<Uint8> dst_buffer = info[0].As<Napi::Buffer<Uint8>>();
+	int dst_stride = info[1].As<Napi::Number>().Int32Value();
+	unsigned int format = info[2].As<Napi::Number>().Int32Value();
+	int x = info[3].As<Napi::Number>().Int32Value();
+	int y = info[4].As<Napi::Number>().Int32Value();
+	int width = info[5].As<Napi::Number>().Int32Value();
+	int height = info[6].As<Napi::Number>().Int32Value();
+	Uint8 r = info[7].As<Napi::Number>().Uint32Value();
+	Uint8 g = info[8].As<Napi::Number>().Uint32Value();
+	Uint8 b = info[9].As<Napi::Number>().Uint32Value();
+	Uint8 a = info[10].As<Napi::Number>().Uint32Value();
+	bool is_async = info[11].As<Napi::Boolean>().Value();
+
+	SDL_PixelFormat *pixel_format = SDL_AllocFormat(format);
+	if (pixel_format == nullptr) {
+		std::ostringstream message;
+		message << "SDL_AllocFormat(" << format << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+	Uint32 pixel = SDL_MapRGBA(pixel_format, r, g, b, a);
+	SDL_FreeFormat(pixel_format);
+
+	Job job = {};
+	job.kind = JOB_FILL;
+	job.width = width;
+	job.height = height;
+	job.dst = dst_buffer.Data() + (size_t) y * dst_stride + x * 4;
+	job.dst_stride = dst_stride;
+	job.dst_format = format;
+	job.pixel = pixel;
+
+	return startJob(env, job, is_async, { dst_buffer });
+}
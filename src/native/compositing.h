@@ -0,0 +1,15 @@
+#ifndef _COMPOSITING_H_
+#define _COMPOSITING_H_
+
+#include <napi.h>
+#include <SDL.h>
+
+namespace compositing {
+
+	Napi::Value copy(const Napi::CallbackInfo &info);
+	Napi::Value blend(const Napi::CallbackInfo &info);
+	Napi::Value fill(const Napi::CallbackInfo &info);
+
+}; // namespace compositing
+
+#endif // _COMPOSITING_H_
@@ -7,11 +7,40 @@
 #include <sstream>
 
 
+std::map<SDL_JoystickID, controller::Calibration> controller::calibrations;
 std::map<SDL_GameControllerType, std::string> controller::types;
-std::map<SDL_GameControllerAxis, std::string> controller::axes;
-std::map<SDL_GameControllerButton, std::string> controller::buttons;
 
 
+static void
+calibrateAxis (SDL_GameController *controller, SDL_GameControllerAxis axis, joystick::AxisCalibration &dst)
+{
+	SDL_GameControllerButtonBind bind = SDL_GameControllerGetBindForAxis(controller, axis);
+	if (bind.bindType == SDL_CONTROLLER_BINDTYPE_AXIS) {
+		SDL_Joystick *joystick = SDL_GameControllerGetJoystick(controller);
+		joystick::calibrateAxis(joystick, bind.value.axis, dst);
+		return;
+	}
+
+	dst.initial = 0;
+	dst.negative_scale = 1.0 / -SDL_JOYSTICK_AXIS_MIN;
+	dst.positive_scale = 1.0 / SDL_JOYSTICK_AXIS_MAX;
+}
+
+void
+controller::calibrate (SDL_GameController *controller, Calibration &dst) {
+	for (int i = 0; i < SDL_CONTROLLER_AXIS_MAX; i++) {
+		calibrateAxis(controller, (SDL_GameControllerAxis) i, dst.axes[i]);
+	}
+}
+
+void
+controller::recalibrate (SDL_GameController *controller) {
+	SDL_Joystick *joystick = SDL_GameControllerGetJoystick(controller);
+	auto it = calibrations.find(SDL_JoystickInstanceID(joystick));
+	if (it == calibrations.end()) { return; }
+	calibrate(controller, it->second);
+}
+
 double
 controller::mapAxis (SDL_GameController *controller, SDL_GameControllerAxis axis) {
 	return mapAxisValue(controller, axis, SDL_GameControllerGetAxis(controller, axis));
@@ -19,14 +48,32 @@ controller::mapAxis (SDL_GameController *controller, SDL_GameControllerAxis axis
 
 double
 controller::mapAxisValue (SDL_GameController *controller, SDL_GameControllerAxis axis, int value) {
-	SDL_GameControllerButtonBind bind = SDL_GameControllerGetBindForAxis(controller, axis);
-	if (bind.bindType == SDL_CONTROLLER_BINDTYPE_AXIS) {
-		SDL_Joystick *joystick = SDL_GameControllerGetJoystick(controller);
-		return joystick::mapAxisValue(joystick, bind.value.axis, value);
+	SDL_Joystick *joystick = SDL_GameControllerGetJoystick(controller);
+	auto it = calibrations.find(SDL_JoystickInstanceID(joystick));
+	if (it != calibrations.end() && axis >= 0 && axis < SDL_CONTROLLER_AXIS_MAX) {
+		return joystick::mapAxisValue(it->second.axes[axis], value);
 	}
 
-	double range = value < 0 ? -SDL_JOYSTICK_AXIS_MIN : SDL_JOYSTICK_AXIS_MAX;
-	return value / range;
+	joystick::AxisCalibration calibration;
+	calibrateAxis(controller, axis, calibration);
+	return joystick::mapAxisValue(calibration, value);
+}
+
+static void
+retainCalibration (SDL_GameController *controller)
+{
+	SDL_Joystick *joystick = SDL_GameControllerGetJoystick(controller);
+	controller::Calibration &calibration = controller::calibrations[SDL_JoystickInstanceID(joystick)];
+	if (calibration.references++ > 0) { return; }
+	controller::calibrate(controller, calibration);
+}
+
+static void
+releaseCalibration (SDL_JoystickID controller_id)
+{
+	auto it = controller::calibrations.find(controller_id);
+	if (it == controller::calibrations.end()) { return; }
+	if (--it->second.references == 0) { controller::calibrations.erase(it); }
 }
 
 Napi::Value
@@ -123,7 +170,8 @@ controller::open (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int index = info[0].As<Napi::Number>().Int32Value();
+	int controller_id = info[0].As<Napi::Number>().Int32Value();
+	int index = joystick::_getDeviceIndex(env, controller_id);
 
 	SDL_GameController *controller = SDL_GameControllerOpen(index);
 	if (controller == nullptr) {
@@ -168,6 +216,8 @@ controller::open (const Napi::CallbackInfo &info)
 
 	controller::getState(env, controller, result);
 
+	retainCalibration(controller);
+
 	return result;
 }
 
@@ -186,6 +236,7 @@ controller::close (const Napi::CallbackInfo &info)
 		throw Napi::Error::New(env, message.str());
 	}
 
+	releaseCalibration(controller_id);
 	SDL_GameControllerClose(controller);
 
 	return env.Undefined();
@@ -3,15 +3,24 @@
 
 #include <napi.h>
 #include <SDL.h>
+#include "joystick.h"
 #include <map>
 #include <string>
 
 namespace controller {
 
+	// Controller axes are calibrated through the joystick axis they are bound
+	// to. Bindings only change when the controller gets remapped.
+	struct Calibration {
+		int references;
+		joystick::AxisCalibration axes[SDL_CONTROLLER_AXIS_MAX];
+	};
+
+	extern std::map<SDL_JoystickID, Calibration> calibrations;
 	extern std::map<SDL_GameControllerType, std::string> types;
-	extern std::map<SDL_GameControllerAxis, std::string> axes;
-	extern std::map<SDL_GameControllerButton, std::string> buttons;
 
+	void calibrate (SDL_GameController *controller, Calibration &dst);
+	void recalibrate (SDL_GameController *controller);
 	double mapAxis (SDL_GameController *controller, SDL_GameControllerAxis axis);
 	double mapAxisValue (SDL_GameController *controller, SDL_GameControllerAxis axis, int value);
 	void getState (Napi::Env &env, SDL_GameController *controller, Napi::Object dst);
@@ -1,4 +1,5 @@
 #include "enums.h"
+#include "events.h"
 #include <SDL.h>
 
 Napi::Value
@@ -44,11 +45,34 @@ enums::get(const Napi::CallbackInfo &info)
 	pixel_formats.Set("nv12", (int) SDL_PIXELFORMAT_NV12);
 	pixel_formats.Set("nv21", (int) SDL_PIXELFORMAT_NV21);
 
+	// Bytes per pixel of the packed formats. YUV formats are left out.
+	Napi::Object pixel_format_bytes = Napi::Object::New(env);
+	Napi::Array pixel_format_names = pixel_formats.GetPropertyNames();
+	for (uint32_t i = 0; i < pixel_format_names.Length(); i++) {
+		Napi::Value name = pixel_format_names.Get(i);
+		unsigned int format = pixel_formats.Get(name).As<Napi::Number>().Uint32Value();
+		if (SDL_ISPIXELFORMAT_FOURCC(format)) { continue; }
+		pixel_format_bytes.Set(name, (int) SDL_BYTESPERPIXEL(format));
+	}
+
 	Napi::Object scale_mode = Napi::Object::New(env);
 	scale_mode.Set("nearest", (int) SDL_ScaleModeNearest);
 	scale_mode.Set("linear", (int) SDL_ScaleModeLinear);
 	scale_mode.Set("best", (int) SDL_ScaleModeBest);
 
+	Napi::Object yuv_conversion_modes = Napi::Object::New(env);
+	yuv_conversion_modes.Set("jpeg", (int) SDL_YUV_CONVERSION_JPEG);
+	yuv_conversion_modes.Set("bt601", (int) SDL_YUV_CONVERSION_BT601);
+	yuv_conversion_modes.Set("bt709", (int) SDL_YUV_CONVERSION_BT709);
+	yuv_conversion_modes.Set("automatic", (int) SDL_YUV_CONVERSION_AUTOMATIC);
+
+	Napi::Object blend_modes = Napi::Object::New(env);
+	blend_modes.Set("none", (int) SDL_BLENDMODE_NONE);
+	blend_modes.Set("blend", (int) SDL_BLENDMODE_BLEND);
+	blend_modes.Set("add", (int) SDL_BLENDMODE_ADD);
+	blend_modes.Set("mod", (int) SDL_BLENDMODE_MOD);
+	blend_modes.Set("mul", (int) SDL_BLENDMODE_MUL);
+
 	Napi::Object audio_formats = Napi::Object::New(env);
 	audio_formats.Set("s8", (int) AUDIO_S8);
 	audio_formats.Set("u8", (int) AUDIO_U8);
@@ -333,13 +357,167 @@ enums::get(const Napi::CallbackInfo &info)
 	cursors.Set("no", (int) SDL_SYSTEM_CURSOR_NO);
 	cursors.Set("hand", (int) SDL_SYSTEM_CURSOR_HAND);
 
+	Napi::Object event_families = Napi::Object::New(env);
+	event_families.Set("app", (int) events::families::APP);
+	event_families.Set("display", (int) events::families::DISPLAY);
+	event_families.Set("window", (int) events::families::WINDOW);
+	event_families.Set("drop", (int) events::families::DROP);
+	event_families.Set("keymap", (int) events::families::KEYMAP);
+	event_families.Set("keyboard", (int) events::families::KEYBOARD);
+	event_families.Set("text", (int) events::families::TEXT);
+	event_families.Set("mouse", (int) events::families::MOUSE);
+	event_families.Set("touch", (int) events::families::TOUCH);
+	event_families.Set("joystickDevice", (int) events::families::JOYSTICK_DEVICE);
+	event_families.Set("joystick", (int) events::families::JOYSTICK);
+	event_families.Set("controller", (int) events::families::CONTROLLER);
+	event_families.Set("sensor", (int) events::families::SENSOR);
+	event_families.Set("audioDevice", (int) events::families::AUDIO_DEVICE);
+	event_families.Set("clipboard", (int) events::families::CLIPBOARD);
+
+	Napi::Object event_types = Napi::Object::New(env);
+	event_types.Set("quit", (int) events::types::QUIT);
+	event_types.Set("displayAdd", (int) events::types::DISPLAY_ADD);
+	event_types.Set("displayRemove", (int) events::types::DISPLAY_REMOVE);
+	event_types.Set("displayOrient", (int) events::types::DISPLAY_ORIENT);
+	event_types.Set("displayMove", (int) events::types::DISPLAY_MOVE);
+	event_types.Set("displayChange", (int) events::types::DISPLAY_CHANGE);
+	event_types.Set("show", (int) events::types::SHOW);
+	event_types.Set("hide", (int) events::types::HIDE);
+	event_types.Set("expose", (int) events::types::EXPOSE);
+	event_types.Set("move", (int) events::types::MOVE);
+	event_types.Set("resize", (int) events::types::RESIZE);
+	event_types.Set("minimize", (int) events::types::MINIMIZE);
+	event_types.Set("maximize", (int) events::types::MAXIMIZE);
+	event_types.Set("restore", (int) events::types::RESTORE);
+	event_types.Set("focus", (int) events::types::FOCUS);
+	event_types.Set("blur", (int) events::types::BLUR);
+	event_types.Set("hover", (int) events::types::HOVER);
+	event_types.Set("leave", (int) events::types::LEAVE);
+	event_types.Set("keyDown", (int) events::types::KEY_DOWN);
+	event_types.Set("keyUp", (int) events::types::KEY_UP);
+	event_types.Set("textInput", (int) events::types::TEXT_INPUT);
+	event_types.Set("mouseMove", (int) events::types::MOUSE_MOVE);
+	event_types.Set("mouseButtonDown", (int) events::types::MOUSE_BUTTON_DOWN);
+	event_types.Set("mouseButtonUp", (int) events::types::MOUSE_BUTTON_UP);
+	event_types.Set("mouseWheel", (int) events::types::MOUSE_WHEEL);
+	event_types.Set("dropBegin", (int) events::types::DROP_BEGIN);
+	event_types.Set("dropComplete", (int) events::types::DROP_COMPLETE);
+	event_types.Set("dropFile", (int) events::types::DROP_FILE);
+	event_types.Set("dropText", (int) events::types::DROP_TEXT);
+	event_types.Set("close", (int) events::types::CLOSE);
+	event_types.Set("keymapChange", (int) events::types::KEYMAP_CHANGE);
+	event_types.Set("fingerDown", (int) events::types::FINGER_DOWN);
+	event_types.Set("fingerUp", (int) events::types::FINGER_UP);
+	event_types.Set("fingerMove", (int) events::types::FINGER_MOVE);
+	event_types.Set("deviceAdd", (int) events::types::DEVICE_ADD);
+	event_types.Set("deviceRemove", (int) events::types::DEVICE_REMOVE);
+	event_types.Set("axisMotion", (int) events::types::AXIS_MOTION);
+	event_types.Set("buttonDown", (int) events::types::BUTTON_DOWN);
+	event_types.Set("buttonUp", (int) events::types::BUTTON_UP);
+	event_types.Set("ballMotion", (int) events::types::BALL_MOTION);
+	event_types.Set("hatMotion", (int) events::types::HAT_MOTION);
+	event_types.Set("powerUpdate", (int) events::types::POWER_UPDATE);
+	event_types.Set("steamHandleUpdate", (int) events::types::STEAM_HANDLE_UPDATE);
+	event_types.Set("remap", (int) events::types::REMAP);
+	event_types.Set("update", (int) events::types::UPDATE);
+
+	Napi::Object event_record = Napi::Object::New(env);
+	event_record.Set("family", events::record::FAMILY);
+	event_record.Set("type", events::record::TYPE);
+	event_record.Set("id", events::record::ID);
+	event_record.Set("extra", events::record::EXTRA);
+	event_record.Set("data", events::record::DATA);
+	event_record.Set("merged", events::record::MERGED);
+	event_record.Set("timestamp", events::record::TIMESTAMP);
+	event_record.Set("size", events::record::SIZE);
+
+	Napi::Object latency_kinds = Napi::Object::New(env);
+	latency_kinds.Set("pumpToDispatch", events::latency::PUMP_TO_DISPATCH);
+	latency_kinds.Set("dispatchToRender", events::latency::DISPATCH_TO_RENDER);
+
+	Napi::Object event_modifiers = Napi::Object::New(env);
+	event_modifiers.Set("alt", events::modifiers::ALT);
+	event_modifiers.Set("ctrl", events::modifiers::CTRL);
+	event_modifiers.Set("shift", events::modifiers::SHIFT);
+	event_modifiers.Set("super", events::modifiers::SUPER);
+	event_modifiers.Set("altgr", events::modifiers::ALTGR);
+	event_modifiers.Set("numlock", events::modifiers::NUMLOCK);
+	event_modifiers.Set("capslock", events::modifiers::CAPSLOCK);
+
+	Napi::Object hat_positions = Napi::Object::New(env);
+	hat_positions.Set("centered", (int) SDL_HAT_CENTERED);
+	hat_positions.Set("up", (int) SDL_HAT_UP);
+	hat_positions.Set("right", (int) SDL_HAT_RIGHT);
+	hat_positions.Set("down", (int) SDL_HAT_DOWN);
+	hat_positions.Set("left", (int) SDL_HAT_LEFT);
+	hat_positions.Set("rightup", (int) SDL_HAT_RIGHTUP);
+	hat_positions.Set("rightdown", (int) SDL_HAT_RIGHTDOWN);
+	hat_positions.Set("leftup", (int) SDL_HAT_LEFTUP);
+	hat_positions.Set("leftdown", (int) SDL_HAT_LEFTDOWN);
+
+	Napi::Object power_levels = Napi::Object::New(env);
+	power_levels.Set("empty", (int) SDL_JOYSTICK_POWER_EMPTY);
+	power_levels.Set("low", (int) SDL_JOYSTICK_POWER_LOW);
+	power_levels.Set("medium", (int) SDL_JOYSTICK_POWER_MEDIUM);
+	power_levels.Set("full", (int) SDL_JOYSTICK_POWER_FULL);
+	power_levels.Set("wired", (int) SDL_JOYSTICK_POWER_WIRED);
+	power_levels.Set("max", (int) SDL_JOYSTICK_POWER_MAX);
+
+	Napi::Object orientations = Napi::Object::New(env);
+	orientations.Set("landscape", (int) SDL_ORIENTATION_LANDSCAPE);
+	orientations.Set("landscapeFlipped", (int) SDL_ORIENTATION_LANDSCAPE_FLIPPED);
+	orientations.Set("portrait", (int) SDL_ORIENTATION_PORTRAIT);
+	orientations.Set("portraitFlipped", (int) SDL_ORIENTATION_PORTRAIT_FLIPPED);
+
+	Napi::Object controller_axes = Napi::Object::New(env);
+	controller_axes.Set("leftStickX", (int) SDL_CONTROLLER_AXIS_LEFTX);
+	controller_axes.Set("leftStickY", (int) SDL_CONTROLLER_AXIS_LEFTY);
+	controller_axes.Set("rightStickX", (int) SDL_CONTROLLER_AXIS_RIGHTX);
+	controller_axes.Set("rightStickY", (int) SDL_CONTROLLER_AXIS_RIGHTY);
+	controller_axes.Set("leftTrigger", (int) SDL_CONTROLLER_AXIS_TRIGGERLEFT);
+	controller_axes.Set("rightTrigger", (int) SDL_CONTROLLER_AXIS_TRIGGERRIGHT);
+
+	Napi::Object controller_buttons = Napi::Object::New(env);
+	controller_buttons.Set("dpadLeft", (int) SDL_CONTROLLER_BUTTON_DPAD_LEFT);
+	controller_buttons.Set("dpadRight", (int) SDL_CONTROLLER_BUTTON_DPAD_RIGHT);
+	controller_buttons.Set("dpadUp", (int) SDL_CONTROLLER_BUTTON_DPAD_UP);
+	controller_buttons.Set("dpadDown", (int) SDL_CONTROLLER_BUTTON_DPAD_DOWN);
+	controller_buttons.Set("a", (int) SDL_CONTROLLER_BUTTON_A);
+	controller_buttons.Set("b", (int) SDL_CONTROLLER_BUTTON_B);
+	controller_buttons.Set("x", (int) SDL_CONTROLLER_BUTTON_X);
+	controller_buttons.Set("y", (int) SDL_CONTROLLER_BUTTON_Y);
+	controller_buttons.Set("guide", (int) SDL_CONTROLLER_BUTTON_GUIDE);
+	controller_buttons.Set("back", (int) SDL_CONTROLLER_BUTTON_BACK);
+	controller_buttons.Set("start", (int) SDL_CONTROLLER_BUTTON_START);
+	controller_buttons.Set("leftStick", (int) SDL_CONTROLLER_BUTTON_LEFTSTICK);
+	controller_buttons.Set("rightStick", (int) SDL_CONTROLLER_BUTTON_RIGHTSTICK);
+	controller_buttons.Set("leftShoulder", (int) SDL_CONTROLLER_BUTTON_LEFTSHOULDER);
+	controller_buttons.Set("rightShoulder", (int) SDL_CONTROLLER_BUTTON_RIGHTSHOULDER);
+	controller_buttons.Set("paddle1", (int) SDL_CONTROLLER_BUTTON_PADDLE1);
+	controller_buttons.Set("paddle2", (int) SDL_CONTROLLER_BUTTON_PADDLE2);
+	controller_buttons.Set("paddle3", (int) SDL_CONTROLLER_BUTTON_PADDLE3);
+	controller_buttons.Set("paddle4", (int) SDL_CONTROLLER_BUTTON_PADDLE4);
+
 	Napi::Object all = Napi::Object::New(env);
 	all.Set("pixelFormat", pixel_formats);
+	all.Set("pixelFormatBytes", pixel_format_bytes);
 	all.Set("scaleMode", scale_mode);
+	all.Set("blendMode", blend_modes);
+	all.Set("yuvConversionMode", yuv_conversion_modes);
 	all.Set("audioFormat", audio_formats);
 	all.Set("scancodes", scancodes);
 	all.Set("mouseButtons", mouse_buttons);
 	all.Set("cursors", cursors);
+	all.Set("eventFamilies", event_families);
+	all.Set("eventTypes", event_types);
+	all.Set("eventRecord", event_record);
+	all.Set("eventModifiers", event_modifiers);
+	all.Set("latencyKinds", latency_kinds);
+	all.Set("hatPositions", hat_positions);
+	all.Set("powerLevels", power_levels);
+	all.Set("orientations", orientations);
+	all.Set("controllerAxes", controller_axes);
+	all.Set("controllerButtons", controller_buttons);
 
 	return all;
 }
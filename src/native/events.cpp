@@ -5,154 +5,292 @@
 #include "joystick.h"
 #include "controller.h"
 #include "audio.h"
+#include "histogram.h"
+#include "render-thread.h"
 #include <SDL.h>
+#include <SDL_syswm.h>
+#include <uv.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <set>
 #include <string>
 #include <sstream>
 
 
-std::string events::families::APP;
-std::string events::families::DISPLAY;
-std::string events::families::WINDOW;
-std::string events::families::DROP;
-std::string events::families::KEYMAP;
-std::string events::families::KEYBOARD;
-std::string events::families::TEXT;
-std::string events::families::MOUSE;
-std::string events::families::TOUCH;
-std::string events::families::JOYSTICK_DEVICE;
-std::string events::families::JOYSTICK;
-std::string events::families::CONTROLLER;
-std::string events::families::SENSOR;
-std::string events::families::AUDIO_DEVICE;
-std::string events::families::CLIPBOARD;
-
-std::string events::types::QUIT;
-std::string events::types::DISPLAY_ADD;
-std::string events::types::DISPLAY_REMOVE;
-std::string events::types::DISPLAY_ORIENT;
-std::string events::types::DISPLAY_MOVE;
-std::string events::types::DISPLAY_CHANGE;
-std::string events::types::SHOW;
-std::string events::types::HIDE;
-std::string events::types::EXPOSE;
-std::string events::types::MOVE;
-std::string events::types::RESIZE;
-std::string events::types::MINIMIZE;
-std::string events::types::MAXIMIZE;
-std::string events::types::RESTORE;
-std::string events::types::FOCUS;
-std::string events::types::BLUR;
-std::string events::types::HOVER;
-std::string events::types::LEAVE;
-std::string events::types::KEY_DOWN;
-std::string events::types::KEY_UP;
-std::string events::types::TEXT_INPUT;
-std::string events::types::MOUSE_MOVE;
-std::string events::types::MOUSE_BUTTON_DOWN;
-std::string events::types::MOUSE_BUTTON_UP;
-std::string events::types::MOUSE_WHEEL;
-std::string events::types::DROP_BEGIN;
-std::string events::types::DROP_COMPLETE;
-std::string events::types::DROP_FILE;
-std::string events::types::DROP_TEXT;
-std::string events::types::CLOSE;
-std::string events::types::KEYMAP_CHANGE;
-std::string events::types::FINGER_DOWN;
-std::string events::types::FINGER_UP;
-std::string events::types::FINGER_MOVE;
-std::string events::types::DEVICE_ADD;
-std::string events::types::DEVICE_REMOVE;
-std::string events::types::AXIS_MOTION;
-std::string events::types::BUTTON_DOWN;
-std::string events::types::BUTTON_UP;
-std::string events::types::BALL_MOTION;
-std::string events::types::HAT_MOTION;
-std::string events::types::POWER_UPDATE;
-std::string events::types::STEAM_HANDLE_UPDATE;
-std::string events::types::REMAP;
-std::string events::types::UPDATE;
+static Napi::Env *poll_env = nullptr;
+static Napi::Array *poll_extras = nullptr;
+static Napi::Function *poll_flush = nullptr;
+static double *poll_records = nullptr;
+static size_t poll_capacity = 0;
+static size_t poll_count = 0;
+static size_t poll_flushed = 0;
+static size_t poll_coalescable = 0;
+static bool is_polling = false;
 
+static std::map<int, std::set<int>> coalesced_ids;
+static uint32_t enabled_families = ~(uint32_t) 0;
+static bool is_keeping_families = false;
 
-static Napi::Env *poll_env = nullptr;
-static Napi::Function *poll_callback = nullptr;
+static Uint64 clock_counter_base = 0;
+static Uint32 clock_ticks_base = 0;
+static double clock_hrtime_base = 0;
+static double clock_ms_per_count = 0;
+static double event_timestamp = 0;
+
+// SDL only stamps events with SDL_GetTicks(), in whole milliseconds, so
+// our event filter also notes the performance counter when each one is
+// queued. They are kept in queue order and matched to the events as they
+// are polled, by type and ticks.
+struct QueuedEvent {
+	Uint32 type;
+	Uint32 ticks;
+	Uint64 counter;
+};
+
+#define QUEUED_EVENTS_SIZE 4096
+// Events that never made it into the queue leave entries behind that get
+// skipped, but only this far ahead.
+#define QUEUED_EVENTS_SEARCH 64
+
+static QueuedEvent queued_events[QUEUED_EVENTS_SIZE];
+static Uint64 queued_events_head = 0;
+static Uint64 queued_events_tail = 0;
+static SDL_SpinLock queued_events_lock = 0;
+
+struct WindowLatency {
+	Histogram histograms[events::latency::KINDS];
+};
+
+static std::map<int, WindowLatency> latencies;
+
+static Napi::ThreadSafeFunction wakeup_callback;
+static std::atomic<bool> wakeup_pending(false);
+static bool is_watching = false;
+static SDL_threadID watch_thread_id;
+static uv_poll_t connection_poll;
+static uv_prepare_t connection_prepare;
+static bool is_watching_connection = false;
+
+// The display connection libraries are already loaded by SDL, so their
+// functions are looked up at runtime instead of linking against them.
+static void *connection_library = nullptr;
+static void *connection_display = nullptr;
+static int (*x11_events_queued)(void *, int) = nullptr;
+static int (*wl_prepare_read)(void *) = nullptr;
+static void (*wl_cancel_read)(void *) = nullptr;
+
+static double
+getCounterTimestamp (Uint64 counter)
+{
+	// SDL's performance counter is mapped onto libuv's clock once, so that
+	// timestamps can be compared with process.hrtime() from JS.
+	if (clock_ms_per_count == 0) {
+		clock_counter_base = SDL_GetPerformanceCounter();
+		clock_ticks_base = SDL_GetTicks();
+		clock_hrtime_base = uv_hrtime() / 1e6;
+		clock_ms_per_count = 1e3 / SDL_GetPerformanceFrequency();
+	}
+
+	// Events can be stamped before the clocks were mapped
+	Sint64 elapsed = (Sint64) (counter - clock_counter_base);
+	return clock_hrtime_base + elapsed * clock_ms_per_count;
+}
+
+static double
+getTimestamp ()
+{
+	return getCounterTimestamp(SDL_GetPerformanceCounter());
+}
 
 void
-events::dispatchEvent(const SDL_Event &event)
+events::stampEvent (const SDL_Event &event)
+{
+	Uint64 counter = SDL_GetPerformanceCounter();
+
+	// Events can be pushed from any thread
+	SDL_AtomicLock(&queued_events_lock);
+	queued_events[queued_events_tail % QUEUED_EVENTS_SIZE] = { event.type, event.common.timestamp, counter };
+	queued_events_tail++;
+	if (queued_events_tail - queued_events_head > QUEUED_EVENTS_SIZE) {
+		queued_events_head = queued_events_tail - QUEUED_EVENTS_SIZE;
+	}
+	SDL_AtomicUnlock(&queued_events_lock);
+}
+
+// Returns when the event was queued, for an event that was just taken off
+// the queue.
+static double
+getEventTimestamp (const SDL_Event &event)
+{
+	bool is_stamped = false;
+	Uint64 counter = 0;
+	SDL_AtomicLock(&queued_events_lock);
+	Uint64 end = std::min(queued_events_tail, queued_events_head + QUEUED_EVENTS_SEARCH);
+	for (Uint64 index = queued_events_head; index < end; index++) {
+		const QueuedEvent &entry = queued_events[index % QUEUED_EVENTS_SIZE];
+		if (entry.type != event.type || entry.ticks != event.common.timestamp) { continue; }
+		counter = entry.counter;
+		queued_events_head = index + 1;
+		is_stamped = true;
+		break;
+	}
+	SDL_AtomicUnlock(&queued_events_lock);
+
+	if (is_stamped) { return getCounterTimestamp(counter); }
+
+	// Events that didn't go through SDL_PushEvent only have SDL's ticks.
+	// They are whole milliseconds, so the result is never allowed to be
+	// later than the moment we read the event.
+	double now = getTimestamp();
+	Uint32 elapsed = event.common.timestamp - clock_ticks_base;
+	return std::min(now, clock_hrtime_base + elapsed);
+}
+
+static double *
+beginRecord (int family, int type, double id)
+{
+	double *record = poll_records + poll_count * events::record::SIZE;
+	record[events::record::FAMILY] = family;
+	record[events::record::TYPE] = type;
+	record[events::record::ID] = id;
+	record[events::record::EXTRA] = -1;
+	record[events::record::MERGED] = 1;
+	record[events::record::TIMESTAMP] = event_timestamp;
+	return record;
+}
+
+static void
+setExtra (double *record, Napi::Value value)
+{
+	uint32_t index = poll_extras->Length();
+	poll_extras->Set(index, value);
+	record[events::record::EXTRA] = index;
+}
+
+static bool
+isFamilyEnabled (int family)
+{
+	return (enabled_families & (1u << family)) != 0;
+}
+
+// Returns the family of events that SDL stops queueing while the family has
+// no listeners, or 0 for events that are always queued.
+static int
+getIgnorableFamily (Uint32 type)
+{
+	switch (type) {
+		case SDL_KEYDOWN:
+		case SDL_KEYUP:
+			return events::families::KEYBOARD;
+		case SDL_TEXTINPUT:
+			return events::families::TEXT;
+		case SDL_MOUSEMOTION:
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+		case SDL_MOUSEWHEEL:
+			return events::families::MOUSE;
+		case SDL_FINGERDOWN:
+		case SDL_FINGERUP:
+		case SDL_FINGERMOTION:
+			return events::families::TOUCH;
+		case SDL_DROPBEGIN:
+		case SDL_DROPCOMPLETE:
+		case SDL_DROPFILE:
+		case SDL_DROPTEXT:
+			return events::families::DROP;
+		case SDL_KEYMAPCHANGED:
+			return events::families::KEYMAP;
+		case SDL_CLIPBOARDUPDATE:
+			return events::families::CLIPBOARD;
+		case SDL_SENSORUPDATE:
+			return events::families::SENSOR;
+	}
+	return 0;
+}
+
+static bool
+packEvent (const SDL_Event &event, double timestamp)
 {
-	if (poll_env == nullptr) { return; }
 	Napi::Env &env = *poll_env;
+	double *data;
+
+	// SDL still queues these while the families are kept enabled
+	int ignorable_family = getIgnorableFamily(event.type);
+	if (ignorable_family != 0 && !isFamilyEnabled(ignorable_family)) { return false; }
 
-	Napi::Object packed = Napi::Object::New(env);
+	event_timestamp = timestamp;
 
 	switch (event.type) {
 		case SDL_QUIT: {
-			packed.Set("family", events::families::APP);
-			packed.Set("type", events::types::QUIT);
-			break;
+			beginRecord(events::families::APP, events::types::QUIT, 0);
+			return true;
 		}
 
 		case SDL_DISPLAYEVENT: {
-			packed.Set("family", events::families::DISPLAY);
-
 			int display_index = event.display.display;
-			packed.Set("displayIndex", display_index);
 
 			switch (event.display.event) {
-				case SDL_DISPLAYEVENT_CONNECTED: { packed.Set("type", events::types::DISPLAY_ADD); break; }
-				case SDL_DISPLAYEVENT_DISCONNECTED: { packed.Set("type", events::types::DISPLAY_REMOVE); break; }
+				case SDL_DISPLAYEVENT_CONNECTED: {
+					beginRecord(events::families::DISPLAY, events::types::DISPLAY_ADD, display_index);
+					return true;
+				}
+				case SDL_DISPLAYEVENT_DISCONNECTED: {
+					beginRecord(events::families::DISPLAY, events::types::DISPLAY_REMOVE, display_index);
+					return true;
+				}
 				case SDL_DISPLAYEVENT_ORIENTATION: {
-					packed.Set("type", events::types::DISPLAY_ORIENT);
-					packed.Set("orientation", video::orientations[(SDL_DisplayOrientation) event.display.data1]);
-					break;
+					data = beginRecord(events::families::DISPLAY, events::types::DISPLAY_ORIENT, display_index) + events::record::DATA;
+					data[0] = event.display.data1;
+					return true;
 				}
 				case SDL_DISPLAYEVENT_MOVED: {
-					packed.Set("type", events::types::DISPLAY_MOVE);
-
-					SDL_Rect rect;
+					SDL_Rect geometry, usable;
 
-					if(SDL_GetDisplayBounds(display_index, &rect) < 0) {
+					if(SDL_GetDisplayBounds(display_index, &geometry) < 0) {
 						std::ostringstream message;
 						message << "SDL_GetDisplayBounds(" << display_index << ") error: " << SDL_GetError();
 						SDL_ClearError();
 						throw Napi::Error::New(env, message.str());
 					}
-					packed.Set("geometryX", rect.x);
-					packed.Set("geometryY", rect.y);
 
-					if(SDL_GetDisplayUsableBounds(display_index, &rect) < 0) {
+					if(SDL_GetDisplayUsableBounds(display_index, &usable) < 0) {
 						std::ostringstream message;
 						message << "SDL_GetDisplayUsableBounds(" << display_index << ") error: " << SDL_GetError();
 						SDL_ClearError();
 						throw Napi::Error::New(env, message.str());
 					}
-					packed.Set("usableX", rect.x);
-					packed.Set("usableY", rect.y);
 
-					break;
+					data = beginRecord(events::families::DISPLAY, events::types::DISPLAY_MOVE, display_index) + events::record::DATA;
+					data[0] = geometry.x;
+					data[1] = geometry.y;
+					data[2] = usable.x;
+					data[3] = usable.y;
+					return true;
 				}
 			}
-			break;
+			return false;
 		}
 
 		case SDL_WINDOWEVENT: {
-			packed.Set("family", events::families::WINDOW);
-			packed.Set("windowId", event.window.windowID);
+			int window_id = event.window.windowID;
+			int type;
 
 			switch (event.window.event) {
-				case SDL_WINDOWEVENT_SHOWN: { packed.Set("type", events::types::SHOW); break; }
-				case SDL_WINDOWEVENT_HIDDEN: { packed.Set("type", events::types::HIDE); break; }
-				case SDL_WINDOWEVENT_EXPOSED: { packed.Set("type", events::types::EXPOSE); break; }
+				case SDL_WINDOWEVENT_SHOWN: { type = events::types::SHOW; break; }
+				case SDL_WINDOWEVENT_HIDDEN: { type = events::types::HIDE; break; }
+				case SDL_WINDOWEVENT_EXPOSED: { type = events::types::EXPOSE; break; }
 				case SDL_WINDOWEVENT_MOVED: {
-					packed.Set("type", events::types::MOVE);
-					packed.Set("x", event.window.data1);
-					packed.Set("y", event.window.data2);
-					break;
+					data = beginRecord(events::families::WINDOW, events::types::MOVE, window_id) + events::record::DATA;
+					data[0] = event.window.data1;
+					data[1] = event.window.data2;
+					return true;
 				}
 				case SDL_WINDOWEVENT_SIZE_CHANGED: {
-					SDL_Window *window = SDL_GetWindowFromID(event.window.windowID);
+					SDL_Window *window = SDL_GetWindowFromID(window_id);
 					if (window == nullptr) {
 						const char *error = SDL_GetError();
-						if (error == global::no_error) { return; }
+						if (error == global::no_error) { return false; }
 
 						std::ostringstream message;
 						message << "SDL_GetWindowFromID() error: " << SDL_GetError();
@@ -163,243 +301,242 @@ events::dispatchEvent(const SDL_Event &event)
 					int pixel_width, pixel_height;
 					SDL_GetWindowSizeInPixels(window, &pixel_width, &pixel_height);
 
-					packed.Set("type", events::types::RESIZE);
-					packed.Set("width", event.window.data1);
-					packed.Set("height", event.window.data2);
-					packed.Set("pixelWidth", pixel_width);
-					packed.Set("pixelHeight", pixel_height);
-					break;
+					data = beginRecord(events::families::WINDOW, events::types::RESIZE, window_id) + events::record::DATA;
+					data[0] = event.window.data1;
+					data[1] = event.window.data2;
+					data[2] = pixel_width;
+					data[3] = pixel_height;
+					return true;
 				}
 				case SDL_WINDOWEVENT_DISPLAY_CHANGED: {
-					packed.Set("type", events::types::DISPLAY_CHANGE);
-					packed.Set("displayIndex", event.window.data1);
-					break;
+					data = beginRecord(events::families::WINDOW, events::types::DISPLAY_CHANGE, window_id) + events::record::DATA;
+					data[0] = event.window.data1;
+					return true;
 				}
-				case SDL_WINDOWEVENT_MINIMIZED: { packed.Set("type", events::types::MINIMIZE); break; }
-				case SDL_WINDOWEVENT_MAXIMIZED: { packed.Set("type", events::types::MAXIMIZE); break; }
-				case SDL_WINDOWEVENT_RESTORED: { packed.Set("type", events::types::RESTORE); break; }
-				case SDL_WINDOWEVENT_FOCUS_GAINED: { packed.Set("type", events::types::FOCUS); break; }
-				case SDL_WINDOWEVENT_FOCUS_LOST: { packed.Set("type", events::types::BLUR); break; }
-				case SDL_WINDOWEVENT_ENTER: { packed.Set("type", events::types::HOVER); break; }
-				case SDL_WINDOWEVENT_LEAVE: { packed.Set("type", events::types::LEAVE); break; }
-				case SDL_WINDOWEVENT_CLOSE: { packed.Set("type", events::types::CLOSE); break; }
+				case SDL_WINDOWEVENT_MINIMIZED: { type = events::types::MINIMIZE; break; }
+				case SDL_WINDOWEVENT_MAXIMIZED: { type = events::types::MAXIMIZE; break; }
+				case SDL_WINDOWEVENT_RESTORED: { type = events::types::RESTORE; break; }
+				case SDL_WINDOWEVENT_FOCUS_GAINED: { type = events::types::FOCUS; break; }
+				case SDL_WINDOWEVENT_FOCUS_LOST: { type = events::types::BLUR; break; }
+				case SDL_WINDOWEVENT_ENTER: { type = events::types::HOVER; break; }
+				case SDL_WINDOWEVENT_LEAVE: { type = events::types::LEAVE; break; }
+				case SDL_WINDOWEVENT_CLOSE: { type = events::types::CLOSE; break; }
+				default: return false;
 			}
-			break;
+
+			beginRecord(events::families::WINDOW, type, window_id);
+			return true;
 		}
 
 		case SDL_DROPBEGIN:
 		case SDL_DROPCOMPLETE: {
-			packed.Set("family", events::families::DROP);
-			packed.Set("type", event.type == SDL_DROPBEGIN ? events::types::DROP_BEGIN : events::types::DROP_COMPLETE);
-			packed.Set("windowId", event.drop.windowID);
-			break;
+			beginRecord(
+				events::families::DROP,
+				event.type == SDL_DROPBEGIN
+					? events::types::DROP_BEGIN
+					: events::types::DROP_COMPLETE,
+				event.drop.windowID
+			);
+			return true;
 		}
 		case SDL_DROPFILE:
 		case SDL_DROPTEXT: {
-			packed.Set("family", events::families::DROP);
-			bool is_file = event.type == SDL_DROPFILE;
-			packed.Set("type", is_file ? events::types::DROP_FILE : events::types::DROP_TEXT);
-			packed.Set("windowId", event.drop.windowID);
-			packed.Set(is_file ? "file" : "text", event.drop.file);
-			break;
+			double *record = beginRecord(
+				events::families::DROP,
+				event.type == SDL_DROPFILE
+					? events::types::DROP_FILE
+					: events::types::DROP_TEXT,
+				event.drop.windowID
+			);
+			setExtra(record, Napi::String::New(env, event.drop.file));
+			return true;
 		}
 
 		case SDL_KEYDOWN:
 		case SDL_KEYUP: {
-			packed.Set("family", events::families::KEYBOARD);
-			packed.Set(
-				"type",
+			data = beginRecord(
+				events::families::KEYBOARD,
 				event.type == SDL_KEYDOWN
 					? events::types::KEY_DOWN
-					: events::types::KEY_UP
-			);
-			packed.Set("windowId", event.key.windowID);
+					: events::types::KEY_UP,
+				event.key.windowID
+			) + events::record::DATA;
 
 			SDL_Keysym symbol = event.key.keysym;
-			packed.Set("scancode", (int) symbol.scancode);
-
-			const char *name = SDL_GetKeyName(symbol.sym);
-			if (name[0] != '\0') {
-				packed.Set("key", name);
-			}
-			else {
-				packed.Set("key", env.Null());
-			}
-
-			if (event.type == SDL_KEYDOWN) {
-				packed.Set("repeat", !!event.key.repeat);
-			}
+			int modifiers = 0
+				| (symbol.mod & KMOD_ALT ? events::modifiers::ALT : 0)
+				| (symbol.mod & KMOD_CTRL ? events::modifiers::CTRL : 0)
+				| (symbol.mod & KMOD_SHIFT ? events::modifiers::SHIFT : 0)
+				| (symbol.mod & KMOD_GUI ? events::modifiers::SUPER : 0)
+				| (symbol.mod & KMOD_MODE ? events::modifiers::ALTGR : 0)
+				| (symbol.mod & KMOD_NUM ? events::modifiers::NUMLOCK : 0)
+				| (symbol.mod & KMOD_CAPS ? events::modifiers::CAPSLOCK : 0);
 
-			packed.Set("alt", !!(symbol.mod & KMOD_ALT));
-			packed.Set("ctrl", !!(symbol.mod & KMOD_CTRL));
-			packed.Set("shift", !!(symbol.mod & KMOD_SHIFT));
-			packed.Set("super", !!(symbol.mod & KMOD_GUI));
-			packed.Set("altgr", !!(symbol.mod & KMOD_MODE));
-			packed.Set("numlock", !!(symbol.mod & KMOD_NUM));
-			packed.Set("capslock", !!(symbol.mod & KMOD_CAPS));
-			break;
+			data[0] = symbol.scancode;
+			data[1] = symbol.sym;
+			data[2] = event.key.repeat;
+			data[3] = modifiers;
+			return true;
 		}
 
 		case SDL_TEXTINPUT: {
-			packed.Set("family", events::families::TEXT);
-			packed.Set("type", events::types::TEXT_INPUT);
-			packed.Set("windowId", event.text.windowID);
-			packed.Set("text", event.text.text);
-			break;
+			double *record = beginRecord(events::families::TEXT, events::types::TEXT_INPUT, event.text.windowID);
+			setExtra(record, Napi::String::New(env, event.text.text));
+			return true;
 		}
 
 		case SDL_KEYMAPCHANGED: {
-			packed.Set("family", events::families::KEYMAP);
-			packed.Set("type", events::types::KEYMAP_CHANGE);
-			break;
+			beginRecord(events::families::KEYMAP, events::types::KEYMAP_CHANGE, 0);
+			return true;
 		}
 
 		case SDL_MOUSEMOTION: {
-			packed.Set("family", events::families::MOUSE);
-			packed.Set("type", events::types::MOUSE_MOVE);
-			packed.Set("windowId", event.motion.windowID);
-			packed.Set("touch", event.motion.which == SDL_TOUCH_MOUSEID);
-			packed.Set("x", event.motion.x);
-			packed.Set("y", event.motion.y);
-			break;
+			data = beginRecord(events::families::MOUSE, events::types::MOUSE_MOVE, event.motion.windowID) + events::record::DATA;
+			data[0] = event.motion.which == SDL_TOUCH_MOUSEID;
+			data[1] = event.motion.x;
+			data[2] = event.motion.y;
+			data[3] = event.motion.xrel;
+			data[4] = event.motion.yrel;
+			return true;
 		}
 		case SDL_MOUSEBUTTONDOWN:
 		case SDL_MOUSEBUTTONUP: {
-			packed.Set("family", events::families::MOUSE);
-			packed.Set(
-				"type",
+			data = beginRecord(
+				events::families::MOUSE,
 				event.type == SDL_MOUSEBUTTONDOWN
 					? events::types::MOUSE_BUTTON_DOWN
-					: events::types::MOUSE_BUTTON_UP
-			);
-			packed.Set("windowId", event.button.windowID);
-			packed.Set("touch", event.button.which == SDL_TOUCH_MOUSEID);
-			packed.Set("button", event.button.button);
-			packed.Set("x", event.button.x);
-			packed.Set("y", event.button.y);
-			break;
+					: events::types::MOUSE_BUTTON_UP,
+				event.button.windowID
+			) + events::record::DATA;
+			data[0] = event.button.which == SDL_TOUCH_MOUSEID;
+			data[1] = event.button.x;
+			data[2] = event.button.y;
+			data[3] = event.button.button;
+			return true;
 		}
 		case SDL_MOUSEWHEEL: {
-			packed.Set("family", events::families::MOUSE);
-			packed.Set("type", events::types::MOUSE_WHEEL);
-			packed.Set("windowId", event.wheel.windowID);
-			packed.Set("touch", event.wheel.which == SDL_TOUCH_MOUSEID);
-
 			int x, y;
 			SDL_GetMouseState(&x, &y);
-			packed.Set("x", x);
-			packed.Set("y", y);
 
-			packed.Set("dx", event.wheel.x);
-			packed.Set("dy", event.wheel.y);
-			packed.Set("flipped", event.wheel.direction);
-			break;
+			data = beginRecord(events::families::MOUSE, events::types::MOUSE_WHEEL, event.wheel.windowID) + events::record::DATA;
+			data[0] = event.wheel.which == SDL_TOUCH_MOUSEID;
+			data[1] = x;
+			data[2] = y;
+			data[3] = event.wheel.x;
+			data[4] = event.wheel.y;
+			data[5] = event.wheel.direction;
+			return true;
 		}
 
 		case SDL_FINGERUP:
-		case SDL_FINGERDOWN: {
-			packed.Set("family", events::families::TOUCH);
-			packed.Set("type", event.type == SDL_FINGERUP
-				? events::types::FINGER_UP
-				: events::types::FINGER_DOWN);
-			packed.Set("windowId", event.tfinger.windowID);
-			packed.Set("mouse", event.tfinger.touchId == SDL_MOUSE_TOUCHID);
-			packed.Set("touchId", event.tfinger.touchId);
-			packed.Set("fingerId", event.tfinger.fingerId);
-			packed.Set("x", event.tfinger.x);
-			packed.Set("y", event.tfinger.y);
-			packed.Set("pressure", event.tfinger.pressure);
-			break;
-		}
+		case SDL_FINGERDOWN:
 		case SDL_FINGERMOTION: {
-			packed.Set("family", events::families::TOUCH);
-			packed.Set("type", events::types::FINGER_MOVE);
-			packed.Set("windowId", event.tfinger.windowID);
-			packed.Set("mouse", event.tfinger.touchId == SDL_MOUSE_TOUCHID);
-			packed.Set("touchId", event.tfinger.touchId);
-			packed.Set("fingerId", event.tfinger.fingerId);
-			packed.Set("x", event.tfinger.x);
-			packed.Set("y", event.tfinger.y);
-			packed.Set("dx", event.tfinger.dx);
-			packed.Set("dy", event.tfinger.dy);
-			packed.Set("pressure", event.tfinger.pressure);
-			break;
+			data = beginRecord(
+				events::families::TOUCH,
+				event.type == SDL_FINGERMOTION
+					? events::types::FINGER_MOVE
+					: event.type == SDL_FINGERUP
+						? events::types::FINGER_UP
+						: events::types::FINGER_DOWN,
+				event.tfinger.windowID
+			) + events::record::DATA;
+			data[0] = event.tfinger.touchId == SDL_MOUSE_TOUCHID;
+			data[1] = event.tfinger.touchId;
+			data[2] = event.tfinger.fingerId;
+			data[3] = event.tfinger.x;
+			data[4] = event.tfinger.y;
+			data[5] = event.tfinger.dx;
+			data[6] = event.tfinger.dy;
+			data[7] = event.tfinger.pressure;
+			return true;
 		}
 
+		// Device events only describe the device that changed. JS keeps the
+		// list of devices and applies them as deltas.
 		case SDL_JOYDEVICEADDED: {
-			packed.Set("family", events::families::JOYSTICK_DEVICE);
-			packed.Set("type", events::types::DEVICE_ADD);
-			packed.Set("devices", joystick::_getDevices(env));
-			break;
+			int index = event.jdevice.which;
+			int joystick_id = SDL_JoystickGetDeviceInstanceID(index);
+			if (joystick_id == -1) {
+				// Already gone again, there will be a remove event for it
+				SDL_ClearError();
+				return false;
+			}
+
+			double *record = beginRecord(events::families::JOYSTICK_DEVICE, events::types::DEVICE_ADD, joystick_id);
+			setExtra(record, joystick::_getDevice(env, index));
+			return true;
 		}
 		case SDL_JOYDEVICEREMOVED: {
-			packed.Set("family", events::families::JOYSTICK_DEVICE);
-			packed.Set("type", events::types::DEVICE_REMOVE);
-			packed.Set("joystickId", event.jdevice.which);
-			packed.Set("devices", joystick::_getDevices(env));
-			break;
+			beginRecord(events::families::JOYSTICK_DEVICE, events::types::DEVICE_REMOVE, event.jdevice.which);
+			return true;
 		}
 
 		case SDL_JOYAXISMOTION: {
-			packed.Set("family", events::families::JOYSTICK);
-			packed.Set("type", events::types::AXIS_MOTION);
+			if (!isFamilyEnabled(events::families::JOYSTICK)) { return false; }
 
 			int joystick_id = event.jaxis.which;
-			SDL_Joystick *joystick = SDL_JoystickFromInstanceID(joystick_id);
-			if (joystick == nullptr) {
-				std::ostringstream message;
-				message << "SDL_JoystickFromInstanceID(" << joystick_id << ") error: " << SDL_GetError();
-				SDL_ClearError();
-				throw Napi::Error::New(env, message.str());
+			double value;
+
+			const joystick::AxisCalibration *calibration = joystick::findCalibration(joystick_id, event.jaxis.axis);
+			if (calibration != nullptr) {
+				value = joystick::mapAxisValue(*calibration, event.jaxis.value);
+			}
+			else {
+				SDL_Joystick *joystick = SDL_JoystickFromInstanceID(joystick_id);
+				if (joystick == nullptr) {
+					std::ostringstream message;
+					message << "SDL_JoystickFromInstanceID(" << joystick_id << ") error: " << SDL_GetError();
+					SDL_ClearError();
+					throw Napi::Error::New(env, message.str());
+				}
+				value = joystick::mapAxisValue(joystick, event.jaxis.axis, event.jaxis.value);
 			}
 
-			packed.Set("joystickId", joystick_id);
-			packed.Set("axis", event.jaxis.axis);
-			packed.Set("value", joystick::mapAxisValue(joystick, event.jaxis.axis, event.jaxis.value));
-			break;
+			data = beginRecord(events::families::JOYSTICK, events::types::AXIS_MOTION, joystick_id) + events::record::DATA;
+			data[0] = event.jaxis.axis;
+			data[1] = value;
+			return true;
 		}
 		case SDL_JOYBALLMOTION: {
-			packed.Set("family", events::families::JOYSTICK);
-			packed.Set("type", events::types::BALL_MOTION);
-			packed.Set("joystickId", event.jball.which);
-			packed.Set("ball", event.jball.ball);
-			packed.Set("x", event.jball.xrel);
-			packed.Set("y", event.jball.yrel);
-			break;
+			if (!isFamilyEnabled(events::families::JOYSTICK)) { return false; }
+
+			data = beginRecord(events::families::JOYSTICK, events::types::BALL_MOTION, event.jball.which) + events::record::DATA;
+			data[0] = event.jball.ball;
+			data[1] = event.jball.xrel;
+			data[2] = event.jball.yrel;
+			return true;
 		}
 		case SDL_JOYBUTTONDOWN:
 		case SDL_JOYBUTTONUP: {
-			packed.Set("family", events::families::JOYSTICK);
-			packed.Set(
-				"type",
+			if (!isFamilyEnabled(events::families::JOYSTICK)) { return false; }
+
+			data = beginRecord(
+				events::families::JOYSTICK,
 				event.type == SDL_JOYBUTTONDOWN
 					? events::types::BUTTON_DOWN
-					: events::types::BUTTON_UP
-			);
-			packed.Set("joystickId", event.jbutton.which);
-			packed.Set("button", event.jbutton.button);
-			break;
+					: events::types::BUTTON_UP,
+				event.jbutton.which
+			) + events::record::DATA;
+			data[0] = event.jbutton.button;
+			return true;
 		}
 		case SDL_JOYHATMOTION: {
-			packed.Set("family", events::families::JOYSTICK);
-			packed.Set("type", events::types::HAT_MOTION);
-			packed.Set("joystickId", event.jhat.which);
-			packed.Set("hat", event.jhat.hat);
-			packed.Set("value", joystick::hat_positions[event.jhat.value]);
-			break;
+			if (!isFamilyEnabled(events::families::JOYSTICK)) { return false; }
+
+			data = beginRecord(events::families::JOYSTICK, events::types::HAT_MOTION, event.jhat.which) + events::record::DATA;
+			data[0] = event.jhat.hat;
+			data[1] = event.jhat.value;
+			return true;
 		}
 
 		case SDL_JOYBATTERYUPDATED: {
-			packed.Set("family", events::families::JOYSTICK);
-			packed.Set("type", events::types::POWER_UPDATE);
-			packed.Set("joystickId", event.jbattery.which);
-			packed.Set("power", joystick::mapPowerLevel(env, event.jbattery.level));
-			break;
+			data = beginRecord(events::families::JOYSTICK, events::types::POWER_UPDATE, event.jbattery.which) + events::record::DATA;
+			data[0] = event.jbattery.level;
+			return true;
 		}
 
 		case SDL_CONTROLLERSTEAMHANDLEUPDATED: {
-			packed.Set("family", events::families::CONTROLLER);
-			packed.Set("type", events::types::REMAP);
+			if (!isFamilyEnabled(events::families::CONTROLLER)) { return false; }
 
 			SDL_JoystickID controller_id = event.cdevice.which;
 			SDL_GameController *controller = SDL_GameControllerFromInstanceID(controller_id);
@@ -410,14 +547,13 @@ events::dispatchEvent(const SDL_Event &event)
 				throw Napi::Error::New(env, message.str());
 			}
 
-			packed.Set("controllerId", controller_id);
-			packed.Set("steamHandle", controller::getSteamHandle(env, controller));
-			break;
+			double *record = beginRecord(events::families::CONTROLLER, events::types::STEAM_HANDLE_UPDATE, controller_id);
+			setExtra(record, controller::getSteamHandle(env, controller));
+			return true;
 		}
 
 		case SDL_CONTROLLERDEVICEREMAPPED: {
-			packed.Set("family", events::families::CONTROLLER);
-			packed.Set("type", events::types::REMAP);
+			if (!isFamilyEnabled(events::families::CONTROLLER)) { return false; }
 
 			SDL_JoystickID controller_id = event.cdevice.which;
 			SDL_GameController *controller = SDL_GameControllerFromInstanceID(controller_id);
@@ -428,79 +564,234 @@ events::dispatchEvent(const SDL_Event &event)
 				throw Napi::Error::New(env, message.str());
 			}
 
-			packed.Set("controllerId", controller_id);
-			controller::getState(env, controller, packed);
-			break;
+			controller::recalibrate(controller);
+
+			Napi::Object state = Napi::Object::New(env);
+			controller::getState(env, controller, state);
+
+			double *record = beginRecord(events::families::CONTROLLER, events::types::REMAP, controller_id);
+			setExtra(record, state);
+			return true;
 		}
 
 		case SDL_CONTROLLERAXISMOTION: {
-			packed.Set("family", events::families::CONTROLLER);
-			packed.Set("type", events::types::AXIS_MOTION);
+			if (!isFamilyEnabled(events::families::CONTROLLER)) { return false; }
 
 			int controller_id = event.caxis.which;
-			SDL_GameController *controller = SDL_GameControllerFromInstanceID(controller_id);
-			if (controller == nullptr) {
-				std::ostringstream message;
-				message << "SDL_GameControllerFromInstanceID(" << controller_id << ") error: " << SDL_GetError();
-				SDL_ClearError();
-				throw Napi::Error::New(env, message.str());
-			}
 			SDL_GameControllerAxis axis = (SDL_GameControllerAxis) event.caxis.axis;
+			double value;
 
-			packed.Set("controllerId", controller_id);
-			packed.Set("axis", controller::axes[axis]);
-			packed.Set("value", controller::mapAxisValue(controller, axis, event.caxis.value));
-			break;
+			auto it = controller::calibrations.find(controller_id);
+			if (it != controller::calibrations.end() && axis < SDL_CONTROLLER_AXIS_MAX) {
+				value = joystick::mapAxisValue(it->second.axes[axis], event.caxis.value);
+			}
+			else {
+				SDL_GameController *controller = SDL_GameControllerFromInstanceID(controller_id);
+				if (controller == nullptr) {
+					std::ostringstream message;
+					message << "SDL_GameControllerFromInstanceID(" << controller_id << ") error: " << SDL_GetError();
+					SDL_ClearError();
+					throw Napi::Error::New(env, message.str());
+				}
+				value = controller::mapAxisValue(controller, axis, event.caxis.value);
+			}
+
+			data = beginRecord(events::families::CONTROLLER, events::types::AXIS_MOTION, controller_id) + events::record::DATA;
+			data[0] = axis;
+			data[1] = value;
+			return true;
 		}
 		case SDL_CONTROLLERBUTTONDOWN:
 		case SDL_CONTROLLERBUTTONUP: {
-			packed.Set("family", events::families::CONTROLLER);
-			packed.Set(
-				"type",
+			if (!isFamilyEnabled(events::families::CONTROLLER)) { return false; }
+
+			data = beginRecord(
+				events::families::CONTROLLER,
 				event.type == SDL_CONTROLLERBUTTONDOWN
 					? events::types::BUTTON_DOWN
-					: events::types::BUTTON_UP
-			);
-			packed.Set("controllerId", event.cbutton.which);
-			packed.Set("button", controller::buttons[(SDL_GameControllerButton) event.cbutton.button]);
-			break;
+					: events::types::BUTTON_UP,
+				event.cbutton.which
+			) + events::record::DATA;
+			data[0] = event.cbutton.button;
+			return true;
 		}
 
 		case SDL_SENSORUPDATE: {
-			packed.Set("family", events::families::SENSOR);
-			packed.Set("type", events::types::UPDATE);
-			packed.Set("sensorId", event.sensor.which);
-			break;
+			beginRecord(events::families::SENSOR, events::types::UPDATE, event.sensor.which);
+			return true;
 		}
 
-		case SDL_AUDIODEVICEADDED: {
-			packed.Set("family", events::families::AUDIO_DEVICE);
-			packed.Set("type", events::types::DEVICE_ADD);
-			bool is_capture = event.adevice.iscapture;
-			packed.Set("audioDeviceType", audio::device_types[is_capture]);
-			packed.Set("devices", audio::_getDevices(env, is_capture));
-			break;
-		}
+		case SDL_AUDIODEVICEADDED:
 		case SDL_AUDIODEVICEREMOVED: {
-			packed.Set("family", events::families::AUDIO_DEVICE);
-			packed.Set("type", events::types::DEVICE_REMOVE);
-
 			bool is_capture = event.adevice.iscapture;
+			bool is_add = event.type == SDL_AUDIODEVICEADDED;
 
-			packed.Set("audioId", event.adevice.which);
-			packed.Set("audioDeviceType", audio::device_types[is_capture]);
-			packed.Set("devices", audio::_getDevices(env, is_capture));
-			break;
+			if (is_add && (int) event.adevice.which >= SDL_GetNumAudioDevices(is_capture)) {
+				// Already gone again, the list will get fixed up on removal
+				return false;
+			}
+
+			double *record = beginRecord(
+				events::families::AUDIO_DEVICE,
+				is_add
+					? events::types::DEVICE_ADD
+					: events::types::DEVICE_REMOVE,
+				is_add ? 0 : event.adevice.which
+			);
+			record[events::record::DATA] = is_capture;
+
+			// SDL only reports removals for devices that are open, so removals
+			// still re-enumerate to also catch any others that went away.
+			setExtra(record, is_add
+				? (Napi::Value) audio::_getDevice(env, event.adevice.which, is_capture)
+				: (Napi::Value) audio::_getDevices(env, is_capture));
+			return true;
 		}
 
 		case SDL_CLIPBOARDUPDATE: {
-			packed.Set("family", events::families::CLIPBOARD);
-			packed.Set("type", events::types::UPDATE);
-			break;
+			beginRecord(events::families::CLIPBOARD, events::types::UPDATE, 0);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool
+isCoalesced (int family, int id)
+{
+	if (coalesced_ids.empty()) { return false; }
+
+	auto it = coalesced_ids.find(family);
+	return it != coalesced_ids.end() && it->second.count(id) != 0;
+}
+
+// Tries to merge the record that was just packed into an earlier record from
+// the same source. Only the trailing run of coalescable records is searched,
+// so motion never gets merged across a button press or any other event.
+static bool
+coalesceRecord ()
+{
+	double *record = poll_records + poll_count * events::record::SIZE;
+	int family = record[events::record::FAMILY];
+	int type = record[events::record::TYPE];
+	int id = record[events::record::ID];
+
+	int owner;
+	switch (family) {
+		case events::families::MOUSE: { owner = type == events::types::MOUSE_MOVE ? events::families::WINDOW : 0; break; }
+		case events::families::TOUCH: { owner = type == events::types::FINGER_MOVE ? events::families::WINDOW : 0; break; }
+		case events::families::JOYSTICK:
+		case events::families::CONTROLLER: { owner = type == events::types::AXIS_MOTION ? family : 0; break; }
+		default: { owner = 0; }
+	}
+
+	if (owner == 0 || !isCoalesced(owner, id)) {
+		poll_coalescable = poll_count + 1;
+		return false;
+	}
+
+	double *data = record + events::record::DATA;
+	size_t start = std::max(poll_coalescable, poll_flushed);
+	for (size_t index = start; index < poll_count; index++) {
+		double *previous = poll_records + index * events::record::SIZE;
+		if (previous[events::record::FAMILY] != family) { continue; }
+		if (previous[events::record::TYPE] != type) { continue; }
+		if (previous[events::record::ID] != id) { continue; }
+
+		double *previous_data = previous + events::record::DATA;
+		switch (family) {
+			case events::families::MOUSE: {
+				// Moves synthesized from touch keep their flag
+				if (previous_data[0] != data[0]) { continue; }
+				previous_data[1] = data[1];
+				previous_data[2] = data[2];
+				previous_data[3] += data[3];
+				previous_data[4] += data[4];
+				break;
+			}
+			case events::families::TOUCH: {
+				if (previous_data[1] != data[1] || previous_data[2] != data[2]) { continue; }
+				previous_data[3] = data[3];
+				previous_data[4] = data[4];
+				previous_data[5] += data[5];
+				previous_data[6] += data[6];
+				previous_data[7] = data[7];
+				break;
+			}
+			default: {
+				if (previous_data[0] != data[0]) { continue; }
+				previous_data[1] = data[1];
+			}
 		}
+
+		previous[events::record::MERGED] += record[events::record::MERGED];
+		previous[events::record::TIMESTAMP] = record[events::record::TIMESTAMP];
+		return true;
 	}
 
-	poll_callback->Call(poll_env->Global(), { packed });
+	return false;
+}
+
+static void
+commitRecord ()
+{
+	if (!coalesceRecord()) { poll_count++; }
+}
+
+static void
+flush ()
+{
+	// Records that are already being handled further up the stack must not be
+	// overwritten, so nested flushes only ever see the records packed after them.
+	size_t start = poll_flushed;
+	size_t end = poll_count;
+	if (start == end) { return; }
+
+	poll_flushed = end;
+	poll_flush->Call(poll_env->Global(), {
+		Napi::Number::New(*poll_env, start),
+		Napi::Number::New(*poll_env, end),
+	});
+	poll_count = poll_flushed = poll_coalescable = start;
+}
+
+static void
+resetPoll ()
+{
+	poll_env = nullptr;
+	poll_extras = nullptr;
+	poll_flush = nullptr;
+	poll_records = nullptr;
+	poll_capacity = 0;
+	poll_count = 0;
+	poll_flushed = 0;
+	poll_coalescable = 0;
+	is_polling = false;
+}
+
+void
+events::dispatchEvent(const SDL_Event &event)
+{
+	if (poll_env == nullptr) { return; }
+
+	// This runs inside SDL's event filter, possibly while the main thread
+	// holds the renderer locks. JS must not run with them held.
+	int lock_depth = render_thread::suspendLock();
+	try {
+		if (poll_count == poll_capacity) { flush(); }
+		// The event is still in the queue, so it will be picked up again later.
+		if (poll_count != poll_capacity) {
+			// The event is being queued right now
+			if (packEvent(event, getTimestamp())) { commitRecord(); }
+			flush();
+		}
+	}
+	catch (...) {
+		render_thread::resumeLock(lock_depth);
+		throw;
+	}
+	render_thread::resumeLock(lock_depth);
 }
 
 Napi::Value
@@ -508,16 +799,605 @@ events::poll (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	Napi::Function callback = info[0].As<Napi::Function>();
+	Napi::Float64Array records = info[0].As<Napi::Float64Array>();
+	Napi::Array extras = info[1].As<Napi::Array>();
+	Napi::Function callback = info[2].As<Napi::Function>();
 
 	poll_env = &env;
-	poll_callback = &callback;
+	poll_extras = &extras;
+	poll_flush = &callback;
+	poll_records = records.Data();
+	poll_capacity = records.ElementLength() / events::record::SIZE;
+	poll_count = 0;
+	poll_flushed = 0;
+	poll_coalescable = 0;
+	is_polling = true;
 
 	SDL_Event event;
-	while (SDL_PollEvent(&event)) { events::dispatchEvent(event); }
+	try {
+		// Pumping sends window events, see RendererLock
+		RendererLock lock;
+		while (poll_count < poll_capacity && SDL_PollEvent(&event)) {
+			// Every event takes its stamp, even the ones that aren't packed
+			bool packed = packEvent(event, getEventTimestamp(event));
 
-	poll_env = nullptr;
-	poll_callback = nullptr;
+			if (event.type == SDL_DROPFILE || event.type == SDL_DROPTEXT) {
+				SDL_free(event.drop.file);
+			}
+
+			if (packed) { commitRecord(); }
+		}
+	}
+	catch (...) {
+		resetPoll();
+		throw;
+	}
+
+	size_t count = poll_count;
+	resetPoll();
+
+	return Napi::Number::New(env, count);
+}
+
+static Sint16
+unmapAxisValue (double value)
+{
+	value = std::max(-1.0, std::min(1.0, value));
+	return value < 0
+		? value * -SDL_JOYSTICK_AXIS_MIN
+		: value * SDL_JOYSTICK_AXIS_MAX;
+}
+
+// The inverse of packEvent, for the families that can be injected. Device
+// events are checked against open instances, so that packing them later on
+// doesn't fail.
+static bool
+unpackEvent (Napi::Env &env, const double *record, SDL_Event &event)
+{
+	int family = record[events::record::FAMILY];
+	int type = record[events::record::TYPE];
+	int id = record[events::record::ID];
+	const double *data = record + events::record::DATA;
+
+	SDL_zero(event);
+	Uint32 timestamp = SDL_GetTicks();
+
+	switch (family) {
+		case events::families::KEYBOARD: {
+			if (type != events::types::KEY_DOWN && type != events::types::KEY_UP) { return false; }
+			bool pressed = type == events::types::KEY_DOWN;
+			int modifiers = data[3];
+
+			event.type = pressed ? SDL_KEYDOWN : SDL_KEYUP;
+			event.key.timestamp = timestamp;
+			event.key.windowID = id;
+			event.key.state = pressed ? SDL_PRESSED : SDL_RELEASED;
+			event.key.repeat = data[2];
+			event.key.keysym.scancode = (SDL_Scancode) data[0];
+			event.key.keysym.sym = SDL_GetKeyFromScancode(event.key.keysym.scancode);
+			event.key.keysym.mod = 0
+				| (modifiers & events::modifiers::ALT ? KMOD_LALT : 0)
+				| (modifiers & events::modifiers::CTRL ? KMOD_LCTRL : 0)
+				| (modifiers & events::modifiers::SHIFT ? KMOD_LSHIFT : 0)
+				| (modifiers & events::modifiers::SUPER ? KMOD_LGUI : 0)
+				| (modifiers & events::modifiers::ALTGR ? KMOD_MODE : 0)
+				| (modifiers & events::modifiers::NUMLOCK ? KMOD_NUM : 0)
+				| (modifiers & events::modifiers::CAPSLOCK ? KMOD_CAPS : 0);
+			return true;
+		}
+
+		case events::families::MOUSE: {
+			switch (type) {
+				case events::types::MOUSE_MOVE: {
+					event.type = SDL_MOUSEMOTION;
+					event.motion.timestamp = timestamp;
+					event.motion.windowID = id;
+					event.motion.x = data[1];
+					event.motion.y = data[2];
+					event.motion.xrel = data[3];
+					event.motion.yrel = data[4];
+					return true;
+				}
+				case events::types::MOUSE_BUTTON_DOWN:
+				case events::types::MOUSE_BUTTON_UP: {
+					bool pressed = type == events::types::MOUSE_BUTTON_DOWN;
+					event.type = pressed ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+					event.button.timestamp = timestamp;
+					event.button.windowID = id;
+					event.button.state = pressed ? SDL_PRESSED : SDL_RELEASED;
+					event.button.clicks = 1;
+					event.button.x = data[1];
+					event.button.y = data[2];
+					event.button.button = data[3];
+					return true;
+				}
+				case events::types::MOUSE_WHEEL: {
+					event.type = SDL_MOUSEWHEEL;
+					event.wheel.timestamp = timestamp;
+					event.wheel.windowID = id;
+					event.wheel.x = data[3];
+					event.wheel.y = data[4];
+					event.wheel.preciseX = data[3];
+					event.wheel.preciseY = data[4];
+					event.wheel.direction = data[5];
+					event.wheel.mouseX = data[1];
+					event.wheel.mouseY = data[2];
+					return true;
+				}
+			}
+			return false;
+		}
+
+		case events::families::TOUCH: {
+			switch (type) {
+				case events::types::FINGER_DOWN: { event.type = SDL_FINGERDOWN; break; }
+				case events::types::FINGER_UP: { event.type = SDL_FINGERUP; break; }
+				case events::types::FINGER_MOVE: { event.type = SDL_FINGERMOTION; break; }
+				default: return false;
+			}
+			event.tfinger.timestamp = timestamp;
+			event.tfinger.windowID = id;
+			event.tfinger.touchId = data[1];
+			event.tfinger.fingerId = data[2];
+			event.tfinger.x = data[3];
+			event.tfinger.y = data[4];
+			event.tfinger.dx = data[5];
+			event.tfinger.dy = data[6];
+			event.tfinger.pressure = data[7];
+			return true;
+		}
+
+		case events::families::JOYSTICK: {
+			if (SDL_JoystickFromInstanceID(id) == nullptr) {
+				std::ostringstream message;
+				message << "SDL_JoystickFromInstanceID(" << id << ") error: " << SDL_GetError();
+				SDL_ClearError();
+				throw Napi::Error::New(env, message.str());
+			}
+
+			switch (type) {
+				case events::types::AXIS_MOTION: {
+					event.type = SDL_JOYAXISMOTION;
+					event.jaxis.timestamp = timestamp;
+					event.jaxis.which = id;
+					event.jaxis.axis = data[0];
+					event.jaxis.value = unmapAxisValue(data[1]);
+					return true;
+				}
+				case events::types::BALL_MOTION: {
+					event.type = SDL_JOYBALLMOTION;
+					event.jball.timestamp = timestamp;
+					event.jball.which = id;
+					event.jball.ball = data[0];
+					event.jball.xrel = data[1];
+					event.jball.yrel = data[2];
+					return true;
+				}
+				case events::types::BUTTON_DOWN:
+				case events::types::BUTTON_UP: {
+					bool pressed = type == events::types::BUTTON_DOWN;
+					event.type = pressed ? SDL_JOYBUTTONDOWN : SDL_JOYBUTTONUP;
+					event.jbutton.timestamp = timestamp;
+					event.jbutton.which = id;
+					event.jbutton.button = data[0];
+					event.jbutton.state = pressed ? SDL_PRESSED : SDL_RELEASED;
+					return true;
+				}
+				case events::types::HAT_MOTION: {
+					event.type = SDL_JOYHATMOTION;
+					event.jhat.timestamp = timestamp;
+					event.jhat.which = id;
+					event.jhat.hat = data[0];
+					event.jhat.value = data[1];
+					return true;
+				}
+			}
+			return false;
+		}
+
+		case events::families::CONTROLLER: {
+			if (SDL_GameControllerFromInstanceID(id) == nullptr) {
+				std::ostringstream message;
+				message << "SDL_GameControllerFromInstanceID(" << id << ") error: " << SDL_GetError();
+				SDL_ClearError();
+				throw Napi::Error::New(env, message.str());
+			}
+
+			switch (type) {
+				case events::types::AXIS_MOTION: {
+					event.type = SDL_CONTROLLERAXISMOTION;
+					event.caxis.timestamp = timestamp;
+					event.caxis.which = id;
+					event.caxis.axis = data[0];
+					event.caxis.value = unmapAxisValue(data[1]);
+					return true;
+				}
+				case events::types::BUTTON_DOWN:
+				case events::types::BUTTON_UP: {
+					bool pressed = type == events::types::BUTTON_DOWN;
+					event.type = pressed ? SDL_CONTROLLERBUTTONDOWN : SDL_CONTROLLERBUTTONUP;
+					event.cbutton.timestamp = timestamp;
+					event.cbutton.which = id;
+					event.cbutton.button = data[0];
+					event.cbutton.state = pressed ? SDL_PRESSED : SDL_RELEASED;
+					return true;
+				}
+			}
+			return false;
+		}
+	}
+
+	return false;
+}
+
+Napi::Value
+events::push (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	Napi::Float64Array records = info[0].As<Napi::Float64Array>();
+	size_t count = info[1].As<Napi::Number>().Uint32Value();
+	count = std::min(count, records.ElementLength() / events::record::SIZE);
+
+	size_t pushed = 0;
+	SDL_Event event;
+	for (size_t index = 0; index < count; index++) {
+		const double *record = records.Data() + index * events::record::SIZE;
+		if (!unpackEvent(env, record, event)) {
+			std::ostringstream message;
+			message << "invalid event at index " << index;
+			throw Napi::Error::New(env, message.str());
+		}
+
+		int result = SDL_PushEvent(&event);
+		if (result < 0) {
+			// The queue is full, the caller can retry once it has been polled
+			SDL_ClearError();
+			break;
+		}
+		pushed++;
+	}
+
+	return Napi::Number::New(env, pushed);
+}
+
+Napi::Value
+events::setCoalescing (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	int family = info[0].As<Napi::Number>().Int32Value();
+	int id = info[1].As<Napi::Number>().Int32Value();
+	bool enabled = info[2].As<Napi::Boolean>().Value();
+
+	if (enabled) {
+		coalesced_ids[family].insert(id);
+	}
+	else {
+		auto it = coalesced_ids.find(family);
+		if (it != coalesced_ids.end()) {
+			it->second.erase(id);
+			if (it->second.empty()) { coalesced_ids.erase(it); }
+		}
+	}
+
+	return env.Undefined();
+}
+
+// Events from these families are only of interest to listeners, so SDL can
+// stop queueing them altogether. Joystick and controller events are also
+// used by SDL internally, so those just get skipped while packing. The same
+// goes for all families while a trace is recording, because ignored events
+// never reach the event filter that records them.
+static void
+setFamilyEventState (int family, int state)
+{
+	switch (family) {
+		case events::families::KEYBOARD: {
+			SDL_EventState(SDL_KEYDOWN, state);
+			SDL_EventState(SDL_KEYUP, state);
+			break;
+		}
+		case events::families::TEXT: {
+			SDL_EventState(SDL_TEXTINPUT, state);
+			break;
+		}
+		case events::families::MOUSE: {
+			SDL_EventState(SDL_MOUSEMOTION, state);
+			SDL_EventState(SDL_MOUSEBUTTONDOWN, state);
+			SDL_EventState(SDL_MOUSEBUTTONUP, state);
+			SDL_EventState(SDL_MOUSEWHEEL, state);
+			break;
+		}
+		case events::families::TOUCH: {
+			SDL_EventState(SDL_FINGERDOWN, state);
+			SDL_EventState(SDL_FINGERUP, state);
+			SDL_EventState(SDL_FINGERMOTION, state);
+			break;
+		}
+		case events::families::DROP: {
+			SDL_EventState(SDL_DROPBEGIN, state);
+			SDL_EventState(SDL_DROPCOMPLETE, state);
+			SDL_EventState(SDL_DROPFILE, state);
+			SDL_EventState(SDL_DROPTEXT, state);
+			break;
+		}
+		case events::families::KEYMAP: {
+			SDL_EventState(SDL_KEYMAPCHANGED, state);
+			break;
+		}
+		case events::families::CLIPBOARD: {
+			SDL_EventState(SDL_CLIPBOARDUPDATE, state);
+			break;
+		}
+		case events::families::SENSOR: {
+			SDL_EventState(SDL_SENSORUPDATE, state);
+			break;
+		}
+	}
+}
+
+Napi::Value
+events::setEnabledFamilies (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	uint32_t mask = info[0].As<Napi::Number>().Uint32Value();
+	uint32_t changed = mask ^ enabled_families;
+	enabled_families = mask;
+
+	if (is_keeping_families) { return env.Undefined(); }
+
+	for (int family = events::families::APP; family <= events::families::CLIPBOARD; family++) {
+		if ((changed & (1u << family)) == 0) { continue; }
+		setFamilyEventState(family, isFamilyEnabled(family) ? SDL_ENABLE : SDL_IGNORE);
+	}
+
+	return env.Undefined();
+}
+
+void
+events::keepAllFamilies (bool keep)
+{
+	if (keep == is_keeping_families) { return; }
+	is_keeping_families = keep;
+
+	for (int family = events::families::APP; family <= events::families::CLIPBOARD; family++) {
+		if (isFamilyEnabled(family)) { continue; }
+		setFamilyEventState(family, keep ? SDL_ENABLE : SDL_IGNORE);
+	}
+}
+
+Napi::Value
+events::addLatencySamples (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	int id = info[0].As<Napi::Number>().Int32Value();
+	int kind = info[1].As<Napi::Number>().Int32Value();
+	Napi::Float64Array samples = info[2].As<Napi::Float64Array>();
+	size_t count = info[3].As<Napi::Number>().Uint32Value();
+
+	if (kind < 0 || kind >= events::latency::KINDS) { return env.Undefined(); }
+
+	Histogram &histogram = latencies[id].histograms[kind];
+	const double *data = samples.Data();
+	count = std::min(count, samples.ElementLength());
+	for (size_t i = 0; i < count; i++) {
+		histogram::add(histogram, data[i]);
+	}
+
+	return env.Undefined();
+}
+
+Napi::Value
+events::getLatency (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	int id = info[0].As<Napi::Number>().Int32Value();
+
+	static const WindowLatency empty;
+	auto it = latencies.find(id);
+	const Histogram *histograms = it != latencies.end() ? it->second.histograms : empty.histograms;
+
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("pumpToDispatch", histogram::getStats(env, histograms[events::latency::PUMP_TO_DISPATCH]));
+	result.Set("dispatchToRender", histogram::getStats(env, histograms[events::latency::DISPATCH_TO_RENDER]));
+	return result;
+}
+
+Napi::Value
+events::resetLatency (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	int id = info[0].As<Napi::Number>().Int32Value();
+	latencies.erase(id);
+
+	return env.Undefined();
+}
+
+
+static void
+requestWakeup ()
+{
+	if (wakeup_pending.exchange(true)) { return; }
+
+	wakeup_callback.NonBlockingCall([](Napi::Env, Napi::Function callback) {
+		wakeup_pending = false;
+		callback.Call({});
+	});
+}
+
+static int
+watchEvents (void*, SDL_Event *)
+{
+	// Events that get added while we are polling will be picked up by the
+	// same call, so there is no need to schedule another one.
+	if (SDL_ThreadID() == watch_thread_id && is_polling) { return 1; }
+
+	requestWakeup();
+	return 1;
+}
+
+static void
+onConnectionReadable (uv_poll_t *, int status, int)
+{
+	if (status < 0) { return; }
+	requestWakeup();
+}
+
+static bool
+hasBufferedEvents ()
+{
+	if (x11_events_queued != nullptr) {
+		// 0 is QueuedAlready, which only looks at what Xlib has read
+		return x11_events_queued(connection_display, 0) > 0;
+	}
+
+	// Preparing to read fails while events are queued but not dispatched
+	if (wl_prepare_read(connection_display) != 0) { return true; }
+	wl_cancel_read(connection_display);
+	return false;
+}
+
+static void
+onConnectionPrepare (uv_prepare_t *)
+{
+	// Other calls into Xlib or libwayland, like the buffer swap in
+	// SDL_RenderPresent, also read from the connection. The events they read
+	// are queued on our side and leave the fd unreadable, so they are checked
+	// for right before the loop goes to sleep.
+	if (wakeup_pending || !hasBufferedEvents()) { return; }
+	requestWakeup();
+}
+
+static int
+loadConnection (const SDL_SysWMinfo &sys_wm_info)
+{
+	switch (sys_wm_info.subsystem) {
+		#if defined(SDL_VIDEO_DRIVER_X11)
+			case SDL_SYSWM_X11: {
+				connection_library = SDL_LoadObject("libX11.so.6");
+				if (connection_library == nullptr) { break; }
+				x11_events_queued = (int (*)(void *, int)) SDL_LoadFunction(connection_library, "XEventsQueued");
+				if (x11_events_queued == nullptr) { break; }
+				connection_display = sys_wm_info.info.x11.display;
+				return ConnectionNumber(sys_wm_info.info.x11.display);
+			}
+		#endif
+
+		#if defined(SDL_VIDEO_DRIVER_WAYLAND)
+			case SDL_SYSWM_WAYLAND: {
+				connection_library = SDL_LoadObject("libwayland-client.so.0");
+				if (connection_library == nullptr) { break; }
+				auto get_fd = (int (*)(void *)) SDL_LoadFunction(connection_library, "wl_display_get_fd");
+				wl_prepare_read = (int (*)(void *)) SDL_LoadFunction(connection_library, "wl_display_prepare_read");
+				wl_cancel_read = (void (*)(void *)) SDL_LoadFunction(connection_library, "wl_display_cancel_read");
+				if (get_fd == nullptr || wl_prepare_read == nullptr || wl_cancel_read == nullptr) { break; }
+				connection_display = sys_wm_info.info.wl.display;
+				return get_fd(connection_display);
+			}
+		#endif
+
+		default: break;
+	}
+
+	SDL_ClearError();
+	return -1;
+}
+
+static void
+unloadConnection ()
+{
+	if (connection_library != nullptr) { SDL_UnloadObject(connection_library); }
+	connection_library = nullptr;
+	connection_display = nullptr;
+	x11_events_queued = nullptr;
+	wl_prepare_read = nullptr;
+	wl_cancel_read = nullptr;
+}
+
+void
+events::watchConnection (Napi::Env &env, const SDL_SysWMinfo &sys_wm_info)
+{
+	if (!is_watching || is_watching_connection) { return; }
+
+	uv_loop_t *loop;
+	if (napi_get_uv_event_loop(env, &loop) != napi_ok) { return; }
+
+	int fd = loadConnection(sys_wm_info);
+	if (fd < 0) {
+		unloadConnection();
+		return;
+	}
+
+	if (uv_poll_init(loop, &connection_poll, fd) != 0) {
+		unloadConnection();
+		return;
+	}
+	if (uv_poll_start(&connection_poll, UV_READABLE, onConnectionReadable) != 0) {
+		uv_close((uv_handle_t *) &connection_poll, nullptr);
+		unloadConnection();
+		return;
+	}
+
+	uv_prepare_init(loop, &connection_prepare);
+	uv_prepare_start(&connection_prepare, onConnectionPrepare);
+
+	// Watching the connection should not keep Node alive on its own.
+	uv_unref((uv_handle_t *) &connection_poll);
+	uv_unref((uv_handle_t *) &connection_prepare);
+	is_watching_connection = true;
+}
+
+Napi::Value
+events::startWatching (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	if (is_watching) { return env.Undefined(); }
+
+	Napi::Function callback = info[0].As<Napi::Function>();
+
+	wakeup_callback = Napi::ThreadSafeFunction::New(env, callback, "@kmamal/sdl:wakeup", 0, 1);
+	wakeup_callback.Unref(env);
+
+	watch_thread_id = SDL_ThreadID();
+	SDL_AddEventWatch(watchEvents, nullptr);
+	is_watching = true;
+
+	return env.Undefined();
+}
+
+Napi::Value
+events::isWatching (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	return Napi::Boolean::New(env, is_watching_connection);
+}
+
+Napi::Value
+events::stopWatching (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	if (!is_watching) { return env.Undefined(); }
+
+	if (is_watching_connection) {
+		uv_poll_stop(&connection_poll);
+		uv_close((uv_handle_t *) &connection_poll, nullptr);
+		uv_prepare_stop(&connection_prepare);
+		uv_close((uv_handle_t *) &connection_prepare, nullptr);
+		unloadConnection();
+		is_watching_connection = false;
+	}
+
+	SDL_DelEventWatch(watchEvents, nullptr);
+	wakeup_callback.Release();
+	is_watching = false;
 
 	return env.Undefined();
 }
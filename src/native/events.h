@@ -3,79 +3,129 @@
 
 #include <napi.h>
 #include <SDL.h>
-#include <string>
+
+struct SDL_SysWMinfo;
 
 namespace events {
 
 	namespace families {
-		extern std::string APP;
-		extern std::string DISPLAY;
-		extern std::string WINDOW;
-		extern std::string DROP;
-		extern std::string KEYMAP;
-		extern std::string KEYBOARD;
-		extern std::string TEXT;
-		extern std::string MOUSE;
-		extern std::string TOUCH;
-		extern std::string JOYSTICK_DEVICE;
-		extern std::string JOYSTICK;
-		extern std::string CONTROLLER;
-		extern std::string SENSOR;
-		extern std::string AUDIO_DEVICE;
-		extern std::string CLIPBOARD;
+		enum Family {
+			APP = 1,
+			DISPLAY,
+			WINDOW,
+			DROP,
+			KEYMAP,
+			KEYBOARD,
+			TEXT,
+			MOUSE,
+			TOUCH,
+			JOYSTICK_DEVICE,
+			JOYSTICK,
+			CONTROLLER,
+			SENSOR,
+			AUDIO_DEVICE,
+			CLIPBOARD,
+		};
 	};
 
 	namespace types {
-		extern std::string QUIT;
-		extern std::string DISPLAY_ADD;
-		extern std::string DISPLAY_REMOVE;
-		extern std::string DISPLAY_ORIENT;
-		extern std::string DISPLAY_MOVE;
-		extern std::string DISPLAY_CHANGE;
-		extern std::string SHOW;
-		extern std::string HIDE;
-		extern std::string EXPOSE;
-		extern std::string MOVE;
-		extern std::string RESIZE;
-		extern std::string MINIMIZE;
-		extern std::string MAXIMIZE;
-		extern std::string RESTORE;
-		extern std::string FOCUS;
-		extern std::string BLUR;
-		extern std::string HOVER;
-		extern std::string LEAVE;
-		extern std::string KEY_DOWN;
-		extern std::string KEY_UP;
-		extern std::string TEXT_INPUT;
-		extern std::string MOUSE_MOVE;
-		extern std::string MOUSE_BUTTON_DOWN;
-		extern std::string MOUSE_BUTTON_UP;
-		extern std::string MOUSE_WHEEL;
-		extern std::string DROP_BEGIN;
-		extern std::string DROP_COMPLETE;
-		extern std::string DROP_FILE;
-		extern std::string DROP_TEXT;
-		extern std::string CLOSE;
-		extern std::string KEYMAP_CHANGE;
-		extern std::string FINGER_DOWN;
-		extern std::string FINGER_UP;
-		extern std::string FINGER_MOVE;
-		extern std::string DEVICE_ADD;
-		extern std::string DEVICE_REMOVE;
-		extern std::string AXIS_MOTION;
-		extern std::string BUTTON_DOWN;
-		extern std::string BUTTON_UP;
-		extern std::string BALL_MOTION;
-		extern std::string HAT_MOTION;
-		extern std::string POWER_UPDATE;
-		extern std::string STEAM_HANDLE_UPDATE;
-		extern std::string REMAP;
-		extern std::string UPDATE;
+		enum Type {
+			QUIT = 1,
+			DISPLAY_ADD,
+			DISPLAY_REMOVE,
+			DISPLAY_ORIENT,
+			DISPLAY_MOVE,
+			DISPLAY_CHANGE,
+			SHOW,
+			HIDE,
+			EXPOSE,
+			MOVE,
+			RESIZE,
+			MINIMIZE,
+			MAXIMIZE,
+			RESTORE,
+			FOCUS,
+			BLUR,
+			HOVER,
+			LEAVE,
+			KEY_DOWN,
+			KEY_UP,
+			TEXT_INPUT,
+			MOUSE_MOVE,
+			MOUSE_BUTTON_DOWN,
+			MOUSE_BUTTON_UP,
+			MOUSE_WHEEL,
+			DROP_BEGIN,
+			DROP_COMPLETE,
+			DROP_FILE,
+			DROP_TEXT,
+			CLOSE,
+			KEYMAP_CHANGE,
+			FINGER_DOWN,
+			FINGER_UP,
+			FINGER_MOVE,
+			DEVICE_ADD,
+			DEVICE_REMOVE,
+			AXIS_MOTION,
+			BUTTON_DOWN,
+			BUTTON_UP,
+			BALL_MOTION,
+			HAT_MOTION,
+			POWER_UPDATE,
+			STEAM_HANDLE_UPDATE,
+			REMAP,
+			UPDATE,
+		};
+	};
+
+	// Layout of a packed event record. Every record is RECORD_SIZE doubles
+	// wide. Anything that doesn't fit in a number (strings, device lists)
+	// gets appended to the extras array and the record stores its index.
+	// Coalesced records count how many events were merged into them.
+	// Timestamps are in milliseconds, on the same base as process.hrtime().
+	namespace record {
+		const int FAMILY = 0;
+		const int TYPE = 1;
+		const int ID = 2;
+		const int EXTRA = 3;
+		const int DATA = 4;
+		const int MERGED = 14;
+		const int TIMESTAMP = 15;
+		const int SIZE = 16;
+	};
+
+	namespace latency {
+		const int PUMP_TO_DISPATCH = 0;
+		const int DISPATCH_TO_RENDER = 1;
+		const int KINDS = 2;
+	};
+
+	namespace modifiers {
+		const int ALT = 1 << 0;
+		const int CTRL = 1 << 1;
+		const int SHIFT = 1 << 2;
+		const int SUPER = 1 << 3;
+		const int ALTGR = 1 << 4;
+		const int NUMLOCK = 1 << 5;
+		const int CAPSLOCK = 1 << 6;
 	};
 
 	void dispatchEvent(const SDL_Event &event);
+	void stampEvent(const SDL_Event &event);
+	void keepAllFamilies(bool keep);
+
+	void watchConnection(Napi::Env &env, const SDL_SysWMinfo &sys_wm_info);
 
 	Napi::Value poll(const Napi::CallbackInfo &info);
+	Napi::Value push(const Napi::CallbackInfo &info);
+	Napi::Value setCoalescing(const Napi::CallbackInfo &info);
+	Napi::Value setEnabledFamilies(const Napi::CallbackInfo &info);
+	Napi::Value addLatencySamples(const Napi::CallbackInfo &info);
+	Napi::Value getLatency(const Napi::CallbackInfo &info);
+	Napi::Value resetLatency(const Napi::CallbackInfo &info);
+	Napi::Value startWatching(const Napi::CallbackInfo &info);
+	Napi::Value isWatching(const Napi::CallbackInfo &info);
+	Napi::Value stopWatching(const Napi::CallbackInfo &info);
 
 }; // namespace events
 
@@ -8,6 +8,7 @@
 #include "sensor.h"
 #include "audio.h"
 #include "power.h"
+#include "trace.h"
 #include <SDL.h>
 #include <string>
 #include <sstream>
@@ -21,6 +22,8 @@
 static SDL_threadID mainThreadId;
 
 int filterEvents(void*, SDL_Event *event) {
+	trace::filterEvent(*event);
+
 	if (true
 		&& SDL_ThreadID() == mainThreadId
 		&& event->type == SDL_WINDOWEVENT
@@ -30,6 +33,10 @@ int filterEvents(void*, SDL_Event *event) {
 		)
 	) { events::dispatchEvent(*event); }
 
+	// After dispatching, so that events pushed from JS are stamped first,
+	// the same order they are queued in.
+	events::stampEvent(*event);
+
 	return 1;
 }
 
@@ -42,68 +49,6 @@ global::initialize(const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	events::families::APP = "app";
-	events::families::DISPLAY = "display";
-	events::families::WINDOW = "window";
-	events::families::DROP = "drop";
-	events::families::KEYMAP = "keymap";
-	events::families::KEYBOARD = "keyboard";
-	events::families::TEXT = "text";
-	events::families::MOUSE = "mouse";
-	events::families::TOUCH = "touch";
-	events::families::JOYSTICK_DEVICE = "joystickDevice";
-	events::families::JOYSTICK = "joystick";
-	events::families::CONTROLLER = "controller";
-	events::families::SENSOR = "sensor";
-	events::families::AUDIO_DEVICE = "audioDevice";
-	events::families::CLIPBOARD = "clipboard";
-
-	events::types::QUIT = "quit";
-	events::types::DISPLAY_ADD = "displayAdd";
-	events::types::DISPLAY_REMOVE = "displayRemove";
-	events::types::DISPLAY_ORIENT = "displayOrient";
-	events::types::DISPLAY_MOVE = "displayMove";
-	events::types::DISPLAY_CHANGE = "displayChange";
-	events::types::SHOW = "show";
-	events::types::HIDE = "hide";
-	events::types::EXPOSE = "expose";
-	events::types::MOVE = "move";
-	events::types::RESIZE = "resize";
-	events::types::MINIMIZE = "minimize";
-	events::types::MAXIMIZE = "maximize";
-	events::types::RESTORE = "restore";
-	events::types::FOCUS = "focus";
-	events::types::BLUR = "blur";
-	events::types::HOVER = "hover";
-	events::types::LEAVE = "leave";
-	events::types::KEY_DOWN = "keyDown";
-	events::types::KEY_UP = "keyUp";
-	events::types::TEXT_INPUT = "textInput";
-	events::types::MOUSE_MOVE = "mouseMove";
-	events::types::MOUSE_BUTTON_DOWN = "mouseButtonDown";
-	events::types::MOUSE_BUTTON_UP = "mouseButtonUp";
-	events::types::MOUSE_WHEEL = "mouseWheel";
-	events::types::DROP_BEGIN = "dropBegin";
-	events::types::DROP_COMPLETE = "dropComplete";
-	events::types::DROP_FILE = "dropFile";
-	events::types::DROP_TEXT = "dropText";
-	events::types::CLOSE = "close";
-	events::types::KEYMAP_CHANGE = "keymapChange";
-	events::types::FINGER_DOWN = "fingerDown";
-	events::types::FINGER_UP = "fingerUp";
-	events::types::FINGER_MOVE = "fingerMove";
-	events::types::DEVICE_ADD = "deviceAdd";
-	events::types::DEVICE_REMOVE = "deviceRemove";
-	events::types::AXIS_MOTION = "axisMotion";
-	events::types::BUTTON_DOWN = "buttonDown";
-	events::types::BUTTON_UP = "buttonUp";
-	events::types::BALL_MOTION = "ballMotion";
-	events::types::HAT_MOTION = "hatMotion";
-	events::types::POWER_UPDATE = "powerUpdate";
-	events::types::STEAM_HANDLE_UPDATE = "steamHandleUpdate";
-	events::types::REMAP = "remap";
-	events::types::UPDATE = "update";
-
 	// video::orientations[SDL_ORIENTATION_UNKNOWN] = nullptr;
 	video::orientations[SDL_ORIENTATION_LANDSCAPE] = "landscape";
 	video::orientations[SDL_ORIENTATION_LANDSCAPE_FLIPPED] = "landscapeFlipped";
@@ -196,33 +141,6 @@ global::initialize(const Napi::CallbackInfo &info)
 	controller::types[SDL_CONTROLLER_TYPE_NINTENDO_SWITCH_JOYCON_RIGHT] = "nintendoSwitchJoyconRight";
 	controller::types[SDL_CONTROLLER_TYPE_NINTENDO_SWITCH_JOYCON_PAIR] = "nintendoSwitchJoyconPair";
 
-	controller::axes[SDL_CONTROLLER_AXIS_LEFTX] = "leftStickX";
-	controller::axes[SDL_CONTROLLER_AXIS_LEFTY] = "leftStickY";
-	controller::axes[SDL_CONTROLLER_AXIS_RIGHTX] = "rightStickX";
-	controller::axes[SDL_CONTROLLER_AXIS_RIGHTY] = "rightStickY";
-	controller::axes[SDL_CONTROLLER_AXIS_TRIGGERLEFT] = "leftTrigger";
-	controller::axes[SDL_CONTROLLER_AXIS_TRIGGERRIGHT] = "rightTrigger";
-
-	controller::buttons[SDL_CONTROLLER_BUTTON_DPAD_LEFT] = "dpadLeft";
-	controller::buttons[SDL_CONTROLLER_BUTTON_DPAD_RIGHT] = "dpadRight";
-	controller::buttons[SDL_CONTROLLER_BUTTON_DPAD_UP] = "dpadUp";
-	controller::buttons[SDL_CONTROLLER_BUTTON_DPAD_DOWN] = "dpadDown";
-	controller::buttons[SDL_CONTROLLER_BUTTON_A] = "a";
-	controller::buttons[SDL_CONTROLLER_BUTTON_B] = "b";
-	controller::buttons[SDL_CONTROLLER_BUTTON_X] = "x";
-	controller::buttons[SDL_CONTROLLER_BUTTON_Y] = "y";
-	controller::buttons[SDL_CONTROLLER_BUTTON_GUIDE] = "guide";
-	controller::buttons[SDL_CONTROLLER_BUTTON_BACK] = "back";
-	controller::buttons[SDL_CONTROLLER_BUTTON_START] = "start";
-	controller::buttons[SDL_CONTROLLER_BUTTON_LEFTSTICK] = "leftStick";
-	controller::buttons[SDL_CONTROLLER_BUTTON_RIGHTSTICK] = "rightStick";
-	controller::buttons[SDL_CONTROLLER_BUTTON_LEFTSHOULDER] = "leftShoulder";
-	controller::buttons[SDL_CONTROLLER_BUTTON_RIGHTSHOULDER] = "rightShoulder";
-	controller::buttons[SDL_CONTROLLER_BUTTON_PADDLE1] = "paddle1";
-	controller::buttons[SDL_CONTROLLER_BUTTON_PADDLE2] = "paddle2";
-	controller::buttons[SDL_CONTROLLER_BUTTON_PADDLE3] = "paddle3";
-	controller::buttons[SDL_CONTROLLER_BUTTON_PADDLE4] = "paddle4";
-
 	// sensor::types[SDL_SENSOR_UNKNOWN] = nullptr;
 	sensor::types[SDL_SENSOR_ACCEL] = "accelerometer";
 	sensor::types[SDL_SENSOR_GYRO] = "gyroscope";
@@ -251,7 +169,9 @@ global::initialize(const Napi::CallbackInfo &info)
 
 	Napi::Object initialized = Napi::Object::New(env);
 
-	SDL_SetHint(SDL_HINT_FRAMEBUFFER_ACCELERATION, "0");
+	// Only a default, so it can be overridden like any other hint, by setting
+	// the SDL_FRAMEBUFFER_ACCELERATION environment variable.
+	SDL_SetHintWithPriority(SDL_HINT_FRAMEBUFFER_ACCELERATION, "0", SDL_HINT_DEFAULT);
 
 	if (SDL_InitSubSystem(SDL_INIT_EVENTS) < 0) {
 		std::ostringstream message;
@@ -365,9 +285,34 @@ global::initialize(const Napi::CallbackInfo &info)
 	audio_drivers.Set("all", all_audio_drivers);
 	audio_drivers.Set("current", current_audio_driver);
 
+	Napi::Array all_render_drivers = Napi::Array::New(env);
+
+	int num_render_drivers = SDL_GetNumRenderDrivers();
+	if (num_render_drivers < 0) {
+		std::ostringstream message;
+		message << "SDL_GetNumRenderDrivers() error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	for (int i = 0; i < num_render_drivers; i ++) {
+		SDL_RendererInfo renderer_info;
+		if (SDL_GetRenderDriverInfo(i, &renderer_info) < 0) {
+			std::ostringstream message;
+			message << "SDL_GetRenderDriverInfo(" << i << ") error: " << SDL_GetError();
+			SDL_ClearError();
+			throw Napi::Error::New(env, message.str());
+		}
+		all_render_drivers.Set(all_render_drivers.Length(), renderer_info.name);
+	}
+
+	Napi::Object render_drivers = Napi::Object::New(env);
+	render_drivers.Set("all", all_render_drivers);
+
 	Napi::Object drivers = Napi::Object::New(env);
 	drivers.Set("video", video_drivers);
 	drivers.Set("audio", audio_drivers);
+	drivers.Set("render", render_drivers);
 
 	initialized.Set("joystick", SDL_InitSubSystem(SDL_INIT_JOYSTICK) == 0);
 	initialized.Set("controller", SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER) == 0);
@@ -0,0 +1,64 @@
+#include "histogram.h"
+#include <algorithm>
+
+
+static int
+getBucket (Uint64 micros)
+{
+	if (micros < 2 * HISTOGRAM_SUB_BUCKETS) { return micros; }
+
+	int shift = 0;
+	while ((micros >> shift) >= 2 * HISTOGRAM_SUB_BUCKETS) { shift++; }
+	if (shift > HISTOGRAM_MAX_SHIFT) { return HISTOGRAM_BUCKETS - 1; }
+
+	return (shift + 1) * HISTOGRAM_SUB_BUCKETS + ((micros >> shift) - HISTOGRAM_SUB_BUCKETS);
+}
+
+static double
+getBucketLimit (int bucket)
+{
+	if (bucket < 2 * HISTOGRAM_SUB_BUCKETS) { return bucket; }
+
+	int shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+	Uint64 lower = (Uint64) (HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS) << shift;
+	return lower + ((Uint64) 1 << shift) - 1;
+}
+
+void
+histogram::add (Histogram &histogram, double millis)
+{
+	millis = std::max(millis, 0.0);
+	histogram.buckets[getBucket((Uint64) (millis * 1e3))]++;
+	histogram.count++;
+	histogram.max = std::max(histogram.max, millis);
+}
+
+Napi::Value
+histogram::getStats (Napi::Env &env, const Histogram &histogram)
+{
+	Napi::Object stats = Napi::Object::New(env);
+	stats.Set("count", (double) histogram.count);
+
+	const char *names[] = { "p50", "p90", "p95", "p99" };
+	const double ratios[] = { 0.5, 0.9, 0.95, 0.99 };
+	for (int i = 0; i < 4; i++) {
+		if (histogram.count == 0) {
+			stats.Set(names[i], env.Null());
+			continue;
+		}
+
+		Uint64 rank = (Uint64) (ratios[i] * (histogram.count - 1)) + 1;
+		Uint64 seen = 0;
+		int bucket = 0;
+		for (; bucket < HISTOGRAM_BUCKETS - 1; bucket++) {
+			seen += histogram.buckets[bucket];
+			if (seen >= rank) { break; }
+		}
+
+		double limit = getBucketLimit(bucket) / 1e3;
+		stats.Set(names[i], std::min(limit, histogram.max));
+	}
+
+	stats.Set("max", histogram.count == 0 ? env.Null() : Napi::Number::New(env, histogram.max));
+	return stats;
+}
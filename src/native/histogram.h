@@ -0,0 +1,27 @@
+#ifndef _HISTOGRAM_H_
+#define _HISTOGRAM_H_
+
+#include <napi.h>
+#include <SDL.h>
+
+// Durations are bucketed by microseconds, with 8 linear sub-buckets per
+// power of two. That keeps the error under 12.5% for any value.
+#define HISTOGRAM_SUB_BITS 3
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_MAX_SHIFT 27
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_SHIFT + 2) * HISTOGRAM_SUB_BUCKETS)
+
+struct Histogram {
+	Uint64 buckets[HISTOGRAM_BUCKETS] = {};
+	Uint64 count = 0;
+	double max = 0;
+};
+
+namespace histogram {
+
+	void add(Histogram &histogram, double millis);
+	Napi::Value getStats(Napi::Env &env, const Histogram &histogram);
+
+}; // namespace histogram
+
+#endif // _HISTOGRAM_H_
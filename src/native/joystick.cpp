@@ -7,11 +7,31 @@
 #include <map>
 
 
+std::map<SDL_JoystickID, joystick::Calibration> joystick::calibrations;
 std::map<Uint8, std::string> joystick::hat_positions;
 std::map<SDL_JoystickType, std::string> joystick::types;
 std::map<SDL_JoystickPowerLevel, std::string> joystick::power_levels;
 SDL_JoystickGUID joystick::zero_guid;
 
+void
+joystick::calibrateAxis (SDL_Joystick *joystick, int axis, AxisCalibration &dst) {
+	Sint16 initial;
+	if (!SDL_JoystickGetAxisInitialState(joystick, axis, &initial)) { initial = 0; }
+	dst.initial = initial;
+	dst.negative_scale = 1.0 / (initial - SDL_JOYSTICK_AXIS_MIN);
+	dst.positive_scale = 1.0 / (SDL_JOYSTICK_AXIS_MAX - initial);
+}
+
+const joystick::AxisCalibration *
+joystick::findCalibration (SDL_JoystickID joystick_id, int axis) {
+	auto it = calibrations.find(joystick_id);
+	if (it == calibrations.end()) { return nullptr; }
+
+	const std::vector<AxisCalibration> &axes = it->second.axes;
+	if (axis < 0 || axis >= (int) axes.size()) { return nullptr; }
+	return &axes[axis];
+}
+
 double
 joystick::mapAxis (SDL_Joystick *joystick, int axis) {
 	return mapAxisValue(joystick, axis, SDL_JoystickGetAxis(joystick, axis));
@@ -19,131 +39,171 @@ joystick::mapAxis (SDL_Joystick *joystick, int axis) {
 
 double
 joystick::mapAxisValue (SDL_Joystick *joystick, int axis, int value) {
-	Sint16 initial;
-	if (!SDL_JoystickGetAxisInitialState(joystick, axis, &initial)) { initial = 0; }
-	double range = value < initial
-		? initial - SDL_JOYSTICK_AXIS_MIN
-		: SDL_JOYSTICK_AXIS_MAX - initial;
-	return (value - initial) / range;
+	const AxisCalibration *cached = findCalibration(SDL_JoystickInstanceID(joystick), axis);
+	if (cached != nullptr) { return mapAxisValue(*cached, value); }
+
+	AxisCalibration calibration;
+	calibrateAxis(joystick, axis, calibration);
+	return mapAxisValue(calibration, value);
 }
 
-Napi::Array
-joystick::_getDevices (Napi::Env &env)
+static void
+retainCalibration (SDL_Joystick *joystick, int num_axes)
 {
-	int num_devices = SDL_NumJoysticks();
-	if (num_devices < 0) {
+	joystick::Calibration &calibration = joystick::calibrations[SDL_JoystickInstanceID(joystick)];
+	if (calibration.references++ > 0) { return; }
+
+	calibration.axes.resize(num_axes);
+	for (int i = 0; i < num_axes; i++) {
+		joystick::calibrateAxis(joystick, i, calibration.axes[i]);
+	}
+}
+
+static void
+releaseCalibration (SDL_JoystickID joystick_id)
+{
+	auto it = joystick::calibrations.find(joystick_id);
+	if (it == joystick::calibrations.end()) { return; }
+	if (--it->second.references == 0) { joystick::calibrations.erase(it); }
+}
+
+Napi::Object
+joystick::_getDevice (Napi::Env &env, int index)
+{
+	int id = SDL_JoystickGetDeviceInstanceID(index);
+	if (id == -1) {
 		std::ostringstream message;
-		message << "SDL_NumJoysticks() error: " << SDL_GetError();
+		message << "SDL_JoystickGetDeviceInstanceID(" << index << ") error: " << SDL_GetError();
 		SDL_ClearError();
 		throw Napi::Error::New(env, message.str());
 	}
 
-	Napi::Array devices = Napi::Array::New(env, num_devices);
+	const char *_name = SDL_JoystickNameForIndex(index);
+	Napi::Value name = _name != nullptr
+		? Napi::String::New(env, _name)
+		: env.Null();
 
-	for (int i = 0; i < num_devices; i++) {
-		int id = SDL_JoystickGetDeviceInstanceID(i);
-		if (id == -1) {
-			std::ostringstream message;
-			message << "SDL_JoystickGetDeviceInstanceID(" << i << ") error: " << SDL_GetError();
-			SDL_ClearError();
-			throw Napi::Error::New(env, message.str());
-		}
+	const char *_path = SDL_JoystickPathForIndex(index);
+	Napi::Value path = _path != nullptr
+		? Napi::String::New(env, _path)
+		: env.Null();
 
-		const char *_name = SDL_JoystickNameForIndex(i);
-		Napi::Value name = _name != nullptr
-			? Napi::String::New(env, _name)
-			: env.Null();
+	SDL_JoystickGUID _guid = SDL_JoystickGetDeviceGUID(index);
+	Napi::Value guid;
+	if (SDL_memcmp(&_guid, &zero_guid, sizeof(SDL_JoystickGUID)) != 0) {
+		char guid_string[33];
+		SDL_JoystickGetGUIDString(_guid, guid_string, 33);
+		guid = Napi::String::New(env, guid_string);
+	}
+	else {
+		guid = env.Null();
+	}
 
-		const char *_path = SDL_JoystickPathForIndex(i);
-		Napi::Value path = _path != nullptr
-			? Napi::String::New(env, _path)
-			: env.Null();
+	SDL_JoystickType _type = SDL_JoystickGetDeviceType(index);
+	Napi::Value type = _type != SDL_JOYSTICK_TYPE_UNKNOWN
+		? Napi::String::New(env, joystick::types[_type])
+		: env.Null();
 
-		SDL_JoystickGUID _guid = SDL_JoystickGetDeviceGUID(i);
-		Napi::Value guid;
-		if (SDL_memcmp(&_guid, &zero_guid, sizeof(SDL_JoystickGUID)) != 0) {
-			char guid_string[33];
-			SDL_JoystickGetGUIDString(_guid, guid_string, 33);
-			guid = Napi::String::New(env, guid_string);
-		}
-		else {
-			guid = env.Null();
-		}
+	int _vendor = SDL_JoystickGetDeviceVendor(index);
+	Napi::Value vendor = _vendor != 0
+		? Napi::Number::New(env, _vendor)
+		: env.Null();
 
-		SDL_JoystickType _type = SDL_JoystickGetDeviceType(i);
-		Napi::Value type = _type != SDL_JOYSTICK_TYPE_UNKNOWN
-			? Napi::String::New(env, joystick::types[_type])
-			: env.Null();
+	int _product = SDL_JoystickGetDeviceProduct(index);
+	Napi::Value product = _product != 0
+		? Napi::Number::New(env, _product)
+		: env.Null();
 
-		int _vendor = SDL_JoystickGetDeviceVendor(i);
-		Napi::Value vendor = _vendor != 0
-			? Napi::Number::New(env, _vendor)
-			: env.Null();
+	int _version = SDL_JoystickGetDeviceProductVersion(index);
+	Napi::Value version = _version != 0
+		? Napi::Number::New(env, _version)
+		: env.Null();
+
+	int _player = SDL_JoystickGetDevicePlayerIndex(index);
+	Napi::Value player = _player != -1
+		? Napi::Number::New(env, _player)
+		: env.Null();
+
+	bool is_controller = SDL_IsGameController(index);
+
+	Napi::Value controller_mapping;
+	Napi::Value controller_name;
+	Napi::Value controller_type;
 
-		int _product = SDL_JoystickGetDeviceProduct(i);
-		Napi::Value product = _product != 0
-			? Napi::Number::New(env, _product)
+	if (is_controller) {
+		char *_controller_mapping = SDL_GameControllerMappingForDeviceIndex(index);
+		controller_mapping = _controller_mapping != nullptr
+			? Napi::String::New(env, _controller_mapping)
 			: env.Null();
+		SDL_free(_controller_mapping);
 
-		int _version = SDL_JoystickGetDeviceProductVersion(i);
-		Napi::Value version = _version != 0
-			? Napi::Number::New(env, _version)
+		const char *_controller_name = SDL_GameControllerNameForIndex(index);
+		controller_name = _controller_name != nullptr
+			? Napi::String::New(env, _controller_name)
 			: env.Null();
 
-		int _player = SDL_JoystickGetDevicePlayerIndex(i);
-		Napi::Value player = _player != -1
-			? Napi::Number::New(env, _player)
+		SDL_GameControllerType _controller_type = SDL_GameControllerTypeForIndex(index);
+		controller_type = _controller_type != SDL_CONTROLLER_TYPE_UNKNOWN
+			? Napi::String::New(env, controller::types[_controller_type])
 			: env.Null();
+	}
+	else {
+		controller_mapping = env.Null();
+		controller_name = env.Null();
+		controller_type = env.Null();
+	}
 
-		bool is_controller = SDL_IsGameController(i);
+	Napi::Object device = Napi::Object::New(env);
+	device.Set("id", id);
+	device.Set("name", name);
+	device.Set("path", path);
+	device.Set("type", type);
+	device.Set("guid", guid);
+	device.Set("vendor", vendor);
+	device.Set("product", product);
+	device.Set("version", version);
+	device.Set("player", player);
+	device.Set("isController", is_controller);
+	device.Set("controllerMapping", controller_mapping);
+	device.Set("controllerName", controller_name);
+	device.Set("controllerType", controller_type);
+
+	return device;
+}
 
-		Napi::Value controller_mapping;
-		Napi::Value controller_name;
-		Napi::Value controller_type;
+Napi::Array
+joystick::_getDevices (Napi::Env &env)
+{
+	int num_devices = SDL_NumJoysticks();
+	if (num_devices < 0) {
+		std::ostringstream message;
+		message << "SDL_NumJoysticks() error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
 
-		if (is_controller) {
-			char *_controller_mapping = SDL_GameControllerMappingForDeviceIndex(i);
-			controller_mapping = _controller_mapping != nullptr
-				? Napi::String::New(env, _controller_mapping)
-				: env.Null();
-			SDL_free(_controller_mapping);
+	Napi::Array devices = Napi::Array::New(env, num_devices);
 
-			const char *_controller_name = SDL_GameControllerNameForIndex(i);
-			controller_name = _controller_name != nullptr
-				? Napi::String::New(env, _controller_name)
-				: env.Null();
+	for (int i = 0; i < num_devices; i++) {
+		devices.Set(i, joystick::_getDevice(env, i));
+	}
 
-			SDL_GameControllerType _controller_type = SDL_GameControllerTypeForIndex(i);
-			controller_type = _controller_type != SDL_CONTROLLER_TYPE_UNKNOWN
-				? Napi::String::New(env, controller::types[_controller_type])
-				: env.Null();
-		}
-		else {
-				controller_mapping = env.Null();
-				controller_name = env.Null();
-				controller_type = env.Null();
-		}
+	return devices;
+}
 
-		Napi::Object device = Napi::Object::New(env);
-		device.Set("_index", i);
-		device.Set("id", id);
-		device.Set("name", name);
-		device.Set("path", path);
-		device.Set("type", type);
-		device.Set("guid", guid);
-		device.Set("vendor", vendor);
-		device.Set("product", product);
-		device.Set("version", version);
-		device.Set("player", player);
-		device.Set("isController", is_controller);
-		device.Set("controllerMapping", controller_mapping);
-		device.Set("controllerName", controller_name);
-		device.Set("controllerType", controller_type);
-
-		devices.Set(i, device);
+int
+joystick::_getDeviceIndex (Napi::Env &env, SDL_JoystickID joystick_id)
+{
+	// Device indexes shift around as devices come and go, so JS only keeps
+	// track of instance ids and they get resolved right before use.
+	int num_devices = SDL_NumJoysticks();
+	for (int i = 0; i < num_devices; i++) {
+		if (SDL_JoystickGetDeviceInstanceID(i) == joystick_id) { return i; }
 	}
 
-	return devices;
+	std::ostringstream message;
+	message << "no joystick device with id " << joystick_id;
+	throw Napi::Error::New(env, message.str());
 }
 
 Napi::Value
@@ -175,7 +235,8 @@ joystick::open (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int index = info[0].As<Napi::Number>().Int32Value();
+	int joystick_id = info[0].As<Napi::Number>().Int32Value();
+	int index = joystick::_getDeviceIndex(env, joystick_id);
 
 	SDL_Joystick *joystick = SDL_JoystickOpen(index);
 	if (joystick == nullptr) {
@@ -296,6 +357,8 @@ joystick::open (const Napi::CallbackInfo &info)
 	result.Set("hats", hats);
 	result.Set("power", power);
 
+	retainCalibration(joystick, num_axes);
+
 	return result;
 }
 
@@ -419,7 +482,51 @@ joystick::close (const Napi::CallbackInfo &info)
 		throw Napi::Error::New(env, message.str());
 	}
 
+	releaseCalibration(joystick_id);
 	SDL_JoystickClose(joystick);
 
 	return env.Undefined();
 }
+
+Napi::Value
+joystick::attachVirtual (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	bool is_controller = info[0].As<Napi::Boolean>().Value();
+	int num_axes = info[1].As<Napi::Number>().Int32Value();
+	int num_buttons = info[2].As<Napi::Number>().Int32Value();
+	int num_hats = info[3].As<Napi::Number>().Int32Value();
+
+	SDL_JoystickType type = is_controller
+		? SDL_JOYSTICK_TYPE_GAMECONTROLLER
+		: SDL_JOYSTICK_TYPE_UNKNOWN;
+
+	int index = SDL_JoystickAttachVirtual(type, num_axes, num_buttons, num_hats);
+	if (index == -1) {
+		std::ostringstream message;
+		message << "SDL_JoystickAttachVirtual() error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	return Napi::Number::New(env, SDL_JoystickGetDeviceInstanceID(index));
+}
+
+Napi::Value
+joystick::detachVirtual (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	int joystick_id = info[0].As<Napi::Number>().Int32Value();
+	int index = joystick::_getDeviceIndex(env, joystick_id);
+
+	if (SDL_JoystickDetachVirtual(index) == -1) {
+		std::ostringstream message;
+		message << "SDL_JoystickDetachVirtual(" << index << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	return env.Undefined();
+}
@@ -5,17 +5,45 @@
 #include <SDL.h>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace joystick {
 
+	// Axis values are mapped relative to the axis' initial state. The scales
+	// for either side are computed once per open joystick, so that mapping an
+	// event is just a lookup and a multiply.
+	struct AxisCalibration {
+		double initial;
+		double negative_scale;
+		double positive_scale;
+	};
+
+	struct Calibration {
+		int references;
+		std::vector<AxisCalibration> axes;
+	};
+
+	extern std::map<SDL_JoystickID, Calibration> calibrations;
 	extern std::map<SDL_JoystickType, std::string> types;
 	extern std::map<Uint8, std::string> hat_positions;
 	extern std::map<SDL_JoystickPowerLevel, std::string> power_levels;
 	extern SDL_JoystickGUID zero_guid;
 
+	void calibrateAxis (SDL_Joystick *joystick, int axis, AxisCalibration &dst);
+	const AxisCalibration *findCalibration (SDL_JoystickID joystick_id, int axis);
 	double mapAxis (SDL_Joystick *joystick, int axis);
 	double mapAxisValue (SDL_Joystick *joystick, int axis, int value);
+
+	inline double
+	mapAxisValue (const AxisCalibration &calibration, int value) {
+		return (value - calibration.initial) * (value < calibration.initial
+			? calibration.negative_scale
+			: calibration.positive_scale);
+	}
+
+	Napi::Object _getDevice (Napi::Env &env, int index);
 	Napi::Array _getDevices (Napi::Env &env);
+	int _getDeviceIndex (Napi::Env &env, SDL_JoystickID joystick_id);
 	Napi::Value getPowerLevel(Napi::Env &env, SDL_Joystick *joystick);
 	Napi::Value mapPowerLevel(Napi::Env &env, SDL_JoystickPowerLevel power);
 
@@ -26,6 +54,8 @@ namespace joystick {
 	Napi::Value rumble(const Napi::CallbackInfo &info);
 	Napi::Value rumbleTriggers(const Napi::CallbackInfo &info);
 	Napi::Value close(const Napi::CallbackInfo &info);
+	Napi::Value attachVirtual(const Napi::CallbackInfo &info);
+	Napi::Value detachVirtual(const Napi::CallbackInfo &info);
 
 }; // namespace joystick
 
@@ -20,6 +20,19 @@ keyboard::getKey(const Napi::CallbackInfo &info)
 	return Napi::String::New(env, keyname);
 }
 
+Napi::Value
+keyboard::getKeyName(const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	int keycode = info[0].As<Napi::Number>().Int32Value();
+
+	const char *keyname = SDL_GetKeyName(keycode);
+	if (keyname[0] == '\0') { return env.Null(); }
+
+	return Napi::String::New(env, keyname);
+}
+
 Napi::Value
 keyboard::getScancode(const Napi::CallbackInfo &info)
 {
@@ -10,6 +10,7 @@ namespace keyboard {
 	extern const Uint8 *keys;
 
 	Napi::Value getKey(const Napi::CallbackInfo &info);
+	Napi::Value getKeyName(const Napi::CallbackInfo &info);
 	Napi::Value getScancode(const Napi::CallbackInfo &info);
 	Napi::Value getState(const Napi::CallbackInfo &info);
 
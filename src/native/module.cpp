@@ -5,6 +5,7 @@
 #include "events.h"
 #include "video.h"
 #include "window.h"
+#include "texture.h"
 #include "keyboard.h"
 #include "mouse.h"
 #include "touch.h"
@@ -14,6 +15,11 @@
 #include "audio.h"
 #include "clipboard.h"
 #include "power.h"
+#include "trace.h"
+#include "render-thread.h"
+#include "recorder.h"
+#include "pixels.h"
+#include "compositing.h"
 
 
 Napi::Object
@@ -25,6 +31,15 @@ init (Napi::Env env, Napi::Object exports)
 	exports.Set("global_cleanup", Napi::Function::New<global::cleanup>(env));
 
 	exports.Set("events_poll", Napi::Function::New<events::poll>(env));
+	exports.Set("events_push", Napi::Function::New<events::push>(env));
+	exports.Set("events_setCoalescing", Napi::Function::New<events::setCoalescing>(env));
+	exports.Set("events_setEnabledFamilies", Napi::Function::New<events::setEnabledFamilies>(env));
+	exports.Set("events_addLatencySamples", Napi::Function::New<events::addLatencySamples>(env));
+	exports.Set("events_getLatency", Napi::Function::New<events::getLatency>(env));
+	exports.Set("events_resetLatency", Napi::Function::New<events::resetLatency>(env));
+	exports.Set("events_startWatching", Napi::Function::New<events::startWatching>(env));
+	exports.Set("events_isWatching", Napi::Function::New<events::isWatching>(env));
+	exports.Set("events_stopWatching", Napi::Function::New<events::stopWatching>(env));
 
 	exports.Set("video_getDisplays", Napi::Function::New<video::getDisplays>(env));
 
@@ -36,6 +51,7 @@ init (Napi::Env env, Napi::Object exports)
 	exports.Set("window_setResizable", Napi::Function::New<window::setResizable>(env));
 	exports.Set("window_setBorderless", Napi::Function::New<window::setBorderless>(env));
 	exports.Set("window_setAcceleratedAndVsync", Napi::Function::New<window::setAcceleratedAndVsync>(env));
+	exports.Set("window_setVsync", Napi::Function::New<window::setVsync>(env));
 	exports.Set("window_focus", Napi::Function::New<window::focus>(env));
 	exports.Set("window_show", Napi::Function::New<window::show>(env));
 	exports.Set("window_hide", Napi::Function::New<window::hide>(env));
@@ -43,11 +59,29 @@ init (Napi::Env env, Napi::Object exports)
 	exports.Set("window_minimize", Napi::Function::New<window::minimize>(env));
 	exports.Set("window_restore", Napi::Function::New<window::restore>(env));
 	exports.Set("window_render", Napi::Function::New<window::render>(env));
+	exports.Set("window_renderYUV", Napi::Function::New<window::renderYUV>(env));
+	exports.Set("window_renderNV", Napi::Function::New<window::renderNV>(env));
+	exports.Set("window_lockTexture", Napi::Function::New<window::lockTexture>(env));
+	exports.Set("window_present", Napi::Function::New<window::present>(env));
+	exports.Set("window_clear", Napi::Function::New<window::clear>(env));
 	exports.Set("window_setIcon", Napi::Function::New<window::setIcon>(env));
 	exports.Set("window_flash", Napi::Function::New<window::flash>(env));
+	exports.Set("window_getFrameStats", Napi::Function::New<window::getFrameStats>(env));
+	exports.Set("window_resetFrameStats", Napi::Function::New<window::resetFrameStats>(env));
+	exports.Set("window_setFrameCapture", Napi::Function::New<window::setFrameCapture>(env));
+	exports.Set("window_readFrame", Napi::Function::New<window::readFrame>(env));
 	exports.Set("window_destroy", Napi::Function::New<window::destroy>(env));
 
+	exports.Set("texture_create", Napi::Function::New<texture::create>(env));
+	exports.Set("texture_update", Napi::Function::New<texture::update>(env));
+	exports.Set("texture_draw", Napi::Function::New<texture::draw>(env));
+	exports.Set("texture_drawGeometry", Napi::Function::New<texture::drawGeometry>(env));
+	exports.Set("texture_setTarget", Napi::Function::New<texture::setTarget>(env));
+	exports.Set("texture_readPixels", Napi::Function::New<texture::readPixels>(env));
+	exports.Set("texture_destroy", Napi::Function::New<texture::destroy>(env));
+
 	exports.Set("keyboard_getKey", Napi::Function::New<keyboard::getKey>(env));
+	exports.Set("keyboard_getKeyName", Napi::Function::New<keyboard::getKeyName>(env));
 	exports.Set("keyboard_getScancode", Napi::Function::New<keyboard::getScancode>(env));
 	exports.Set("keyboard_getState", Napi::Function::New<keyboard::getState>(env));
 
@@ -70,6 +104,8 @@ init (Napi::Env env, Napi::Object exports)
 	exports.Set("joystick_rumble", Napi::Function::New<joystick::rumble>(env));
 	exports.Set("joystick_rumbleTriggers", Napi::Function::New<joystick::rumbleTriggers>(env));
 	exports.Set("joystick_close", Napi::Function::New<joystick::close>(env));
+	exports.Set("joystick_attachVirtual", Napi::Function::New<joystick::attachVirtual>(env));
+	exports.Set("joystick_detachVirtual", Napi::Function::New<joystick::detachVirtual>(env));
 
 	exports.Set("controller_addMappings", Napi::Function::New<controller::addMappings>(env));
 	exports.Set("controller_open", Napi::Function::New<controller::open>(env));
@@ -94,6 +130,26 @@ init (Napi::Env env, Napi::Object exports)
 
 	exports.Set("power_getInfo", Napi::Function::New<power::getInfo>(env));
 
+	exports.Set("trace_startRecording", Napi::Function::New<trace::startRecording>(env));
+	exports.Set("trace_stopRecording", Napi::Function::New<trace::stopRecording>(env));
+	exports.Set("trace_startReplay", Napi::Function::New<trace::startReplay>(env));
+	exports.Set("trace_stopReplay", Napi::Function::New<trace::stopReplay>(env));
+
+	exports.Set("renderThread_start", Napi::Function::New<render_thread::start>(env));
+	exports.Set("renderThread_render", Napi::Function::New<render_thread::render>(env));
+	exports.Set("renderThread_stop", Napi::Function::New<render_thread::stop>(env));
+
+	exports.Set("recorder_start", Napi::Function::New<recorder::start>(env));
+	exports.Set("recorder_stop", Napi::Function::New<recorder::stop>(env));
+	exports.Set("recorder_getStats", Napi::Function::New<recorder::getStats>(env));
+
+	exports.Set("pixels_convert", Napi::Function::New<pixels::convert>(env));
+	exports.Set("pixels_scale", Napi::Function::New<pixels::scale>(env));
+
+	exports.Set("compositing_copy", Napi::Function::New<compositing::copy>(env));
+	exports.Set("compositing_blend", Napi::Function::New<compositing::blend>(env));
+	exports.Set("compositing_fill", Napi::Function::New<compositing::fill>(env));
+
 	return exports;
 }
 
@@ -0,0 +1,739 @@
+#include "pixels.h"
+#include <SDL.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <sstream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define PIXELS_SSE2
+	#include <emmintrin.h>
+	#include <immintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#define TARGET_AVX2
+	#else
+		#define TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define PIXELS_NEON
+	#include <arm_neon.h>
+#endif
+
+
+// Where each channel sits in a pixel, when the pixel is read as a
+// little-endian integer of 2, 3 or 4 bytes. The padding byte of the 8888
+// formats without alpha is listed as their alpha channel. Only the formats
+// that are common enough to deserve a fast path are described, everything
+// else is left to SDL_ConvertPixels.
+struct Layout {
+	int bytes;
+	// Red, green, blue, alpha. Alpha is -1 if there is no room for it.
+	int shifts[4];
+	bool has_alpha;
+};
+
+enum ConversionKind {
+	CONVERT_32_TO_32,
+	CONVERT_24_TO_32,
+	CONVERT_32_TO_24,
+	CONVERT_16_TO_32,
+	CONVERT_32_TO_16,
+	CONVERT_OTHER,
+};
+
+struct Conversion {
+	Layout src;
+	Layout dst;
+	ConversionKind kind;
+	// Set in the alpha (or padding) bits of the destination when the source
+	// has no alpha of its own.
+	Uint32 alpha_bits;
+	// Byte shuffle for SSSE3/AVX2 and NEON, for the kinds that move whole
+	// bytes around. Indices with the high bit set produce zero.
+	Uint8 shuffle[32];
+};
+
+static bool
+getLayout (unsigned int format, Layout *layout)
+{
+	switch (format) {
+		case SDL_PIXELFORMAT_ARGB8888: *layout = { 4, { 16, 8, 0, 24 }, true }; return true;
+		case SDL_PIXELFORMAT_RGBA8888: *layout = { 4, { 24, 16, 8, 0 }, true }; return true;
+		case SDL_PIXELFORMAT_ABGR8888: *layout = { 4, { 0, 8, 16, 24 }, true }; return true;
+		case SDL_PIXELFORMAT_BGRA8888: *layout = { 4, { 8, 16, 24, 0 }, true }; return true;
+		case SDL_PIXELFORMAT_RGB888: *layout = { 4, { 16, 8, 0, 24 }, false }; return true;
+		case SDL_PIXELFORMAT_RGBX8888: *layout = { 4, { 24, 16, 8, 0 }, false }; return true;
+		case SDL_PIXELFORMAT_BGR888: *layout = { 4, { 0, 8, 16, 24 }, false }; return true;
+		case SDL_PIXELFORMAT_BGRX8888: *layout = { 4, { 8, 16, 24, 0 }, false }; return true;
+		case SDL_PIXELFORMAT_RGB24: *layout = { 3, { 0, 8, 16, -1 }, false }; return true;
+		case SDL_PIXELFORMAT_BGR24: *layout = { 3, { 16, 8, 0, -1 }, false }; return true;
+		case SDL_PIXELFORMAT_RGB565: *layout = { 2, { 11, 5, 0, -1 }, false }; return true;
+		case SDL_PIXELFORMAT_BGR565: *layout = { 2, { 0, 5, 11, -1 }, false }; return true;
+	}
+	return false;
+}
+
+// Green gets the extra bit in 565 formats
+static int
+getChannelBits (const Layout &layout, int channel)
+{
+	if (layout.bytes != 2) { return 8; }
+	return channel == 1 ? 6 : 5;
+}
+
+static bool
+getConversion (unsigned int src_format, unsigned int dst_format, Conversion *conversion)
+{
+	// All layouts are described in terms of little-endian integers
+	if (SDL_BYTEORDER != SDL_LIL_ENDIAN) { return false; }
+
+	Layout &src = conversion->src;
+	Layout &dst = conversion->dst;
+	if (!getLayout(src_format, &src) || !getLayout(dst_format, &dst)) { return false; }
+
+	conversion->alpha_bits = !src.has_alpha && dst.bytes == 4 ? 0xffu << dst.shifts[3] : 0;
+
+	if (src.bytes == 4 && dst.bytes == 4) { conversion->kind = CONVERT_32_TO_32; }
+	else if (src.bytes == 3 && dst.bytes == 4) { conversion->kind = CONVERT_24_TO_32; }
+	else if (src.bytes == 4 && dst.bytes == 3) { conversion->kind = CONVERT_32_TO_24; }
+	else if (src.bytes == 2 && dst.bytes == 4) { conversion->kind = CONVERT_16_TO_32; }
+	else if (src.bytes == 4 && dst.bytes == 2) { conversion->kind = CONVERT_32_TO_16; }
+	else { conversion->kind = CONVERT_OTHER; }
+
+	// For each byte of a destination pixel, the byte of the source pixel
+	// it comes from, or -1 for the constant alpha.
+	int from[4] = { -1, -1, -1, -1 };
+	if (src.bytes >= 3 && dst.bytes >= 3) {
+		int channels = src.has_alpha && dst.bytes == 4 ? 4 : 3;
+		for (int channel = 0; channel < channels; channel++) {
+			from[dst.shifts[channel] / 8] = src.shifts[channel] / 8;
+		}
+	}
+
+	Uint8 *shuffle = conversion->shuffle;
+	memset(shuffle, 0x80, sizeof(conversion->shuffle));
+	switch (conversion->kind) {
+		case CONVERT_32_TO_32:
+			for (int i = 0; i < 32; i++) {
+				int source = from[i % 4];
+				if (source >= 0) { shuffle[i] = (i % 16) / 4 * 4 + source; }
+			}
+			break;
+		case CONVERT_24_TO_32:
+			for (int i = 0; i < 32; i++) {
+				int source = from[i % 4];
+				if (source >= 0) { shuffle[i] = (i % 16) / 4 * 3 + source; }
+			}
+			break;
+		case CONVERT_32_TO_24:
+			for (int i = 0; i < 32; i++) {
+				if (i % 16 >= 12) { continue; }
+				shuffle[i] = (i % 16) / 3 * 4 + from[i % 16 % 3];
+			}
+			break;
+		default:
+			break;
+	}
+
+	return true;
+}
+
+static inline Uint32
+loadPixel (const Uint8 *pixel, int bytes)
+{
+	Uint32 value = pixel[0] | (pixel[1] << 8);
+	if (bytes >= 3) { value |= pixel[2] << 16; }
+	if (bytes == 4) { value |= (Uint32) pixel[3] << 24; }
+	return value;
+}
+
+static inline void
+storePixel (Uint8 *pixel, int bytes, Uint32 value)
+{
+	pixel[0] = value;
+	pixel[1] = value >> 8;
+	if (bytes >= 3) { pixel[2] = value >> 16; }
+	if (bytes == 4) { pixel[3] = value >> 24; }
+}
+
+// Handles any pair of layouts, one pixel at a time. The vector kernels
+// below use it for whatever is left at the end of a row.
+static void
+convertPixelsScalar (const Uint8 *src, Uint8 *dst, int count, const Conversion &conversion)
+{
+	const Layout &src_layout = conversion.src;
+	const Layout &dst_layout = conversion.dst;
+
+	for (int x = 0; x < count; x++) {
+		Uint32 value = loadPixel(src, src_layout.bytes);
+		Uint32 result = conversion.alpha_bits;
+
+		int channels = src_layout.has_alpha ? 4 : 3;
+		for (int channel = 0; channel < channels; channel++) {
+			if (dst_layout.shifts[channel] < 0) { continue; }
+
+			int src_bits = getChannelBits(src_layout, channel);
+			Uint32 component = (value >> src_layout.shifts[channel]) & ((1u << src_bits) - 1);
+			if (src_bits < 8) { component = (component << (8 - src_bits)) | (component >> (2 * src_bits - 8)); }
+
+			int dst_bits = getChannelBits(dst_layout, channel);
+			result |= (component >> (8 - dst_bits)) << dst_layout.shifts[channel];
+		}
+
+		storePixel(dst, dst_layout.bytes, result);
+		src += src_layout.bytes;
+		dst += dst_layout.bytes;
+	}
+}
+
+#if defined(PIXELS_SSE2)
+
+static bool
+hasAvx2 ()
+{
+	static const bool has_avx2 = SDL_HasAVX2();
+	return has_avx2;
+}
+
+// SSE2 has no byte shuffle, so channels are moved with shifts and masks.
+// Shift counts don't need to be known at compile time that way.
+static int
+convertRow32To32Sse2 (const Uint8 *src, Uint8 *dst, int width, const Conversion &conversion)
+{
+	const Layout &src_layout = conversion.src;
+	const Layout &dst_layout = conversion.dst;
+	int channels = src_layout.has_alpha ? 4 : 3;
+
+	__m128i src_shifts[4];
+	__m128i dst_shifts[4];
+	for (int channel = 0; channel < channels; channel++) {
+		src_shifts[channel] = _mm_cvtsi32_si128(src_layout.shifts[channel]);
+		dst_shifts[channel] = _mm_cvtsi32_si128(dst_layout.shifts[channel]);
+	}
+	__m128i mask = _mm_set1_epi32(0xff);
+	__m128i alpha = _mm_set1_epi32(conversion.alpha_bits);
+
+	int x = 0;
+	for (; x + 4 <= width; x += 4) {
+		__m128i value = _mm_loadu_si128((const __m128i *) (src + x * 4));
+		__m128i result = alpha;
+		for (int channel = 0; channel < channels; channel++) {
+			__m128i component = _mm_and_si128(_mm_srl_epi32(value, src_shifts[channel]), mask);
+			result = _mm_or_si128(result, _mm_sll_epi32(component, dst_shifts[channel]));
+		}
+		_mm_storeu_si128((__m128i *) (dst + x * 4), result);
+	}
+	return x;
+}
+
+static int
+convertRow16To32Sse2 (const Uint8 *src, Uint8 *dst, int width, const Conversion &conversion)
+{
+	const Layout &src_layout = conversion.src;
+	const Layout &dst_layout = conversion.dst;
+
+	__m128i src_r = _mm_cvtsi32_si128(src_layout.shifts[0]);
+	__m128i src_g = _mm_cvtsi32_si128(src_layout.shifts[1]);
+	__m128i src_b = _mm_cvtsi32_si128(src_layout.shifts[2]);
+	__m128i dst_r = _mm_cvtsi32_si128(dst_layout.shifts[0]);
+	__m128i dst_g = _mm_cvtsi32_si128(dst_layout.shifts[1]);
+	__m128i dst_b = _mm_cvtsi32_si128(dst_layout.shifts[2]);
+	__m128i mask5 = _mm_set1_epi32(0x1f);
+	__m128i mask6 = _mm_set1_epi32(0x3f);
+	__m128i alpha = _mm_set1_epi32(conversion.alpha_bits);
+	__m128i zero = _mm_setzero_si128();
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		__m128i packed = _mm_loadu_si128((const __m128i *) (src + x * 2));
+		__m128i halves[2] = { _mm_unpacklo_epi16(packed, zero), _mm_unpackhi_epi16(packed, zero) };
+		for (int i = 0; i < 2; i++) {
+			__m128i value = halves[i];
+			__m128i r = _mm_and_si128(_mm_srl_epi32(value, src_r), mask5);
+			__m128i g = _mm_and_si128(_mm_srl_epi32(value, src_g), mask6);
+			__m128i b = _mm_and_si128(_mm_srl_epi32(value, src_b), mask5);
+			r = _mm_or_si128(_mm_slli_epi32(r, 3), _mm_srli_epi32(r, 2));
+			g = _mm_or_si128(_mm_slli_epi32(g, 2), _mm_srli_epi32(g, 4));
+			b = _mm_or_si128(_mm_slli_epi32(b, 3), _mm_srli_epi32(b, 2));
+			__m128i result = _mm_or_si128(alpha, _mm_sll_epi32(r, dst_r));
+			result = _mm_or_si128(result, _mm_sll_epi32(g, dst_g));
+			result = _mm_or_si128(result, _mm_sll_epi32(b, dst_b));
+			_mm_storeu_si128((__m128i *) (dst + x * 4 + i * 16), result);
+		}
+	}
+	return x;
+}
+
+static int
+convertRow32To16Sse2 (const Uint8 *src, Uint8 *dst, int width, const Conversion &conversion)
+{
+	const Layout &src_layout = conversion.src;
+	const Layout &dst_layout = conversion.dst;
+
+	// Keep the top 5 or 6 bits of each channel
+	__m128i src_r = _mm_cvtsi32_si128(src_layout.shifts[0] + 3);
+	__m128i src_g = _mm_cvtsi32_si128(src_layout.shifts[1] + 2);
+	__m128i src_b = _mm_cvtsi32_si128(src_layout.shifts[2] + 3);
+	__m128i dst_r = _mm_cvtsi32_si128(dst_layout.shifts[0]);
+	__m128i dst_g = _mm_cvtsi32_si128(dst_layout.shifts[1]);
+	__m128i dst_b = _mm_cvtsi32_si128(dst_layout.shifts[2]);
+	__m128i mask5 = _mm_set1_epi32(0x1f);
+	__m128i mask6 = _mm_set1_epi32(0x3f);
+	// SSE2 can only pack 32-bit lanes into 16 with signed saturation, so
+	// the values are moved into the signed range and back.
+	__m128i bias32 = _mm_set1_epi32(0x8000);
+	__m128i bias16 = _mm_set1_epi16((short) 0x8000);
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		__m128i halves[2];
+		for (int i = 0; i < 2; i++) {
+			__m128i value = _mm_loadu_si128((const __m128i *) (src + x * 4 + i * 16));
+			__m128i r = _mm_and_si128(_mm_srl_epi32(value, src_r), mask5);
+			__m128i g = _mm_and_si128(_mm_srl_epi32(value, src_g), mask6);
+			__m128i b = _mm_and_si128(_mm_srl_epi32(value, src_b), mask5);
+			__m128i result = _mm_sll_epi32(r, dst_r);
+			result = _mm_or_si128(result, _mm_sll_epi32(g, dst_g));
+			result = _mm_or_si128(result, _mm_sll_epi32(b, dst_b));
+			halves[i] = _mm_sub_epi32(result, bias32);
+		}
+		__m128i packed = _mm_add_epi16(_mm_packs_epi32(halves[0], halves[1]), bias16);
+		_mm_storeu_si128((__m128i *) (dst + x * 2), packed);
+	}
+	return x;
+}
+
+TARGET_AVX2 static int
+convertRow32To32Avx2 (const Uint8 *src, Uint8 *dst, int width, const Conversion &conversion)
+{
+	__m256i shuffle = _mm256_loadu_si256((const __m256i *) conversion.shuffle);
+	__m256i alpha = _mm256_set1_epi32(conversion.alpha_bits);
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		__m256i value = _mm256_loadu_si256((const __m256i *) (src + x * 4));
+		__m256i result = _mm256_or_si256(_mm256_shuffle_epi8(value, shuffle), alpha);
+		_mm256_storeu_si256((__m256i *) (dst + x * 4), result);
+	}
+	return x;
+}
+
+// Each 128-bit lane handles four pixels. Loads and stores are 16 bytes
+// wide but only 12 of them belong to those pixels, so the loops stop early
+// enough to stay inside the row.
+TARGET_AVX2 static int
+convertRow24To32Avx2 (const Uint8 *src, Uint8 *dst, int width, const Conversion &conversion)
+{
+	__m256i shuffle = _mm256_loadu_si256((const __m256i *) conversion.shuffle);
+	__m256i alpha = _mm256_set1_epi32(conversion.alpha_bits);
+
+	int x = 0;
+	for (; x + 10 <= width; x += 8) {
+		__m128i low = _mm_loadu_si128((const __m128i *) (src + x * 3));
+		__m128i high = _mm_loadu_si128((const __m128i *) (src + x * 3 + 12));
+		__m256i value = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+		__m256i result = _mm256_or_si256(_mm256_shuffle_epi8(value, shuffle), alpha);
+		_mm256_storeu_si256((__m256i *) (dst + x * 4), result);
+	}
+	return x;
+}
+
+TARGET_AVX2 static int
+convertRow32To24Avx2 (const Uint8 *src, Uint8 *dst, int width, const Conversion &conversion)
+{
+	__m256i shuffle = _mm256_loadu_si256((const __m256i *) conversion.shuffle);
+
+	int x = 0;
+	for (; x + 10 <= width; x += 8) {
+		__m256i value = _mm256_loadu_si256((const __m256i *) (src + x * 4));
+		__m256i result = _mm256_shuffle_epi8(value, shuffle);
+		_mm_storeu_si128((__m128i *) (dst + x * 3), _mm256_castsi256_si128(result));
+		_mm_storeu_si128((__m128i *) (dst + x * 3 + 12), _mm256_extracti128_si256(result, 1));
+	}
+	return x;
+}
+
+static int
+convertRowVector (const Uint8 *src, Uint8 *dst, int width, const Conversion &conversion)
+{
+	bool avx2 = hasAvx2();
+	switch (conversion.kind) {
+		case CONVERT_32_TO_32:
+			return avx2
+				? convertRow32To32Avx2(src, dst, width, conversion)
+				: convertRow32To32Sse2(src, dst, width, conversion);
+		case CONVERT_24_TO_32:
+			return avx2 ? convertRow24To32Avx2(src, dst, width, conversion) : 0;
+		case CONVERT_32_TO_24:
+			return avx2 ? convertRow32To24Avx2(src, dst, width, conversion) : 0;
+		case CONVERT_16_TO_32:
+			return convertRow16To32Sse2(src, dst, width, conversion);
+		case CONVERT_32_TO_16:
+			return convertRow32To16Sse2(src, dst, width, conversion);
+		default:
+			return 0;
+	}
+}
+
+#elif defined(PIXELS_NEON)
+
+static int
+convertRowVector (const Uint8 *src, Uint8 *dst, int width, const Conversion &conversion)
+{
+	const Layout &src_layout = conversion.src;
+	const Layout &dst_layout = conversion.dst;
+	int x = 0;
+
+	switch (conversion.kind) {
+		case CONVERT_32_TO_32: {
+			uint8x16_t shuffle = vld1q_u8(conversion.shuffle);
+			uint8x16_t alpha = vreinterpretq_u8_u32(vdupq_n_u32(conversion.alpha_bits));
+			for (; x + 4 <= width; x += 4) {
+				uint8x16_t value = vld1q_u8(src + x * 4);
+				vst1q_u8(dst + x * 4, vorrq_u8(vqtbl1q_u8(value, shuffle), alpha));
+			}
+			break;
+		}
+
+		// NEON can split and merge interleaved channels directly
+		case CONVERT_24_TO_32: {
+			uint8x16_t opaque = vdupq_n_u8(0xff);
+			for (; x + 16 <= width; x += 16) {
+				uint8x16x3_t value = vld3q_u8(src + x * 3);
+				uint8x16x4_t result;
+				for (int i = 0; i < 4; i++) {
+					int source = conversion.shuffle[i];
+					result.val[i] = source & 0x80 ? opaque : value.val[source];
+				}
+				vst4q_u8(dst + x * 4, result);
+			}
+			break;
+		}
+
+		case CONVERT_32_TO_24: {
+			for (; x + 16 <= width; x += 16) {
+				uint8x16x4_t value = vld4q_u8(src + x * 4);
+				uint8x16x3_t result;
+				for (int i = 0; i < 3; i++) {
+					result.val[i] = value.val[conversion.shuffle[i]];
+				}
+				vst3q_u8(dst + x * 3, result);
+			}
+			break;
+		}
+
+		case CONVERT_16_TO_32: {
+			int16x8_t src_r = vdupq_n_s16(-src_layout.shifts[0]);
+			int16x8_t src_g = vdupq_n_s16(-src_layout.shifts[1]);
+			int16x8_t src_b = vdupq_n_s16(-src_layout.shifts[2]);
+			for (; x + 8 <= width; x += 8) {
+				uint16x8_t value = vld1q_u16((const uint16_t *) (src + x * 2));
+				uint16x8_t r = vandq_u16(vshlq_u16(value, src_r), vdupq_n_u16(0x1f));
+				uint16x8_t g = vandq_u16(vshlq_u16(value, src_g), vdupq_n_u16(0x3f));
+				uint16x8_t b = vandq_u16(vshlq_u16(value, src_b), vdupq_n_u16(0x1f));
+				uint8x8x4_t result;
+				for (int i = 0; i < 4; i++) { result.val[i] = vdup_n_u8(0xff); }
+				result.val[dst_layout.shifts[0] / 8] = vmovn_u16(vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2)));
+				result.val[dst_layout.shifts[1] / 8] = vmovn_u16(vorrq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(g, 4)));
+				result.val[dst_layout.shifts[2] / 8] = vmovn_u16(vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2)));
+				vst4_u8(dst + x * 4, result);
+			}
+			break;
+		}
+
+		case CONVERT_32_TO_16: {
+			int16x8_t dst_r = vdupq_n_s16(dst_layout.shifts[0]);
+			int16x8_t dst_g = vdupq_n_s16(dst_layout.shifts[1]);
+			int16x8_t dst_b = vdupq_n_s16(dst_layout.shifts[2]);
+			for (; x + 8 <= width; x += 8) {
+				uint8x8x4_t value = vld4_u8(src + x * 4);
+				uint16x8_t r = vmovl_u8(vshr_n_u8(value.val[src_layout.shifts[0] / 8], 3));
+				uint16x8_t g = vmovl_u8(vshr_n_u8(value.val[src_layout.shifts[1] / 8], 2));
+				uint16x8_t b = vmovl_u8(vshr_n_u8(value.val[src_layout.shifts[2] / 8], 3));
+				uint16x8_t result = vshlq_u16(r, dst_r);
+				result = vorrq_u16(result, vshlq_u16(g, dst_g));
+				result = vorrq_u16(result, vshlq_u16(b, dst_b));
+				vst1q_u16((uint16_t *) (dst + x * 2), result);
+			}
+			break;
+		}
+
+		default:
+			break;
+	}
+
+	return x;
+}
+
+#else
+
+static int
+convertRowVector (const Uint8 *, Uint8 *, int, const Conversion &)
+{
+	return 0;
+}
+
+#endif
+
+bool
+pixels::canConvert (unsigned int src_format, unsigned int dst_format)
+{
+	Conversion conversion;
+	return getConversion(src_format, dst_format, &conversion);
+}
+
+bool
+pixels::convertRect (
+	int width, int height,
+	unsigned int src_format, const void *src, int src_stride,
+	unsigned int dst_format, void *dst, int dst_stride
+) {
+	const Uint8 *src_row = static_cast<const Uint8 *>(src);
+	Uint8 *dst_row = static_cast<Uint8 *>(dst);
+
+	if (src_format == dst_format) {
+		int row_size = width * SDL_BYTESPERPIXEL(src_format);
+		for (int y = 0; y < height; y++) {
+			memcpy(dst_row, src_row, row_size);
+			src_row += src_stride;
+			dst_row += dst_stride;
+		}
+		return true;
+	}
+
+	Conversion conversion;
+	if (!getConversion(src_format, dst_format, &conversion)) { return false; }
+
+	int src_bytes = conversion.src.bytes;
+	int dst_bytes = conversion.dst.bytes;
+	for (int y = 0; y < height; y++) {
+		int x = convertRowVector(src_row, dst_row, width, conversion);
+		convertPixelsScalar(src_row + x * src_bytes, dst_row + x * dst_bytes, width - x, conversion);
+		src_row += src_stride;
+		dst_row += dst_stride;
+	}
+	return true;
+}
+
+
+// Source coordinates for one row or column of a scaled image. Pixel
+// centers are lined up, so scaling by an integer factor in either direction
+// samples evenly. Weights are 7 bit, so that sums of products of 8 bit
+// channels still fit in 16 bit lanes.
+struct Sample {
+	int index;
+	// Weight of the pixel at index + 1, out of 128
+	int weight;
+};
+
+static std::vector<Sample>
+getSamples (int src_size, int dst_size)
+{
+	std::vector<Sample> samples(dst_size);
+	for (int i = 0; i < dst_size; i++) {
+		Sint64 position = ((Sint64) (2 * i + 1) * src_size * 65536) / (2 * dst_size) - 32768;
+		position = std::max<Sint64>(position, 0);
+		int index = (int) (position >> 16);
+		int weight = (int) ((position & 0xffff) >> 9);
+		if (index >= src_size - 1) {
+			index = std::max(src_size - 2, 0);
+			weight = src_size > 1 ? 128 : 0;
+		}
+		samples[i] = { index, weight };
+	}
+	return samples;
+}
+
+template <int BYTES>
+static void
+scaleNearest (
+	const Uint8 *src, int src_width, int src_height, int src_stride,
+	Uint8 *dst, int dst_width, int dst_height, int dst_stride
+) {
+	std::vector<int> offsets(dst_width);
+	for (int x = 0; x < dst_width; x++) {
+		offsets[x] = (int) (((Sint64) (2 * x + 1) * src_width) / (2 * dst_width)) * BYTES;
+	}
+
+	int row_size = dst_width * BYTES;
+	int previous = -1;
+	for (int y = 0; y < dst_height; y++) {
+		int src_y = (int) (((Sint64) (2 * y + 1) * src_height) / (2 * dst_height));
+		Uint8 *dst_row = dst + (size_t) y * dst_stride;
+
+		// Rows repeat when scaling up
+		if (src_y == previous) {
+			memcpy(dst_row, dst_row - dst_stride, row_size);
+			continue;
+		}
+		previous = src_y;
+
+		const Uint8 *src_row = src + (size_t) src_y * src_stride;
+		for (int x = 0; x < dst_width; x++) {
+			memcpy(dst_row + x * BYTES, src_row + offsets[x], BYTES);
+		}
+	}
+}
+
+// Blends each byte on its own, which is right for any format with 8 bits
+// per channel.
+static void
+scaleLinearScalar (
+	const Uint8 *row0, const Uint8 *row1, int weight_y, int src_width,
+	Uint8 *dst, const std::vector<Sample> &samples, int from, int bytes
+) {
+	int count = samples.size();
+	for (int x = from; x < count; x++) {
+		const Sample &sample = samples[x];
+		int left = sample.index * bytes;
+		int right = std::min(sample.index + 1, src_width - 1) * bytes;
+		int weight_x = sample.weight;
+		for (int i = 0; i < bytes; i++) {
+			int top = row0[left + i] * (128 - weight_x) + row0[right + i] * weight_x;
+			int bottom = row1[left + i] * (128 - weight_x) + row1[right + i] * weight_x;
+			dst[x * bytes + i] = (top * (128 - weight_y) + bottom * weight_y + 8192) >> 14;
+		}
+	}
+}
+
+// Returns how many pixels of the row were done. Needs two source pixels
+// side by side, so images one pixel wide are left to the scalar code.
+static int
+scaleLinearRow32 (
+	const Uint8 *row0, const Uint8 *row1, int weight_y, int src_width,
+	Uint8 *dst, const std::vector<Sample> &samples
+) {
+	if (src_width < 2) { return 0; }
+	int count = samples.size();
+
+#if defined(PIXELS_SSE2)
+	__m128i zero = _mm_setzero_si128();
+	__m128i round = _mm_set1_epi16(64);
+	__m128i top_weight = _mm_set1_epi16(128 - weight_y);
+	__m128i bottom_weight = _mm_set1_epi16(weight_y);
+	for (int x = 0; x < count; x++) {
+		const Sample &sample = samples[x];
+		int offset = sample.index * 4;
+
+		// Both neighbours in a row at once, blended vertically first
+		__m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (row0 + offset)), zero);
+		__m128i bottom = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (row1 + offset)), zero);
+		__m128i column = _mm_add_epi16(_mm_mullo_epi16(top, top_weight), _mm_mullo_epi16(bottom, bottom_weight));
+		column = _mm_srli_epi16(_mm_add_epi16(column, round), 7);
+
+		__m128i left = _mm_mullo_epi16(column, _mm_set1_epi16(128 - sample.weight));
+		__m128i right = _mm_mullo_epi16(_mm_srli_si128(column, 8), _mm_set1_epi16(sample.weight));
+		__m128i result = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(left, right), round), 7);
+		Uint32 pixel = _mm_cvtsi128_si32(_mm_packus_epi16(result, zero));
+		memcpy(dst + x * 4, &pixel, 4);
+	}
+	return count;
+#elif defined(PIXELS_NEON)
+	for (int x = 0; x < count; x++) {
+		const Sample &sample = samples[x];
+		int offset = sample.index * 4;
+
+		uint16x8_t top = vmovl_u8(vld1_u8(row0 + offset));
+		uint16x8_t bottom = vmovl_u8(vld1_u8(row1 + offset));
+		uint16x8_t column = vmlaq_n_u16(vmulq_n_u16(top, 128 - weight_y), bottom, weight_y);
+		column = vrshrq_n_u16(column, 7);
+
+		uint16x4_t left = vmul_n_u16(vget_low_u16(column), 128 - sample.weight);
+		uint16x4_t result = vrshr_n_u16(vmla_n_u16(left, vget_high_u16(column), sample.weight), 7);
+		uint8x8_t packed = vmovn_u16(vcombine_u16(result, result));
+		vst1_lane_u32((uint32_t *) (dst + x * 4), vreinterpret_u32_u8(packed), 0);
+	}
+	return count;
+#else
+	(void) row0; (void) row1; (void) weight_y; (void) dst; (void) count;
+	return 0;
+#endif
+}
+
+static void
+scaleLinear (
+	const Uint8 *src, int src_width, int src_height, int src_stride,
+	Uint8 *dst, int dst_width, int dst_height, int dst_stride,
+	int bytes
+) {
+	std::vector<Sample> columns = getSamples(src_width, dst_width);
+	std::vector<Sample> rows = getSamples(src_height, dst_height);
+
+	for (int y = 0; y < dst_height; y++) {
+		const Sample &sample = rows[y];
+		const Uint8 *row0 = src + (size_t) sample.index * src_stride;
+		const Uint8 *row1 = src + (size_t) std::min(sample.index + 1, src_height - 1) * src_stride;
+		Uint8 *dst_row = dst + (size_t) y * dst_stride;
+
+		int x = bytes == 4 ? scaleLinearRow32(row0, row1, sample.weight, src_width, dst_row, columns) : 0;
+		scaleLinearScalar(row0, row1, sample.weight, src_width, dst_row, columns, x, bytes);
+	}
+}
+
+
+Napi::Value
+pixels::convert (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	int width = info[0].As<Napi::Number>().Int32Value();
+	int height = info[1].As<Napi::Number>().Int32Value();
+	int src_stride = info[2].As<Napi::Number>().Int32Value();
+	unsigned int src_format = info[3].As<Napi::Number>().Int32Value();
+	void *src = info[4].As<Napi::Buffer<char>>().Data();
+	int dst_stride = info[5].As<Napi::Number>().Int32Value();
+	unsigned int dst_format = info[6].As<Napi::Number>().Int32Value();
+	void *dst = info[7].As<Napi::Buffer<char>>().Data();
+
+	if (pixels::convertRect(width, height, src_format, src, src_stride, dst_format, dst, dst_stride)) {
+		return env.Undefined();
+	}
+
+	if (SDL_ConvertPixels(width, height, src_format, src, src_stride, dst_format, dst, dst_stride) < 0) {
+		std::ostringstream message;
+		message << "SDL_ConvertPixels(" << src_format << ", " << dst_format << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	return env.Undefined();
+}
+
+Napi::Value
+pixels::scale (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	int src_width = info[0].As<Napi::Number>().Int32Value();
+	int src_height = info[1].As<Napi::Number>().Int32Value();
+	int src_stride = info[2].As<Napi::Number>().Int32Value();
+	unsigned int format = info[3].As<Napi::Number>().Int32Value();
+	const Uint8 *src = info[4].As<Napi::Buffer<Uint8>>().Data();
+	int dst_width = info[5].As<Napi::Number>().Int32Value();
+	int dst_height = info[6].As<Napi::Number>().Int32Value();
+	int dst_stride = info[7].As<Napi::Number>().Int32Value();
+	Uint8 *dst = info[8].As<Napi::Buffer<Uint8>>().Data();
+	bool is_linear = info[9].As<Napi::Boolean>().Value();
+
+	int bytes = SDL_BYTESPERPIXEL(format);
+
+	if (is_linear) {
+		scaleLinear(src, src_width, src_height, src_stride, dst, dst_width, dst_height, dst_stride, bytes);
+		return env.Undefined();
+	}
+
+	switch (bytes) {
+		case 1: scaleNearest<1>(src, src_width, src_height, src_stride, dst, dst_width, dst_height, dst_stride); break;
+		case 2: scaleNearest<2>(src, src_width, src_height, src_stride, dst, dst_width, dst_height, dst_stride); break;
+		case 3: scaleNearest<3>(src, src_width, src_height, src_stride, dst, dst_width, dst_height, dst_stride); break;
+		case 4: scaleNearest<4>(src, src_width, src_height, src_stride, dst, dst_width, dst_height, dst_stride); break;
+		default: {
+			std::ostringstream message;
+			message << "pixels_scale(" << format << ") error: unsupported format";
+			throw Napi::Error::New(env, message.str());
+		}
+	}
+
+	return env.Undefined();
+}
@@ -0,0 +1,21 @@
+#ifndef _PIXELS_H_
+#define _PIXELS_H_
+
+#include <napi.h>
+#include <SDL.h>
+
+namespace pixels {
+
+	bool canConvert(unsigned int src_format, unsigned int dst_format);
+	bool convertRect(
+		int width, int height,
+		unsigned int src_format, const void *src, int src_stride,
+		unsigned int dst_format, void *dst, int dst_stride
+	);
+
+	Napi::Value convert(const Napi::CallbackInfo &info);
+	Napi::Value scale(const Napi::CallbackInfo &info);
+
+}; // namespace pixels
+
+#endif // _PIXELS_H_
@@ -0,0 +1,551 @@
+#include "recorder.h"
+#include <SDL.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <sstream>
+#include <vector>
+
+#if defined(__WIN32__)
+	#include <io.h>
+	#define dupDescriptor _dup
+	#define writeToDescriptor(fd, data, size) _write(fd, data, (unsigned int) (size))
+	#define closeDescriptor _close
+#else
+	#include <unistd.h>
+	#include <poll.h>
+	#define dupDescriptor dup
+	#define writeToDescriptor write
+	#define closeDescriptor close
+#endif
+
+
+// While a window is being captured, every frame that frame capture draws
+// into one of its targets is read back one present later, when the GPU is
+// done with it, and handed to a writer thread through a bounded queue. The
+// thread converts the pixels and writes them out, so neither the conversion
+// nor the disk I/O happens on the Node.js event loop. When the queue is full
+// the frame is dropped instead of waiting for the disk.
+//
+// The recording has a fixed frame rate, so each of its frames goes to
+// whatever was on screen at that time. A frame that stays up for several
+// periods is written several times, and one that gets replaced within the
+// same period isn't read back at all.
+
+struct QueuedFrame {
+	std::vector<char> pixels;
+	// How many times the frame is written to the recording.
+	Uint64 repeats;
+};
+
+struct Recorder {
+	SDL_RWops *file;
+	SDL_Thread *thread;
+	SDL_mutex *mutex;
+	SDL_cond *cond;
+	// Frames as read back from the capture target.
+	std::deque<QueuedFrame> queue;
+	// Pixel buffers of written frames, kept for reuse.
+	std::vector<std::vector<char>> spare;
+	size_t depth;
+	bool stopping;
+
+	int width;
+	int height;
+	unsigned int src_format;
+	int src_stride;
+	bool is_y4m;
+
+	// Only used by the main thread
+	Uint64 period;
+	// Time of the first frame of the recording that wasn't given out yet.
+	Uint64 next_frame;
+	// Whether the frame in the latest capture target is still to be
+	// recorded. How many times is only known once the next one is presented.
+	bool is_pending;
+
+	// Guarded by the mutex
+	double frames;
+	double dropped;
+	double bytes;
+	std::string error;
+};
+
+// BT.601 with limited range, the y4m default. SDL_ConvertPixels would use
+// the global YUV conversion mode, which renderYUV changes from the main
+// thread, so the coefficients are fixed here instead. Chroma is averaged
+// over 2x2 blocks, both dimensions are even.
+static void
+convertToI420 (int width, int height, const Uint8 *rgb, int rgb_stride, Uint8 *dst)
+{
+	Uint8 *y_plane = dst;
+	Uint8 *u_plane = y_plane + (size_t) width * height;
+	Uint8 *v_plane = u_plane + (size_t) width * height / 4;
+	int chroma_width = width / 2;
+
+	for (int y = 0; y < height; y += 2) {
+		const Uint8 *rows[2] = {
+			rgb + (size_t) y * rgb_stride,
+			rgb + (size_t) (y + 1) * rgb_stride,
+		};
+
+		for (int i = 0; i < 2; i++) {
+			const Uint8 *src = rows[i];
+			Uint8 *luma = y_plane + (size_t) (y + i) * width;
+			for (int x = 0; x < width; x++, src += 3) {
+				luma[x] = ((66 * src[0] + 129 * src[1] + 25 * src[2] + 128) >> 8) + 16;
+			}
+		}
+
+		Uint8 *u_row = u_plane + (size_t) (y / 2) * chroma_width;
+		Uint8 *v_row = v_plane + (size_t) (y / 2) * chroma_width;
+		for (int x = 0; x < chroma_width; x++) {
+			const Uint8 *top = rows[0] + x * 6;
+			const Uint8 *bottom = rows[1] + x * 6;
+			int r = (top[0] + top[3] + bottom[0] + bottom[3] + 2) >> 2;
+			int g = (top[1] + top[4] + bottom[1] + bottom[4] + 2) >> 2;
+			int b = (top[2] + top[5] + bottom[2] + bottom[5] + 2) >> 2;
+			u_row[x] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+			v_row[x] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+		}
+	}
+}
+
+static int
+writeFrames (void *data)
+{
+	Recorder *state = static_cast<Recorder *>(data);
+
+	int rgb_stride = state->width * 3;
+	size_t frame_size = state->is_y4m
+		? (size_t) state->width * state->height * 3 / 2
+		: (size_t) rgb_stride * state->height;
+	std::vector<char> rgb((size_t) rgb_stride * state->height);
+	std::vector<char> converted(state->is_y4m ? frame_size : 0);
+
+	for (;;) {
+		SDL_LockMutex(state->mutex);
+		while (state->queue.empty() && !state->stopping) {
+			SDL_CondWait(state->cond, state->mutex);
+		}
+		// Frames still in the queue are written before stopping
+		if (state->queue.empty()) {
+			SDL_UnlockMutex(state->mutex);
+			break;
+		}
+		QueuedFrame frame = std::move(state->queue.front());
+		state->queue.pop_front();
+		bool failed = !state->error.empty();
+		SDL_UnlockMutex(state->mutex);
+
+		std::ostringstream message;
+		Uint64 written = 0;
+		if (!failed) {
+			const char *output = state->is_y4m ? converted.data() : rgb.data();
+			if (SDL_ConvertPixels(
+				state->width, state->height,
+				state->src_format, frame.pixels.data(), state->src_stride,
+				SDL_PIXELFORMAT_RGB24, rgb.data(), rgb_stride
+			) < 0) {
+				message << "SDL_ConvertPixels() error: " << SDL_GetError();
+				SDL_ClearError();
+			}
+			else {
+				if (state->is_y4m) {
+					convertToI420(
+						state->width, state->height,
+						reinterpret_cast<const Uint8 *>(rgb.data()), rgb_stride,
+						reinterpret_cast<Uint8 *>(converted.data())
+					);
+				}
+
+				for (; written < frame.repeats; written++) {
+					if (false
+						|| (state->is_y4m && SDL_RWwrite(state->file, "FRAME\n", 1, 6) != 6)
+						|| SDL_RWwrite(state->file, output, 1, frame_size) != frame_size
+					) {
+						message << "SDL_RWwrite() error: " << SDL_GetError();
+						SDL_ClearError();
+						break;
+					}
+				}
+			}
+		}
+
+		SDL_LockMutex(state->mutex);
+		state->frames += written;
+		state->bytes += written * (frame_size + (state->is_y4m ? 6 : 0));
+		if (written < frame.repeats) {
+			state->dropped += frame.repeats - written;
+			if (!failed) { state->error = message.str(); }
+		}
+		state->spare.push_back(std::move(frame.pixels));
+		SDL_UnlockMutex(state->mutex);
+	}
+
+	return 0;
+}
+
+static void
+readFrame (Recorder *state, SDL_Renderer *renderer, SDL_Texture *target, Uint64 repeats)
+{
+	SDL_LockMutex(state->mutex);
+	if (!state->error.empty()) {
+		SDL_UnlockMutex(state->mutex);
+		return;
+	}
+	if (state->queue.size() >= state->depth) {
+		state->dropped += repeats;
+		SDL_UnlockMutex(state->mutex);
+		return;
+	}
+	std::vector<char> pixels;
+	if (!state->spare.empty()) {
+		pixels = std::move(state->spare.back());
+		state->spare.pop_back();
+	}
+	SDL_UnlockMutex(state->mutex);
+
+	pixels.resize((size_t) state->src_stride * state->height);
+
+	SDL_Texture *current_target = SDL_GetRenderTarget(renderer);
+	bool ok = true
+		&& SDL_SetRenderTarget(renderer, target) == 0
+		&& SDL_RenderReadPixels(renderer, nullptr, state->src_format, pixels.data(), state->src_stride) == 0;
+	std::ostringstream message;
+	if (!ok) {
+		message << "SDL_RenderReadPixels() error: " << SDL_GetError();
+		SDL_ClearError();
+	}
+	SDL_SetRenderTarget(renderer, current_target);
+
+	SDL_LockMutex(state->mutex);
+	if (ok) {
+		state->queue.push_back({ std::move(pixels), repeats });
+		SDL_CondSignal(state->cond);
+	}
+	else {
+		state->error = message.str();
+		state->spare.push_back(std::move(pixels));
+	}
+	SDL_UnlockMutex(state->mutex);
+}
+
+// Gives the frames of the recording that are due before `now` to the frame
+// that was on screen until then, and returns how many there were. Frames
+// that arrive up to half a period late still get the one that was due, so
+// that capturing at the refresh rate doesn't skip or repeat frames because
+// of jitter.
+static Uint64
+takeFrames (Recorder *state, Uint64 now)
+{
+	Uint64 due = state->next_frame + state->period / 2;
+	if (now <= due) { return 0; }
+
+	Uint64 count = (now - due - 1) / state->period + 1;
+	state->next_frame += count * state->period;
+	return count;
+}
+
+void
+recorder::addFrame (WindowState *window_state, SDL_Renderer *renderer)
+{
+	Recorder *state = window_state->recorder;
+	if (state == nullptr) { return; }
+
+	FrameCapture &capture = window_state->capture;
+	if (capture.targets[0] == nullptr) { return; }
+
+	Uint64 now = SDL_GetPerformanceCounter();
+
+	// The frame before the one that was just drawn should be done by now
+	if (state->is_pending && capture.frames >= 2) {
+		Uint64 repeats = takeFrames(state, now);
+		if (repeats > 0) {
+			readFrame(state, renderer, capture.targets[1 - capture.latest], repeats);
+		}
+	}
+
+	// The recording starts with the first frame presented
+	if (!state->is_pending) {
+		state->next_frame = now;
+		state->is_pending = true;
+	}
+}
+
+static void
+joinThread (Recorder *state)
+{
+	SDL_LockMutex(state->mutex);
+	state->stopping = true;
+	SDL_CondSignal(state->cond);
+	SDL_UnlockMutex(state->mutex);
+	SDL_WaitThread(state->thread, nullptr);
+	state->thread = nullptr;
+}
+
+static std::string
+finish (WindowState *window_state)
+{
+	Recorder *state = window_state->recorder;
+	window_state->recorder = nullptr;
+
+	if (state->thread != nullptr) { joinThread(state); }
+
+	std::string error = state->error;
+	if (SDL_RWclose(state->file) < 0 && error.empty()) {
+		std::ostringstream message;
+		message << "SDL_RWclose() error: " << SDL_GetError();
+		SDL_ClearError();
+		error = message.str();
+	}
+
+	SDL_DestroyCond(state->cond);
+	SDL_DestroyMutex(state->mutex);
+	delete state;
+
+	return error;
+}
+
+void
+recorder::release (WindowState *window_state)
+{
+	if (window_state->recorder == nullptr) { return; }
+	finish(window_state);
+}
+
+// Descriptors opened by Node.js belong to its C runtime, which on Windows
+// isn't necessarily the one SDL uses, so they are written to directly
+// instead of going through SDL_RWFromFP.
+static size_t
+writeFile (SDL_RWops *file, const void *data, size_t size, size_t count)
+{
+	int fd = (int) (intptr_t) file->hidden.unknown.data1;
+	const char *bytes = static_cast<const char *>(data);
+	size_t total = size * count;
+	size_t written = 0;
+	while (written < total) {
+		auto result = writeToDescriptor(fd, bytes + written, std::min(total - written, (size_t) 1 << 30));
+		if (result < 0 && errno == EINTR) { continue; }
+		// Pipes from Node.js are often non-blocking, and the copy of the
+		// descriptor shares that. Wait for the reader to catch up.
+		if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+#if defined(__WIN32__)
+			SDL_Delay(1);
+#else
+			struct pollfd entry = { fd, POLLOUT, 0 };
+			if (poll(&entry, 1, -1) < 0 && errno != EINTR) {
+				SDL_SetError("poll(%d) failed: %s", fd, strerror(errno));
+				break;
+			}
+#endif
+			continue;
+		}
+		if (result <= 0) {
+			SDL_SetError("write(%d) failed: %s", fd, result < 0 ? strerror(errno) : "nothing written");
+			break;
+		}
+		written += result;
+	}
+	return size == 0 ? 0 : written / size;
+}
+
+static int
+closeFile (SDL_RWops *file)
+{
+	int fd = (int) (intptr_t) file->hidden.unknown.data1;
+	SDL_FreeRW(file);
+	return closeDescriptor(fd);
+}
+
+static SDL_RWops *
+openFile (Napi::Env &env, Napi::Value target)
+{
+	std::ostringstream message;
+
+	if (target.IsString()) {
+		std::string path = target.As<Napi::String>().Utf8Value();
+		SDL_RWops *file = SDL_RWFromFile(path.c_str(), "wb");
+		if (file == nullptr) {
+			message << "SDL_RWFromFile(" << path << ") error: " << SDL_GetError();
+			SDL_ClearError();
+			throw Napi::Error::New(env, message.str());
+		}
+		return file;
+	}
+
+	// Write through a copy of the descriptor, so that the caller still owns
+	// the original and closing the stream doesn't close it.
+	int fd = target.As<Napi::Number>().Int32Value();
+	int copy = dupDescriptor(fd);
+	if (copy < 0) {
+		message << "dup(" << fd << ") error";
+		throw Napi::Error::New(env, message.str());
+	}
+
+	SDL_RWops *file = SDL_AllocRW();
+	if (file == nullptr) {
+		closeDescriptor(copy);
+		message << "SDL_AllocRW() error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	file->write = writeFile;
+	file->close = closeFile;
+	file->hidden.unknown.data1 = (void *) (intptr_t) copy;
+	return file;
+}
+
+Napi::Value
+recorder::start (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *window_state = window::getState(env, info[0]);
+	int window_id = window_state->id;
+	Napi::Value target = info[1];
+	bool is_y4m = info[2].As<Napi::Boolean>().Value();
+	int fps = info[3].As<Napi::Number>().Int32Value();
+	int depth = info[4].As<Napi::Number>().Int32Value();
+
+	window::getRenderer(env, window_state);
+
+	if (window_state->recorder != nullptr) {
+		std::ostringstream message;
+		message << "window " << window_id << " is already being captured";
+		throw Napi::Error::New(env, message.str());
+	}
+
+	FrameCapture &capture = window_state->capture;
+	if (capture.targets[0] == nullptr) {
+		std::ostringstream message;
+		message << "window " << window_id << " has no frame capture";
+		throw Napi::Error::New(env, message.str());
+	}
+
+	SDL_RWops *file = openFile(env, target);
+
+	if (is_y4m) {
+		// Chroma is averaged over 2x2 blocks, which matches the 420jpeg
+		// siting. The range is always limited, see convertToI420.
+		std::ostringstream header;
+		header << "YUV4MPEG2 W" << capture.width << " H" << capture.height
+			<< " F" << fps << ":1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+		std::string text = header.str();
+		if (SDL_RWwrite(file, text.data(), 1, text.size()) != text.size()) {
+			std::ostringstream message;
+			message << "SDL_RWwrite() error: " << SDL_GetError();
+			SDL_ClearError();
+			SDL_RWclose(file);
+			throw Napi::Error::New(env, message.str());
+		}
+	}
+
+	SDL_mutex *mutex = SDL_CreateMutex();
+	if (mutex == nullptr) {
+		std::ostringstream message;
+		message << "SDL_CreateMutex() error: " << SDL_GetError();
+		SDL_ClearError();
+		SDL_RWclose(file);
+		throw Napi::Error::New(env, message.str());
+	}
+
+	SDL_cond *cond = SDL_CreateCond();
+	if (cond == nullptr) {
+		std::ostringstream message;
+		message << "SDL_CreateCond() error: " << SDL_GetError();
+		SDL_ClearError();
+		SDL_DestroyMutex(mutex);
+		SDL_RWclose(file);
+		throw Napi::Error::New(env, message.str());
+	}
+
+	Recorder *state = new Recorder();
+	state->file = file;
+	state->thread = nullptr;
+	state->mutex = mutex;
+	state->cond = cond;
+	state->depth = depth;
+	state->stopping = false;
+	state->width = capture.width;
+	state->height = capture.height;
+	state->src_format = capture.format;
+	state->src_stride = capture.width * SDL_BYTESPERPIXEL(capture.format);
+	state->is_y4m = is_y4m;
+	state->period = std::max<Uint64>(SDL_GetPerformanceFrequency() / fps, 1);
+	state->next_frame = 0;
+	state->is_pending = false;
+	state->frames = 0;
+	state->dropped = 0;
+	state->bytes = 0;
+
+	state->thread = SDL_CreateThread(writeFrames, "sdl:recorder", state);
+	if (state->thread == nullptr) {
+		std::ostringstream message;
+		message << "SDL_CreateThread() error: " << SDL_GetError();
+		SDL_ClearError();
+		SDL_DestroyCond(cond);
+		SDL_DestroyMutex(mutex);
+		SDL_RWclose(file);
+		delete state;
+		throw Napi::Error::New(env, message.str());
+	}
+
+	window_state->recorder = state;
+
+	return env.Undefined();
+}
+
+static Napi::Object
+getCounters (Napi::Env &env, Recorder *state)
+{
+	SDL_LockMutex(state->mutex);
+	Napi::Object stats = Napi::Object::New(env);
+	stats.Set("frames", state->frames);
+	stats.Set("dropped", state->dropped);
+	stats.Set("queued", (double) state->queue.size());
+	stats.Set("bytes", state->bytes);
+	SDL_UnlockMutex(state->mutex);
+	return stats;
+}
+
+Napi::Value
+recorder::stop (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *window_state = window::getState(env, info[0]);
+	Recorder *state = window_state->recorder;
+	if (state == nullptr) { return env.Undefined(); }
+
+	// The most recent frame hasn't been read back yet. It is still on
+	// screen, so it gets every frame of the recording up to now.
+	FrameCapture &capture = window_state->capture;
+	if (state->is_pending && capture.targets[0] != nullptr && capture.frames >= 1) {
+		Uint64 repeats = std::max<Uint64>(takeFrames(state, SDL_GetPerformanceCounter()), 1);
+		readFrame(state, window_state->renderer, capture.targets[capture.latest], repeats);
+	}
+
+	joinThread(state);
+
+	Napi::Object stats = getCounters(env, state);
+	std::string error = finish(window_state);
+	if (!error.empty()) { throw Napi::Error::New(env, error); }
+
+	return stats;
+}
+
+Napi::Value
+recorder::getStats (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *window_state = window::getState(env, info[0]);
+	Recorder *state = window_state->recorder;
+	if (state == nullptr) { return env.Null(); }
+
+	return getCounters(env, state);
+}
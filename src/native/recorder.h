@@ -0,0 +1,19 @@
+#ifndef _RECORDER_H_
+#define _RECORDER_H_
+
+#include <napi.h>
+#include <SDL.h>
+#include "window.h"
+
+namespace recorder {
+
+	void addFrame(WindowState *state, SDL_Renderer *renderer);
+	void release(WindowState *state);
+
+	Napi::Value start(const Napi::CallbackInfo &info);
+	Napi::Value stop(const Napi::CallbackInfo &info);
+	Napi::Value getStats(const Napi::CallbackInfo &info);
+
+}; // namespace recorder
+
+#endif // _RECORDER_H_
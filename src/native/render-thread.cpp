@@ -0,0 +1,437 @@
+#include "render-thread.h"
+#include "window.h"
+#include <SDL.h>
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <sstream>
+#include <vector>
+
+
+// While a window renders asynchronously, its SDL_Renderer belongs to a
+// thread of its own. Frames are copied into a bounded queue on the main
+// thread and uploaded and presented from there, so waiting for vsync in
+// SDL_RenderPresent doesn't block the Node.js event loop.
+//
+// The main thread still reaches the renderer indirectly: SDL's renderer
+// event watch runs wherever window events are sent, and on SIZE_CHANGED,
+// HIDDEN and MINIMIZED it updates the viewport, queues commands and may
+// recreate the backend's render target. So each thread has a lock that it
+// holds while it uses the renderer, and the main thread takes the locks of
+// all threads while pumping events and while changing windows. Events that
+// are dispatched to JS from inside SDL's event filter run with the locks
+// released, so JS never blocks a render thread.
+
+struct Frame {
+	double id;
+	int width;
+	int height;
+	int stride;
+	unsigned int format;
+	std::vector<char> pixels;
+	SDL_ScaleMode scaling;
+	bool has_dst_rect;
+	SDL_Rect dst_rect;
+};
+
+struct RenderThread {
+	WindowState *window_state;
+	SDL_Window *window;
+	SDL_Renderer *renderer;
+	SDL_Thread *thread;
+	SDL_mutex *mutex;
+	SDL_cond *cond;
+	// Held while the renderer is in use, by either thread.
+	SDL_mutex *render_lock;
+	std::deque<Frame> queue;
+	// Pixel buffers of presented frames, kept for reuse.
+	std::vector<std::vector<char>> spare;
+	size_t depth;
+	bool drop_oldest;
+	bool stopping;
+	Napi::ThreadSafeFunction callback;
+
+	// Only used by the render thread
+	SDL_Texture *texture;
+	int width;
+	int height;
+	unsigned int format;
+};
+
+// Every running render thread, in the order their locks are taken. Frames
+// find their thread through the WindowState instead.
+static std::vector<RenderThread *> threads;
+// How many RendererLocks the main thread is holding.
+static int lock_depth = 0;
+
+
+void
+render_thread::lockRenderers ()
+{
+	if (lock_depth++ > 0) { return; }
+	// Always in the same order, so it can't deadlock with another caller
+	for (RenderThread *state : threads) { SDL_LockMutex(state->render_lock); }
+}
+
+void
+render_thread::unlockRenderers ()
+{
+	if (--lock_depth > 0) { return; }
+	for (RenderThread *state : threads) { SDL_UnlockMutex(state->render_lock); }
+}
+
+// Releases the locks before calling into JS, which might start or stop
+// render threads. Returns the depth to pass to resumeLock afterwards.
+int
+render_thread::suspendLock ()
+{
+	int depth = lock_depth;
+	if (depth == 0) { return 0; }
+	for (RenderThread *state : threads) { SDL_UnlockMutex(state->render_lock); }
+	lock_depth = 0;
+	return depth;
+}
+
+void
+render_thread::resumeLock (int depth)
+{
+	if (depth == 0) { return; }
+	for (RenderThread *state : threads) { SDL_LockMutex(state->render_lock); }
+	lock_depth = depth;
+}
+
+
+static RenderThread *
+getThread (Napi::Env &env, WindowState *window_state)
+{
+	RenderThread *state = window_state->render_thread;
+	if (state == nullptr) {
+		std::ostringstream message;
+		message << "no render thread for window " << window_state->id;
+		throw Napi::Error::New(env, message.str());
+	}
+	return state;
+}
+
+static std::string
+presentFrame (RenderThread *state, const Frame &frame)
+{
+	std::ostringstream message;
+
+	if (state->texture == nullptr
+		|| state->width != frame.width
+		|| state->height != frame.height
+		|| state->format != frame.format
+	) {
+		if (state->texture != nullptr) { SDL_DestroyTexture(state->texture); }
+
+		state->texture = SDL_CreateTexture(state->renderer, frame.format, SDL_TEXTUREACCESS_STREAMING, frame.width, frame.height);
+		if (state->texture == nullptr) {
+			message << "SDL_CreateTexture(" << frame.width << ", " << frame.height << ", " << frame.format << ") error: " << SDL_GetError();
+			SDL_ClearError();
+			return message.str();
+		}
+
+		if (SDL_SetTextureBlendMode(state->texture, SDL_BLENDMODE_NONE) < 0) {
+			message << "SDL_SetTextureBlendMode() error: " << SDL_GetError();
+			SDL_ClearError();
+			return message.str();
+		}
+
+		state->width = frame.width;
+		state->height = frame.height;
+		state->format = frame.format;
+	}
+
+	if (SDL_SetTextureScaleMode(state->texture, frame.scaling) < 0) {
+		message << "SDL_SetTextureScaleMode(" << frame.scaling << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		return message.str();
+	}
+
+	Uint64 upload_start = SDL_GetPerformanceCounter();
+	SDL_UpdateTexture(state->texture, nullptr, frame.pixels.data(), frame.stride);
+	window::addUploadTime(state->window_state, upload_start);
+
+	if (SDL_RenderClear(state->renderer) < 0) {
+		message << "SDL_RenderClear() error: " << SDL_GetError();
+		SDL_ClearError();
+		return message.str();
+	}
+
+	if (SDL_RenderCopy(state->renderer, state->texture, nullptr, frame.has_dst_rect ? &frame.dst_rect : nullptr) < 0) {
+		message << "SDL_RenderCopy() error: " << SDL_GetError();
+		SDL_ClearError();
+		return message.str();
+	}
+
+	window::presentRenderer(state->window_state, state->renderer);
+
+	return "";
+}
+
+static int
+renderFrames (void *data)
+{
+	RenderThread *state = static_cast<RenderThread *>(data);
+
+	for (;;) {
+		SDL_LockMutex(state->mutex);
+		while (state->queue.empty() && !state->stopping) {
+			SDL_CondWait(state->cond, state->mutex);
+		}
+		if (state->stopping) {
+			SDL_UnlockMutex(state->mutex);
+			break;
+		}
+		Frame frame = std::move(state->queue.front());
+		state->queue.pop_front();
+		SDL_UnlockMutex(state->mutex);
+
+		SDL_LockMutex(state->render_lock);
+		std::string error = presentFrame(state, frame);
+		SDL_UnlockMutex(state->render_lock);
+
+		double id = frame.id;
+		state->callback.NonBlockingCall([id, error] (Napi::Env env, Napi::Function callback) {
+			callback.Call({
+				Napi::Number::New(env, id),
+				error.empty() ? env.Null() : Napi::Error::New(env, error).Value(),
+			});
+		});
+
+		SDL_LockMutex(state->mutex);
+		state->spare.push_back(std::move(frame.pixels));
+		SDL_UnlockMutex(state->mutex);
+	}
+
+	SDL_LockMutex(state->render_lock);
+
+	if (state->texture != nullptr) {
+		SDL_DestroyTexture(state->texture);
+		state->texture = nullptr;
+	}
+
+	// Hand the OpenGL context back, so that the main thread can make it
+	// current again. This is a no-op for other renderers.
+	SDL_GL_MakeCurrent(state->window, nullptr);
+
+	SDL_UnlockMutex(state->render_lock);
+
+	state->callback.Release();
+	return 0;
+}
+
+Napi::Value
+render_thread::start (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *window_state = window::getState(env, info[0]);
+	int window_id = window_state->id;
+	int depth = info[1].As<Napi::Number>().Int32Value();
+	bool drop_oldest = info[2].As<Napi::Boolean>().Value();
+	Napi::Function callback = info[3].As<Napi::Function>();
+
+	if (window_state->render_thread != nullptr) {
+		std::ostringstream message;
+		message << "window " << window_id << " already has a render thread";
+		throw Napi::Error::New(env, message.str());
+	}
+
+	SDL_Window *window = window_state->window;
+	SDL_Renderer *renderer = window::getRenderer(env, window_state);
+
+	SDL_mutex *mutex = SDL_CreateMutex();
+	if (mutex == nullptr) {
+		std::ostringstream message;
+		message << "SDL_CreateMutex() error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	SDL_cond *cond = SDL_CreateCond();
+	if (cond == nullptr) {
+		std::ostringstream message;
+		message << "SDL_CreateCond() error: " << SDL_GetError();
+		SDL_ClearError();
+		SDL_DestroyMutex(mutex);
+		throw Napi::Error::New(env, message.str());
+	}
+
+	SDL_mutex *render_lock = SDL_CreateMutex();
+	if (render_lock == nullptr) {
+		std::ostringstream message;
+		message << "SDL_CreateMutex() error: " << SDL_GetError();
+		SDL_ClearError();
+		SDL_DestroyCond(cond);
+		SDL_DestroyMutex(mutex);
+		throw Napi::Error::New(env, message.str());
+	}
+
+	// A thread that starts while the main thread holds the locks of the
+	// others has to be locked too, or unlockRenderers would unbalance it.
+	if (lock_depth > 0) { SDL_LockMutex(render_lock); }
+
+	RenderThread *state = new RenderThread();
+	state->window_state = window_state;
+	state->window = window;
+	state->renderer = renderer;
+	state->thread = nullptr;
+	state->mutex = mutex;
+	state->cond = cond;
+	state->render_lock = render_lock;
+	state->depth = depth;
+	state->drop_oldest = drop_oldest;
+	state->stopping = false;
+	state->callback = Napi::ThreadSafeFunction::New(env, callback, "@kmamal/sdl:render", 0, 1);
+	state->texture = nullptr;
+
+	// An OpenGL context can only be current on one thread at a time
+	SDL_GL_MakeCurrent(window, nullptr);
+
+	state->thread = SDL_CreateThread(renderFrames, "sdl:render", state);
+	if (state->thread == nullptr) {
+		std::ostringstream message;
+		message << "SDL_CreateThread() error: " << SDL_GetError();
+		SDL_ClearError();
+		state->callback.Release();
+		if (lock_depth > 0) { SDL_UnlockMutex(render_lock); }
+		SDL_DestroyMutex(render_lock);
+		SDL_DestroyCond(cond);
+		SDL_DestroyMutex(mutex);
+		delete state;
+		throw Napi::Error::New(env, message.str());
+	}
+
+	threads.push_back(state);
+	window_state->render_thread = state;
+
+	return env.Undefined();
+}
+
+Napi::Value
+render_thread::render (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *window_state = window::getState(env, info[0]);
+	int width = info[1].As<Napi::Number>().Int32Value();
+	int height = info[2].As<Napi::Number>().Int32Value();
+	int stride = info[3].As<Napi::Number>().Int32Value();
+	unsigned int format = info[4].As<Napi::Number>().Int32Value();
+	Napi::Buffer<char> buffer = info[5].As<Napi::Buffer<char>>();
+	SDL_ScaleMode scaling = static_cast<SDL_ScaleMode>(info[6].As<Napi::Number>().Int32Value());
+	Napi::Value dstRectVal = info[7];
+	double id = info[8].As<Napi::Number>().DoubleValue();
+
+	RenderThread *state = getThread(env, window_state);
+
+	Frame frame;
+	frame.id = id;
+	frame.width = width;
+	frame.height = height;
+	frame.stride = stride;
+	frame.format = format;
+	frame.scaling = scaling;
+	frame.has_dst_rect = !dstRectVal.IsNull();
+	if (frame.has_dst_rect) {
+		Napi::Object dstRect = dstRectVal.As<Napi::Object>();
+		frame.dst_rect.x = dstRect.Get("x").As<Napi::Number>().Int32Value();
+		frame.dst_rect.y = dstRect.Get("y").As<Napi::Number>().Int32Value();
+		frame.dst_rect.w = dstRect.Get("width").As<Napi::Number>().Int32Value();
+		frame.dst_rect.h = dstRect.Get("height").As<Napi::Number>().Int32Value();
+	}
+
+	Napi::Array dropped = Napi::Array::New(env);
+
+	SDL_LockMutex(state->mutex);
+
+	if (state->queue.size() >= state->depth && !state->drop_oldest) {
+		SDL_UnlockMutex(state->mutex);
+		dropped.Set(0u, id);
+		return dropped;
+	}
+
+	while (state->queue.size() >= state->depth) {
+		dropped.Set(dropped.Length(), state->queue.front().id);
+		state->spare.push_back(std::move(state->queue.front().pixels));
+		state->queue.pop_front();
+	}
+
+	if (!state->spare.empty()) {
+		frame.pixels = std::move(state->spare.back());
+		state->spare.pop_back();
+	}
+
+	SDL_UnlockMutex(state->mutex);
+
+	// Copy outside of the lock, so the render thread isn't kept waiting
+	size_t size = (size_t) stride * height;
+	frame.pixels.resize(size);
+	SDL_memcpy(frame.pixels.data(), buffer.Data(), size);
+
+	SDL_LockMutex(state->mutex);
+	state->queue.push_back(std::move(frame));
+	SDL_CondSignal(state->cond);
+	SDL_UnlockMutex(state->mutex);
+
+	return dropped;
+}
+
+static void
+joinThread (WindowState *window_state)
+{
+	RenderThread *state = window_state->render_thread;
+	window_state->render_thread = nullptr;
+	threads.erase(std::find(threads.begin(), threads.end(), state));
+
+	// The thread needs its lock to finish
+	if (lock_depth > 0) { SDL_UnlockMutex(state->render_lock); }
+
+	SDL_LockMutex(state->mutex);
+	state->stopping = true;
+	SDL_CondSignal(state->cond);
+	SDL_UnlockMutex(state->mutex);
+
+	SDL_WaitThread(state->thread, nullptr);
+}
+
+static void
+freeThread (RenderThread *state)
+{
+	SDL_DestroyMutex(state->render_lock);
+	SDL_DestroyCond(state->cond);
+	SDL_DestroyMutex(state->mutex);
+	delete state;
+}
+
+// Called when the window is destroyed. Frames still in the queue are
+// dropped without telling JS.
+void
+render_thread::release (WindowState *window_state)
+{
+	RenderThread *state = window_state->render_thread;
+	if (state == nullptr) { return; }
+	joinThread(window_state);
+	freeThread(state);
+}
+
+Napi::Value
+render_thread::stop (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *window_state = window::getState(env, info[0]);
+	RenderThread *state = getThread(env, window_state);
+	joinThread(window_state);
+
+	Napi::Array dropped = Napi::Array::New(env);
+	for (const Frame &frame : state->queue) {
+		dropped.Set(dropped.Length(), frame.id);
+	}
+
+	freeThread(state);
+
+	return dropped;
+}
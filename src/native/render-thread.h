@@ -0,0 +1,32 @@
+#ifndef _RENDER_THREAD_H_
+#define _RENDER_THREAD_H_
+
+#include <napi.h>
+#include <SDL.h>
+#include "window.h"
+
+namespace render_thread {
+
+	void lockRenderers();
+	void unlockRenderers();
+	int suspendLock();
+	void resumeLock(int depth);
+	void release(WindowState *state);
+
+	Napi::Value start(const Napi::CallbackInfo &info);
+	Napi::Value render(const Napi::CallbackInfo &info);
+	Napi::Value stop(const Napi::CallbackInfo &info);
+
+}; // namespace render_thread
+
+// Holds the renderer locks of all render threads for as long as it lives.
+// Taken on the main thread around anything that can make SDL send window
+// events, see render-thread.cpp
+struct RendererLock {
+	RendererLock () { render_thread::lockRenderers(); }
+	~RendererLock () { render_thread::unlockRenderers(); }
+	RendererLock (const RendererLock &) = delete;
+	RendererLock &operator= (const RendererLock &) = delete;
+};
+
+#endif // _RENDER_THREAD_H_
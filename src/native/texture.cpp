@@ -0,0 +1,359 @@
+#include "texture.h"
+#include "window.h"
+#include <SDL.h>
+#include <string>
+#include <sstream>
+#include <map>
+
+
+// Textures are created on a window's renderer and destroyed with it, so
+// they are tracked here to be cleaned up when the renderer goes away.
+struct Texture {
+	SDL_Window *window;
+	SDL_Renderer *renderer;
+	SDL_Texture *texture;
+	int width;
+	int height;
+	unsigned int format;
+	bool is_target;
+};
+
+static std::map<int, Texture> textures;
+static int next_id = 1;
+
+// Layout of a vertex passed to drawGeometry, in bytes:
+//   float x, float y, Uint8 r, g, b, a, float u, float v
+const int VERTEX_SIZE = 20;
+const int VERTEX_COLOR_OFFSET = 8;
+const int VERTEX_UV_OFFSET = 12;
+
+
+static Texture &
+getTexture (Napi::Env &env, int texture_id)
+{
+	auto it = textures.find(texture_id);
+	if (it == textures.end()) {
+		std::ostringstream message;
+		message << "invalid texture " << texture_id;
+		throw Napi::Error::New(env, message.str());
+	}
+	return it->second;
+}
+
+static SDL_Rect *
+getRect (Napi::Value rectVal, SDL_Rect *rect)
+{
+	if (rectVal.IsNull()) { return nullptr; }
+
+	Napi::Object object = rectVal.As<Napi::Object>();
+	rect->x = object.Get("x").As<Napi::Number>().Int32Value();
+	rect->y = object.Get("y").As<Napi::Number>().Int32Value();
+	rect->w = object.Get("width").As<Napi::Number>().Int32Value();
+	rect->h = object.Get("height").As<Napi::Number>().Int32Value();
+	return rect;
+}
+
+void
+texture::destroyAll (SDL_Window *window)
+{
+	for (auto it = textures.begin(); it != textures.end();) {
+		if (it->second.window == window) {
+			SDL_DestroyTexture(it->second.texture);
+			it = textures.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+Napi::Value
+texture::create (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = window::getState(env, info[0]);
+	int width = info[1].As<Napi::Number>().Int32Value();
+	int height = info[2].As<Napi::Number>().Int32Value();
+	unsigned int format = info[3].As<Napi::Number>().Int32Value();
+	bool is_target = info[4].As<Napi::Boolean>().Value();
+
+	SDL_Renderer *renderer = window::getRenderer(env, state);
+
+	if (is_target && !SDL_RenderTargetSupported(renderer)) {
+		std::ostringstream message;
+		message << "texture_create(" << state->id << ") error: renderer doesn't support render targets";
+		throw Napi::Error::New(env, message.str());
+	}
+
+	SDL_TextureAccess access = is_target ? SDL_TEXTUREACCESS_TARGET : SDL_TEXTUREACCESS_STATIC;
+	SDL_Texture *texture = SDL_CreateTexture(renderer, format, access, width, height);
+	if (texture == nullptr) {
+		std::ostringstream message;
+		message << "SDL_CreateTexture(" << width << ", " << height << ", " << format << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	int texture_id = next_id++;
+	textures[texture_id] = { state->window, renderer, texture, width, height, format, is_target };
+
+	return Napi::Number::New(env, texture_id);
+}
+
+Napi::Value
+texture::update (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	int texture_id = info[0].As<Napi::Number>().Int32Value();
+	int stride = info[1].As<Napi::Number>().Int32Value();
+	Napi::Buffer<char> buffer = info[2].As<Napi::Buffer<char>>();
+	SDL_Rect rect;
+	SDL_Rect *update_rect = getRect(info[3], &rect);
+
+	Texture &entry = getTexture(env, texture_id);
+
+	// SDL reads whole rows of the rect, except for the padding after the
+	// last one.
+	int width = update_rect != nullptr ? rect.w : entry.width;
+	int height = update_rect != nullptr ? rect.h : entry.height;
+	size_t row_size = (size_t) width * SDL_BYTESPERPIXEL(entry.format);
+	if (stride < 0 || (size_t) stride < row_size || buffer.Length() < (size_t) (height - 1) * stride + row_size) {
+		std::ostringstream message;
+		message << "texture_update(" << texture_id << ") error: buffer is smaller than expected";
+		throw Napi::Error::New(env, message.str());
+	}
+
+	if (SDL_UpdateTexture(entry.texture, update_rect, buffer.Data(), stride) < 0) {
+		std::ostringstream message;
+		message << "SDL_UpdateTexture(" << texture_id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	return env.Undefined();
+}
+
+Napi::Value
+texture::draw (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = window::getState(env, info[0]);
+	int texture_id = info[1].As<Napi::Number>().Int32Value();
+	SDL_Rect src;
+	SDL_Rect *src_rect = getRect(info[2], &src);
+	SDL_Rect dst;
+	SDL_Rect *dst_rect = getRect(info[3], &dst);
+	SDL_ScaleMode scaling = static_cast<SDL_ScaleMode>(info[4].As<Napi::Number>().Int32Value());
+	SDL_BlendMode blend = static_cast<SDL_BlendMode>(info[5].As<Napi::Number>().Int32Value());
+	int alpha = info[6].As<Napi::Number>().Int32Value();
+	double angle = info[7].As<Napi::Number>().DoubleValue();
+	bool flip_x = info[8].As<Napi::Boolean>().Value();
+	bool flip_y = info[9].As<Napi::Boolean>().Value();
+	bool clear = info[10].As<Napi::Boolean>().Value();
+
+	Texture &entry = getTexture(env, texture_id);
+	SDL_Renderer *renderer = entry.renderer;
+
+	window::beginFrame(state, SDL_GetPerformanceCounter());
+
+	if (clear && SDL_RenderClear(renderer) < 0) {
+		std::ostringstream message;
+		message << "SDL_RenderClear() error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	if (false
+		|| SDL_SetTextureScaleMode(entry.texture, scaling) < 0
+		|| SDL_SetTextureBlendMode(entry.texture, blend) < 0
+		|| SDL_SetTextureAlphaMod(entry.texture, alpha) < 0
+	) {
+		std::ostringstream message;
+		message << "SDL_SetTexture*(" << texture_id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	int result;
+	if (angle == 0 && !flip_x && !flip_y) {
+		result = SDL_RenderCopy(renderer, entry.texture, src_rect, dst_rect);
+	}
+	else {
+		int flip = 0
+			| (flip_x ? SDL_FLIP_HORIZONTAL : 0)
+			| (flip_y ? SDL_FLIP_VERTICAL : 0);
+		result = SDL_RenderCopyEx(renderer, entry.texture, src_rect, dst_rect, angle, nullptr, static_cast<SDL_RendererFlip>(flip));
+	}
+
+	if (result < 0) {
+		std::ostringstream message;
+		message << "SDL_RenderCopy(" << texture_id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	return env.Undefined();
+}
+
+Napi::Value
+texture::drawGeometry (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = window::getState(env, info[0]);
+	int window_id = state->id;
+	Napi::Value textureVal = info[1];
+	Napi::TypedArray vertices = info[2].As<Napi::TypedArray>();
+	Napi::Value indicesVal = info[3];
+	SDL_ScaleMode scaling = static_cast<SDL_ScaleMode>(info[4].As<Napi::Number>().Int32Value());
+	SDL_BlendMode blend = static_cast<SDL_BlendMode>(info[5].As<Napi::Number>().Int32Value());
+	bool clear = info[6].As<Napi::Boolean>().Value();
+
+	SDL_Renderer *renderer = window::getRenderer(env, state);
+
+	window::beginFrame(state, SDL_GetPerformanceCounter());
+
+	SDL_Texture *texture = nullptr;
+	if (!textureVal.IsNull()) {
+		int texture_id = textureVal.As<Napi::Number>().Int32Value();
+		texture = getTexture(env, texture_id).texture;
+
+		if (false
+			|| SDL_SetTextureScaleMode(texture, scaling) < 0
+			|| SDL_SetTextureBlendMode(texture, blend) < 0
+			|| SDL_SetTextureAlphaMod(texture, 255) < 0
+		) {
+			std::ostringstream message;
+			message << "SDL_SetTexture*(" << texture_id << ") error: " << SDL_GetError();
+			SDL_ClearError();
+			throw Napi::Error::New(env, message.str());
+		}
+	}
+	else if (SDL_SetRenderDrawBlendMode(renderer, blend) < 0) {
+		std::ostringstream message;
+		message << "SDL_SetRenderDrawBlendMode(" << window_id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	const char *data = static_cast<const char *>(vertices.ArrayBuffer().Data()) + vertices.ByteOffset();
+	int num_vertices = vertices.ByteLength() / VERTEX_SIZE;
+
+	const void *indices = nullptr;
+	int num_indices = 0;
+	int index_size = 0;
+	if (!indicesVal.IsNull()) {
+		Napi::TypedArray indicesArray = indicesVal.As<Napi::TypedArray>();
+		indices = static_cast<const char *>(indicesArray.ArrayBuffer().Data()) + indicesArray.ByteOffset();
+		num_indices = indicesArray.ElementLength();
+		index_size = indicesArray.ElementSize();
+	}
+
+	if (clear && SDL_RenderClear(renderer) < 0) {
+		std::ostringstream message;
+		message << "SDL_RenderClear(" << window_id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	int result = SDL_RenderGeometryRaw(
+		renderer,
+		texture,
+		reinterpret_cast<const float *>(data), VERTEX_SIZE,
+		reinterpret_cast<const SDL_Color *>(data + VERTEX_COLOR_OFFSET), VERTEX_SIZE,
+		reinterpret_cast<const float *>(data + VERTEX_UV_OFFSET), VERTEX_SIZE,
+		num_vertices,
+		indices, num_indices, index_size
+	);
+	if (result < 0) {
+		std::ostringstream message;
+		message << "SDL_RenderGeometryRaw(" << window_id << ", " << num_vertices << ", " << num_indices << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	return env.Undefined();
+}
+
+Napi::Value
+texture::setTarget (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = window::getState(env, info[0]);
+	Napi::Value textureVal = info[1];
+
+	SDL_Renderer *renderer = window::getRenderer(env, state);
+
+	SDL_Texture *target = nullptr;
+	if (!textureVal.IsNull()) {
+		int texture_id = textureVal.As<Napi::Number>().Int32Value();
+		target = getTexture(env, texture_id).texture;
+	}
+
+	if (SDL_SetRenderTarget(renderer, target) < 0) {
+		std::ostringstream message;
+		message << "SDL_SetRenderTarget(" << state->id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	return env.Undefined();
+}
+
+Napi::Value
+texture::readPixels (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	int texture_id = info[0].As<Napi::Number>().Int32Value();
+	SDL_Rect rect;
+	SDL_Rect *read_rect = getRect(info[1], &rect);
+
+	Texture &entry = getTexture(env, texture_id);
+	if (!entry.is_target) {
+		std::ostringstream message;
+		message << "texture " << texture_id << " is not a render target";
+		throw Napi::Error::New(env, message.str());
+	}
+
+	int width = read_rect != nullptr ? read_rect->w : entry.width;
+	int height = read_rect != nullptr ? read_rect->h : entry.height;
+	int stride = width * SDL_BYTESPERPIXEL(entry.format);
+	Napi::Buffer<char> pixels = Napi::Buffer<char>::New(env, (size_t) stride * height);
+
+	SDL_Texture *current_target = SDL_GetRenderTarget(entry.renderer);
+	if (false
+		|| SDL_SetRenderTarget(entry.renderer, entry.texture) < 0
+		|| SDL_RenderReadPixels(entry.renderer, read_rect, entry.format, pixels.Data(), stride) < 0
+	) {
+		std::ostringstream message;
+		message << "SDL_RenderReadPixels(" << texture_id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		SDL_SetRenderTarget(entry.renderer, current_target);
+		throw Napi::Error::New(env, message.str());
+	}
+	SDL_SetRenderTarget(entry.renderer, current_target);
+
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("buffer", pixels);
+	result.Set("stride", stride);
+	return result;
+}
+
+Napi::Value
+texture::destroy (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	int texture_id = info[0].As<Napi::Number>().Int32Value();
+
+	Texture &entry = getTexture(env, texture_id);
+	SDL_DestroyTexture(entry.texture);
+	textures.erase(texture_id);
+
+	return env.Undefined();
+}
@@ -0,0 +1,21 @@
+#ifndef _TEXTURE_H_
+#define _TEXTURE_H_
+
+#include <napi.h>
+#include <SDL.h>
+
+namespace texture {
+
+	void destroyAll(SDL_Window *window);
+
+	Napi::Value create(const Napi::CallbackInfo &info);
+	Napi::Value update(const Napi::CallbackInfo &info);
+	Napi::Value draw(const Napi::CallbackInfo &info);
+	Napi::Value drawGeometry(const Napi::CallbackInfo &info);
+	Napi::Value setTarget(const Napi::CallbackInfo &info);
+	Napi::Value readPixels(const Napi::CallbackInfo &info);
+	Napi::Value destroy(const Napi::CallbackInfo &info);
+
+}; // namespace texture
+
+#endif // _TEXTURE_H_
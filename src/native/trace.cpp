@@ -0,0 +1,314 @@
+#include "trace.h"
+#include "events.h"
+#include <SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <sstream>
+#include <vector>
+
+
+// A trace file starts with a 16 byte header:
+//   char[8] magic, Uint16 version, Uint16 sizeof(SDL_Event), Uint32 reserved
+// followed by one record per event:
+//   Uint64 nanoseconds since the start of the recording, SDL_Event event
+// Integers in the header and record are little-endian. Events are stored as
+// they are in memory, so traces can only be replayed on the same platform.
+static const char TRACE_MAGIC[8] = { 'S', 'D', 'L', 'T', 'R', 'A', 'C', 'E' };
+static const Uint16 TRACE_VERSION = 1;
+static const size_t TRACE_HEADER_SIZE = 16;
+static const size_t TRACE_RECORD_SIZE = sizeof(Uint64) + sizeof(SDL_Event);
+static const size_t TRACE_BUFFER_SIZE = 64 * 1024;
+
+static std::atomic<bool> is_recording(false);
+static SDL_mutex *record_mutex = nullptr;
+static SDL_RWops *record_file = nullptr;
+static std::vector<Uint8> record_buffer;
+static Uint64 record_start;
+static double record_count;
+static bool record_failed;
+
+static SDL_Thread *replay_thread = nullptr;
+static SDL_RWops *replay_file = nullptr;
+static double replay_speed;
+static std::atomic<bool> replay_stopping(false);
+static Napi::ThreadSafeFunction replay_callback;
+
+
+static bool
+shouldRecord (const SDL_Event &event)
+{
+	// Device, drop and user events either point to memory we don't own or
+	// refer to devices that might not be there during the replay.
+	switch (event.type) {
+		case SDL_QUIT:
+		case SDL_WINDOWEVENT:
+		case SDL_KEYDOWN:
+		case SDL_KEYUP:
+		case SDL_TEXTEDITING:
+		case SDL_TEXTINPUT:
+		case SDL_MOUSEMOTION:
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+		case SDL_MOUSEWHEEL:
+		case SDL_FINGERDOWN:
+		case SDL_FINGERUP:
+		case SDL_FINGERMOTION:
+			return true;
+	}
+	return false;
+}
+
+static Uint64
+getElapsedNanoseconds (Uint64 start)
+{
+	Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+	return (Uint64) (elapsed * (1e9 / SDL_GetPerformanceFrequency()));
+}
+
+static bool
+flushRecording ()
+{
+	if (record_buffer.empty()) { return true; }
+
+	size_t size = record_buffer.size();
+	size_t written = SDL_RWwrite(record_file, record_buffer.data(), 1, size);
+	record_buffer.clear();
+	return written == size;
+}
+
+void
+trace::filterEvent (const SDL_Event &event)
+{
+	if (!is_recording) { return; }
+	if (!shouldRecord(event)) { return; }
+
+	SDL_LockMutex(record_mutex);
+
+	if (is_recording && !record_failed) {
+		Uint64 time = SDL_SwapLE64(getElapsedNanoseconds(record_start));
+		size_t offset = record_buffer.size();
+		record_buffer.resize(offset + TRACE_RECORD_SIZE);
+		SDL_memcpy(record_buffer.data() + offset, &time, sizeof(time));
+		SDL_memcpy(record_buffer.data() + offset + sizeof(time), &event, sizeof(event));
+		record_count++;
+
+		if (record_buffer.size() >= TRACE_BUFFER_SIZE) {
+			record_failed = !flushRecording();
+		}
+	}
+
+	SDL_UnlockMutex(record_mutex);
+}
+
+Napi::Value
+trace::startRecording (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	std::string path = info[0].As<Napi::String>().Utf8Value();
+
+	if (is_recording) {
+		throw Napi::Error::New(env, "already recording");
+	}
+
+	SDL_RWops *file = SDL_RWFromFile(path.c_str(), "wb");
+	if (file == nullptr) {
+		std::ostringstream message;
+		message << "SDL_RWFromFile(" << path << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	Uint8 header[TRACE_HEADER_SIZE] = {};
+	SDL_memcpy(header, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+	Uint16 version = SDL_SwapLE16(TRACE_VERSION);
+	Uint16 event_size = SDL_SwapLE16(sizeof(SDL_Event));
+	SDL_memcpy(header + 8, &version, sizeof(version));
+	SDL_memcpy(header + 10, &event_size, sizeof(event_size));
+
+	if (SDL_RWwrite(file, header, 1, TRACE_HEADER_SIZE) != TRACE_HEADER_SIZE) {
+		std::ostringstream message;
+		message << "SDL_RWwrite(" << path << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		SDL_RWclose(file);
+		throw Napi::Error::New(env, message.str());
+	}
+
+	if (record_mutex == nullptr) {
+		record_mutex = SDL_CreateMutex();
+		if (record_mutex == nullptr) {
+			std::ostringstream message;
+			message << "SDL_CreateMutex() error: " << SDL_GetError();
+			SDL_ClearError();
+			SDL_RWclose(file);
+			throw Napi::Error::New(env, message.str());
+		}
+	}
+
+	SDL_LockMutex(record_mutex);
+	record_file = file;
+	record_buffer.reserve(TRACE_BUFFER_SIZE + TRACE_RECORD_SIZE);
+	record_start = SDL_GetPerformanceCounter();
+	record_count = 0;
+	record_failed = false;
+	is_recording = true;
+	SDL_UnlockMutex(record_mutex);
+
+	events::keepAllFamilies(true);
+
+	return env.Undefined();
+}
+
+Napi::Value
+trace::stopRecording (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	if (!is_recording) { return env.Undefined(); }
+
+	events::keepAllFamilies(false);
+
+	SDL_LockMutex(record_mutex);
+	is_recording = false;
+	bool failed = record_failed || !flushRecording();
+	failed = SDL_RWclose(record_file) < 0 || failed;
+	record_file = nullptr;
+	record_buffer.clear();
+	record_buffer.shrink_to_fit();
+	double count = record_count;
+	SDL_UnlockMutex(record_mutex);
+
+	if (failed) {
+		std::ostringstream message;
+		message << "SDL_RWwrite() error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	return Napi::Number::New(env, count);
+}
+
+
+static void
+finishReplay (Napi::Env, Napi::Function callback)
+{
+	// The thread might already have been joined by stopReplay()
+	if (replay_thread != nullptr) {
+		SDL_WaitThread(replay_thread, nullptr);
+		replay_thread = nullptr;
+	}
+
+	callback.Call({});
+}
+
+static int
+replayEvents (void *)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	bool paced = std::isfinite(replay_speed);
+
+	Uint8 record[TRACE_RECORD_SIZE];
+	while (!replay_stopping) {
+		if (SDL_RWread(replay_file, record, TRACE_RECORD_SIZE, 1) != 1) { break; }
+
+		Uint64 time;
+		SDL_Event event;
+		SDL_memcpy(&time, record, sizeof(time));
+		SDL_memcpy(&event, record + sizeof(time), sizeof(event));
+		time = SDL_SwapLE64(time);
+
+		if (paced) {
+			double target = time / replay_speed;
+			for (;;) {
+				double remaining = (target - getElapsedNanoseconds(start)) / 1e6;
+				if (remaining <= 0 || replay_stopping) { break; }
+				// Short sleeps keep stopReplay() responsive
+				SDL_Delay((Uint32) std::min(remaining, 10.0));
+			}
+		}
+
+		// The queue might be full if we are replaying faster than it's polled
+		while (!replay_stopping && SDL_PushEvent(&event) < 0) { SDL_Delay(1); }
+	}
+
+	SDL_RWclose(replay_file);
+	replay_file = nullptr;
+
+	replay_callback.NonBlockingCall(finishReplay);
+	replay_callback.Release();
+	return 0;
+}
+
+Napi::Value
+trace::startReplay (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	std::string path = info[0].As<Napi::String>().Utf8Value();
+	double speed = info[1].As<Napi::Number>().DoubleValue();
+	Napi::Function callback = info[2].As<Napi::Function>();
+
+	if (replay_thread != nullptr) {
+		throw Napi::Error::New(env, "a replay is already running");
+	}
+
+	SDL_RWops *file = SDL_RWFromFile(path.c_str(), "rb");
+	if (file == nullptr) {
+		std::ostringstream message;
+		message << "SDL_RWFromFile(" << path << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	Uint8 header[TRACE_HEADER_SIZE];
+	if (SDL_RWread(file, header, TRACE_HEADER_SIZE, 1) != 1) {
+		SDL_RWclose(file);
+		throw Napi::Error::New(env, "invalid trace file");
+	}
+
+	Uint16 version, event_size;
+	SDL_memcpy(&version, header + 8, sizeof(version));
+	SDL_memcpy(&event_size, header + 10, sizeof(event_size));
+	if (false
+		|| SDL_memcmp(header, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0
+		|| SDL_SwapLE16(version) != TRACE_VERSION
+		|| SDL_SwapLE16(event_size) != sizeof(SDL_Event)
+	) {
+		SDL_RWclose(file);
+		throw Napi::Error::New(env, "invalid trace file");
+	}
+
+	replay_file = file;
+	replay_speed = speed;
+	replay_stopping = false;
+	replay_callback = Napi::ThreadSafeFunction::New(env, callback, "@kmamal/sdl:replay", 0, 1);
+
+	replay_thread = SDL_CreateThread(replayEvents, "sdl:replay", nullptr);
+	if (replay_thread == nullptr) {
+		std::ostringstream message;
+		message << "SDL_CreateThread() error: " << SDL_GetError();
+		SDL_ClearError();
+		replay_callback.Release();
+		SDL_RWclose(file);
+		replay_file = nullptr;
+		throw Napi::Error::New(env, message.str());
+	}
+
+	return env.Undefined();
+}
+
+Napi::Value
+trace::stopReplay (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	if (replay_thread == nullptr) { return env.Undefined(); }
+
+	replay_stopping = true;
+	SDL_WaitThread(replay_thread, nullptr);
+	replay_thread = nullptr;
+
+	return env.Undefined();
+}
@@ -0,0 +1,18 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <napi.h>
+#include <SDL.h>
+
+namespace trace {
+
+	void filterEvent(const SDL_Event &event);
+
+	Napi::Value startRecording(const Napi::CallbackInfo &info);
+	Napi::Value stopRecording(const Napi::CallbackInfo &info);
+	Napi::Value startReplay(const Napi::CallbackInfo &info);
+	Napi::Value stopReplay(const Napi::CallbackInfo &info);
+
+}; // namespace trace
+
+#endif // _TRACE_H_
@@ -1,18 +1,20 @@
 #include "window.h"
+#include "events.h"
+#include "texture.h"
+#include "recorder.h"
+#include "pixels.h"
+#include "video.h"
+#include "render-thread.h"
 #include <SDL.h>
 #include <SDL_syswm.h>
 #include <string>
 #include <sstream>
-#include <map>
+#include <vector>
+#include <cstring>
+#include <algorithm>
 
-struct CachedTexture {
-	SDL_Texture *texture;
-	int width;
-	int height;
-	unsigned int format;
-};
-
-std::map<SDL_Window*, CachedTexture> cachedTextures;
+// Damage detection compares frames in squares of this many pixels.
+const int TILE_SIZE = 64;
 
 #if defined(__LINUX__)
 	#define NativeWindowHandle Window
@@ -40,34 +42,287 @@ std::map<SDL_Window*, CachedTexture> cachedTextures;
 	#define GPU_WINDOW_FLAG SDL_WINDOW_METAL
 #endif
 
+WindowState *
+window::getState (Napi::Env &env, Napi::Value value)
+{
+	WindowState *state = value.As<Napi::External<WindowState>>().Data();
+	if (state->window == nullptr) {
+		std::ostringstream message;
+		message << "window " << state->id << " is destroyed";
+		throw Napi::Error::New(env, message.str());
+	}
+	return state;
+}
+
+SDL_Renderer *
+window::getRenderer (Napi::Env &env, WindowState *state)
+{
+	if (state->renderer == nullptr) {
+		std::ostringstream message;
+		message << "window " << state->id << " has no renderer";
+		throw Napi::Error::New(env, message.str());
+	}
+	return state->renderer;
+}
+
+static double
+getMillisSince (Uint64 start, Uint64 end)
+{
+	return (double) (end - start) * 1e3 / SDL_GetPerformanceFrequency();
+}
+
+// Remembers when the first upload or draw of a frame happened, to tell
+// frames that took too long from ones that simply weren't asked for.
+void
+window::beginFrame (WindowState *state, Uint64 start)
+{
+	FrameStats &stats = state->frame_stats;
+	SDL_AtomicLock(&stats.lock);
+	if (stats.frame_start == 0) { stats.frame_start = start; }
+	SDL_AtomicUnlock(&stats.lock);
+}
+
+void
+window::addUploadTime (WindowState *state, Uint64 start)
+{
+	double millis = getMillisSince(start, SDL_GetPerformanceCounter());
+
+	FrameStats &stats = state->frame_stats;
+	SDL_AtomicLock(&stats.lock);
+	if (stats.frame_start == 0) { stats.frame_start = start; }
+	histogram::add(stats.upload, millis);
+	SDL_AtomicUnlock(&stats.lock);
+}
+
+// Presents the frame and records how long that took and how long it has
+// been since the previous one. A frame whose work started within one
+// refresh of the previous present was due at the next refresh, so every
+// further refresh it took until its present is counted as a missed vblank.
+// Frames started later than that follow a pause, like when only rendering
+// on change, and the pause isn't counted.
+void
+window::presentRenderer (WindowState *state, SDL_Renderer *renderer)
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	SDL_RenderPresent(renderer);
+	Uint64 end = SDL_GetPerformanceCounter();
+
+	// The window can move to another display, so look this up every time.
+	// On Windows this asks the system which monitor the window is on. That is
+	// fine from the render thread, which holds its renderer lock here, so the
+	// main thread isn't changing the window at the same time.
+	int refresh_rate = 0;
+	SDL_DisplayMode mode;
+	int display = SDL_GetWindowDisplayIndex(state->window);
+	if (display >= 0 && SDL_GetCurrentDisplayMode(display, &mode) == 0) {
+		refresh_rate = mode.refresh_rate;
+	}
+	else {
+		SDL_ClearError();
+	}
+
+	FrameStats &stats = state->frame_stats;
+	SDL_AtomicLock(&stats.lock);
+	stats.frames++;
+	stats.refresh_rate = refresh_rate;
+	histogram::add(stats.present, getMillisSince(start, end));
+	Uint64 frame_start = stats.frame_start != 0 ? stats.frame_start : start;
+	if (stats.last_present != 0) {
+		histogram::add(stats.interval, getMillisSince(stats.last_present, end));
+		bool is_due = frame_start <= stats.last_present
+			|| getMillisSince(stats.last_present, frame_start) * refresh_rate <= 1e3;
+		if (refresh_rate > 0 && is_due) {
+			Sint64 vblanks = (Sint64) (getMillisSince(frame_start, end) * refresh_rate / 1e3 + 0.5);
+			if (vblanks > 1) { stats.missed_vblanks += vblanks - 1; }
+		}
+	}
+	stats.frame_start = 0;
+	stats.last_present = end;
+	SDL_AtomicUnlock(&stats.lock);
+}
+
+using window::getState;
+using window::getRenderer;
+
+// Detaches the ArrayBuffer that JS was given by lockTexture, so that it
+// can't be used to write into the texture after SDL_UnlockTexture.
+static void
+unlockTexture (CachedTexture &cached)
+{
+	if (cached.locked == nullptr) { return; }
+
+	Napi::ArrayBuffer pixels = cached.locked->Value();
+	if (!pixels.IsDetached()) { pixels.Detach(); }
+	delete cached.locked;
+	cached.locked = nullptr;
+
+	SDL_UnlockTexture(cached.texture);
+}
+
+static void
+releaseCapture (FrameCapture &capture)
+{
+	for (SDL_Texture *target : capture.targets) {
+		if (target != nullptr) { SDL_DestroyTexture(target); }
+	}
+	if (capture.back_buffer != nullptr) { SDL_DestroyTexture(capture.back_buffer); }
+	capture = {};
+}
+
+// SDL falls back to generic conversion code on every upload when the
+// renderer can't use a format directly. If there's a faster conversion to
+// one of the formats the renderer does support, the texture is created in
+// that one instead and the frames are converted with it.
+static unsigned int
+getTextureFormat (SDL_Renderer *renderer, unsigned int format)
+{
+	SDL_RendererInfo info;
+	if (SDL_GetRendererInfo(renderer, &info) < 0) {
+		SDL_ClearError();
+		return format;
+	}
+
+	for (Uint32 i = 0; i < info.num_texture_formats; i++) {
+		if (info.texture_formats[i] == format) { return format; }
+	}
+
+	for (Uint32 i = 0; i < info.num_texture_formats; i++) {
+		if (pixels::canConvert(format, info.texture_formats[i])) { return info.texture_formats[i]; }
+	}
+
+	return format;
+}
+
+static SDL_Texture *
+getTexture (
+	Napi::Env &env,
+	WindowState *state,
+	int width,
+	int height,
+	unsigned int format,
+	bool *is_new = nullptr,
+	bool can_convert = false
+) {
+	SDL_Renderer *renderer = getRenderer(env, state);
+	CachedTexture &cached = state->cached;
+	SDL_Texture *texture = cached.texture;
+
+	if (is_new != nullptr) { *is_new = false; }
+
+	unsigned int texture_format = can_convert ? getTextureFormat(renderer, format) : format;
+
+	if (texture != nullptr
+		&& cached.width == width
+		&& cached.height == height
+		&& cached.format == format
+		&& cached.texture_format == texture_format
+	) {
+		return texture;
+	}
+
+	if (texture != nullptr) {
+		unlockTexture(cached);
+		SDL_DestroyTexture(texture);
+		cached.texture = nullptr;
+	}
+
+	texture = SDL_CreateTexture(renderer, texture_format, SDL_TEXTUREACCESS_STREAMING, width, height);
+	if (texture == nullptr) {
+		std::ostringstream message;
+		message << "SDL_CreateTexture(" << width << ", " << height << ", " << texture_format << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	if (SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE) < 0) {
+		SDL_DestroyTexture(texture);
+		std::ostringstream message;
+		message << "SDL_SetTextureBlendMode(" << state->id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	cached.texture = texture;
+	cached.width = width;
+	cached.height = height;
+	cached.format = format;
+	cached.texture_format = texture_format;
+
+	if (is_new != nullptr) { *is_new = true; }
+
+	return texture;
+}
+
+// Size of the memory SDL_LockTexture hands out. Planar YUV formats store
+// their chroma right after the luma plane, at half the pitch and height
+// (two such planes for YV12/IYUV, one interleaved plane for NV12/NV21).
+static size_t
+getLockedSize (unsigned int format, int pitch, int height)
+{
+	size_t luma = (size_t) pitch * height;
+	size_t chroma_height = (height + 1) / 2;
+	switch (format) {
+		case SDL_PIXELFORMAT_YV12:
+		case SDL_PIXELFORMAT_IYUV:
+		case SDL_PIXELFORMAT_NV12:
+		case SDL_PIXELFORMAT_NV21:
+			return luma + 2 * ((pitch + 1) / 2) * chroma_height;
+		default:
+			return luma;
+	}
+}
+
+static int
+getRenderDriverIndex (const std::string &name)
+{
+	int num_drivers = SDL_GetNumRenderDrivers();
+	for (int i = 0; i < num_drivers; i++) {
+		SDL_RendererInfo info;
+		if (SDL_GetRenderDriverInfo(i, &info) < 0) {
+			SDL_ClearError();
+			continue;
+		}
+		if (name == info.name) { return i; }
+	}
+	return -1;
+}
+
 void
 updateRenderer(
 	Napi::Env &env,
-	SDL_Window *window,
+	WindowState *state,
 	bool *is_accelerated,
 	bool *is_vsync
 ) {
-	int window_id = SDL_GetWindowID(window);
-	// Not likely to fail.
+	SDL_Window *window = state->window;
+	int window_id = state->id;
 
-	CachedTexture &cached = cachedTextures[window];
+	CachedTexture &cached = state->cached;
 	if (cached.texture != nullptr) {
+		unlockTexture(cached);
 		SDL_DestroyTexture(cached.texture);
 		cached.texture = nullptr;
 	}
 
-	SDL_Renderer *old_renderer = SDL_GetRenderer(window);
-	if (old_renderer != nullptr) {
-		SDL_DestroyRenderer(old_renderer);
+	releaseCapture(state->capture);
+	texture::destroyAll(window);
+
+	if (state->renderer != nullptr) {
+		SDL_DestroyRenderer(state->renderer);
+		state->renderer = nullptr;
 	}
 
+	// SDL turns batching off when a driver is picked explicitly, unless told
+	// otherwise. The hint is read when the renderer is created.
+	SDL_SetHint(SDL_HINT_RENDER_BATCHING, state->is_render_batching ? "1" : "0");
+
 	SDL_Renderer *renderer;
 	for (int i = 0; i < 4; i++) {
 		int renderer_flags = 0
 			| (*is_accelerated ? SDL_RENDERER_ACCELERATED : SDL_RENDERER_SOFTWARE)
 			| (*is_vsync ? SDL_RENDERER_PRESENTVSYNC : 0);
 
-		renderer = SDL_CreateRenderer(window, -1, renderer_flags);
+		renderer = SDL_CreateRenderer(window, state->render_driver, renderer_flags);
 		if (renderer != nullptr) {
 			SDL_ClearError();
 			break;
@@ -92,10 +347,42 @@ updateRenderer(
 		throw Napi::Error::New(env, message.str());
 	}
 
+	state->renderer = renderer;
 	*is_accelerated = info.flags & SDL_RENDERER_ACCELERATED;
 	*is_vsync = info.flags & SDL_RENDERER_PRESENTVSYNC;
 }
 
+// Tells JS which formats and sizes the renderer takes as they are, so
+// frames can be produced that way. SDL lists its preferred format first.
+static Napi::Value
+getRendererInfo (Napi::Env &env, WindowState *state)
+{
+	if (state->renderer == nullptr) { return env.Null(); }
+
+	SDL_RendererInfo info;
+	if (SDL_GetRendererInfo(state->renderer, &info) < 0) {
+		std::ostringstream message;
+		message << "SDL_GetRendererInfo(" << state->id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	Napi::Array texture_formats = Napi::Array::New(env);
+	for (Uint32 i = 0; i < info.num_texture_formats; i++) {
+		auto it = video::formats.find((SDL_PixelFormatEnum) info.texture_formats[i]);
+		if (it == video::formats.end()) { continue; }
+		texture_formats.Set(texture_formats.Length(), it->second);
+	}
+
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("name", info.name);
+	result.Set("textureFormats", texture_formats);
+	result.Set("preferredFormat", texture_formats.Length() > 0 ? texture_formats.Get(0u) : env.Null());
+	result.Set("maxTextureWidth", info.max_texture_width);
+	result.Set("maxTextureHeight", info.max_texture_height);
+	return result;
+}
+
 
 Napi::Value
 window::create (const Napi::CallbackInfo &info)
@@ -121,6 +408,19 @@ window::create (const Napi::CallbackInfo &info)
 	bool is_popup_menu = info[16].As<Napi::Boolean>().Value();
 	bool is_tooltip = info[17].As<Napi::Boolean>().Value();
 	bool is_utility = info[18].As<Napi::Boolean>().Value();
+	Napi::Value render_driver_name = info[19];
+	bool is_render_batching = info[20].As<Napi::Boolean>().Value();
+
+	int render_driver = -1;
+	if (!render_driver_name.IsNull()) {
+		std::string name = render_driver_name.As<Napi::String>().Utf8Value();
+		render_driver = getRenderDriverIndex(name);
+		if (render_driver < 0) {
+			std::ostringstream message;
+			message << "window_create(" << name << ") error: unknown render driver";
+			throw Napi::Error::New(env, message.str());
+		}
+	}
 
 	int desired_flags = 0
 		| SDL_WINDOW_HIDDEN | SDL_WINDOW_ALLOW_HIGHDPI
@@ -175,6 +475,16 @@ window::create (const Napi::CallbackInfo &info)
 		throw Napi::Error::New(env, message.str());
 	}
 
+	WindowState *state = new WindowState();
+	state->id = window_id;
+	state->window = window;
+	state->renderer = nullptr;
+	state->render_driver = render_driver;
+	state->is_render_batching = is_render_batching;
+	Napi::External<WindowState> handle = Napi::External<WindowState>::New(env, state, [] (Napi::Env, WindowState *state) {
+		delete state;
+	});
+
 	Napi::Object native = Napi::Object::New(env);
 
 	bool has_wm_info;
@@ -187,6 +497,10 @@ window::create (const Napi::CallbackInfo &info)
 		SDL_ClearError();
 	}
 
+	#if defined(__LINUX__)
+		if (has_wm_info) { events::watchConnection(env, sys_wm_info); }
+	#endif
+
 	Napi::Value native_handle;
 	if (has_wm_info) {
 		NativeWindowHandle _native_handle;
@@ -243,14 +557,14 @@ window::create (const Napi::CallbackInfo &info)
 		native.Set("gpu", Napi::Buffer<GPU_NativeData>::Copy(env, &native_gpu, 1));
 	}
 	else {
-		cachedTextures[window] = {};
-		updateRenderer(env, window, &is_accelerated, &is_vsync);
+		updateRenderer(env, state, &is_accelerated, &is_vsync);
 	}
 
 	if (is_visible) { SDL_ShowWindow(window); }
 
 	Napi::Object result = Napi::Object::New(env);
 	result.Set("id", window_id);
+	result.Set("handle", handle);
 	result.Set("x", x);
 	result.Set("y", y);
 	result.Set("width", width);
@@ -264,6 +578,7 @@ window::create (const Napi::CallbackInfo &info)
 	result.Set("alwaysOnTop", is_always_on_top);
 	result.Set("accelerated", is_accelerated);
 	result.Set("vsync", is_vsync);
+	result.Set("renderer", getRendererInfo(env, state));
 	result.Set("native", native);
 	result.Set("skipTaskbar", should_skip_taskbar);
 	result.Set("popupMenu", is_popup_menu);
@@ -278,16 +593,10 @@ window::setTitle (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
 	std:: string title = info[1].As<Napi::String>().Utf8Value();
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
-		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
-		throw Napi::Error::New(env, message.str());
-	}
+	SDL_Window *window = state->window;
 
 	SDL_SetWindowTitle(window, title.c_str());
 
@@ -299,18 +608,13 @@ window::setPosition (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
 	int x = info[1].As<Napi::Number>().Int32Value();
 	int y = info[2].As<Napi::Number>().Int32Value();
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
-		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
-		throw Napi::Error::New(env, message.str());
-	}
+	SDL_Window *window = state->window;
 
+	RendererLock lock;
 	SDL_SetWindowPosition(window, x, y);
 
 	return env.Undefined();
@@ -321,18 +625,13 @@ window::setSize (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
 	int width = info[1].As<Napi::Number>().Int32Value();
 	int height = info[2].As<Napi::Number>().Int32Value();
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
-		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
-		throw Napi::Error::New(env, message.str());
-	}
+	SDL_Window *window = state->window;
 
+	RendererLock lock;
 	SDL_SetWindowSize(window, width, height);
 
 	int pixel_width, pixel_height;
@@ -350,17 +649,13 @@ window::setFullscreen (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
+	int window_id = state->id;
 	int is_fullscreen = info[1].As<Napi::Boolean>().Value();
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
-		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
-		throw Napi::Error::New(env, message.str());
-	}
+	SDL_Window *window = state->window;
 
+	RendererLock lock;
 	if (SDL_SetWindowFullscreen(window, is_fullscreen ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0) < 0) {
 		std::ostringstream message;
 		message << "SDL_SetWindowFullscreen(" << window_id << ", " << is_fullscreen << ") error: " << SDL_GetError();
@@ -379,17 +674,12 @@ window::setResizable (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
 	bool is_resizable = info[1].As<Napi::Boolean>().Value();
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
-		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
-		throw Napi::Error::New(env, message.str());
-	}
+	SDL_Window *window = state->window;
 
+	RendererLock lock;
 	SDL_SetWindowResizable(window, is_resizable ? SDL_TRUE : SDL_FALSE);
 
 	int actual_flags = SDL_GetWindowFlags(window);
@@ -403,17 +693,12 @@ window::setBorderless (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
 	bool is_borderless = info[1].As<Napi::Boolean>().Value();
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
-		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
-		throw Napi::Error::New(env, message.str());
-	}
+	SDL_Window *window = state->window;
 
+	RendererLock lock;
 	SDL_SetWindowBordered(window, is_borderless ? SDL_FALSE : SDL_TRUE);
 
 	int actual_flags = SDL_GetWindowFlags(window);
@@ -427,42 +712,58 @@ window::setAcceleratedAndVsync (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
 	bool is_accelerated = info[1].As<Napi::Boolean>().Value();
 	bool is_vsync = info[2].As<Napi::Boolean>().Value();
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
-		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
-		throw Napi::Error::New(env, message.str());
-	}
-
-	updateRenderer(env, window, &is_accelerated, &is_vsync);
+	updateRenderer(env, state, &is_accelerated, &is_vsync);
 
 	Napi::Object result = Napi::Object::New(env);
 	result.Set("accelerated", is_accelerated);
 	result.Set("vsync", is_vsync);
+	result.Set("renderer", getRendererInfo(env, state));
 
 	return result;
 }
 
+// Changes vsync on the existing renderer, so its textures survive. Returns
+// null if the renderer can't do that, and it has to be recreated instead.
 Napi::Value
-window::focus (const Napi::CallbackInfo &info)
+window::setVsync (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
+	bool is_vsync = info[1].As<Napi::Boolean>().Value();
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
+	SDL_Renderer *renderer = getRenderer(env, state);
+
+	if (SDL_RenderSetVSync(renderer, is_vsync ? 1 : 0) < 0) {
+		SDL_ClearError();
+		return env.Null();
+	}
+
+	SDL_RendererInfo renderer_info;
+	if (SDL_GetRendererInfo(renderer, &renderer_info) < 0) {
 		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
+		message << "SDL_GetRendererInfo(" << state->id << ") error: " << SDL_GetError();
 		SDL_ClearError();
 		throw Napi::Error::New(env, message.str());
 	}
 
+	return Napi::Boolean::New(env, renderer_info.flags & SDL_RENDERER_PRESENTVSYNC);
+}
+
+Napi::Value
+window::focus (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = getState(env, info[0]);
+
+	SDL_Window *window = state->window;
+
+	RendererLock lock;
 	SDL_RaiseWindow(window);
 
 	return env.Undefined();
@@ -473,16 +774,11 @@ window::show (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
-		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
-		throw Napi::Error::New(env, message.str());
-	}
+	SDL_Window *window = state->window;
 
+	RendererLock lock;
 	SDL_ShowWindow(window);
 
 	return env.Undefined();
@@ -493,16 +789,11 @@ window::hide (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
-		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
-		throw Napi::Error::New(env, message.str());
-	}
+	SDL_Window *window = state->window;
 
+	RendererLock lock;
 	SDL_HideWindow(window);
 
 	return env.Undefined();
@@ -513,16 +804,11 @@ window::maximize (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
-		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
-		throw Napi::Error::New(env, message.str());
-	}
+	SDL_Window *window = state->window;
 
+	RendererLock lock;
 	SDL_MaximizeWindow(window);
 
 	return env.Undefined();
@@ -533,16 +819,11 @@ window::minimize (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
-		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
-		throw Napi::Error::New(env, message.str());
-	}
+	SDL_Window *window = state->window;
 
+	RendererLock lock;
 	SDL_MinimizeWindow(window);
 
 	return env.Undefined();
@@ -553,19 +834,254 @@ window::restore (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
+	SDL_Window *window = state->window;
+
+	RendererLock lock;
+	SDL_RestoreWindow(window);
+
+	return env.Undefined();
+}
+
+static void
+forgetPreviousFrame (CachedTexture &cached)
+{
+	std::vector<char>().swap(cached.previous);
+}
+
+// Like SDL_UpdateTexture, but converts the pixels on the way if the
+// texture was created in a different format than the frames.
+static void
+updateTexture (
+	SDL_Texture *texture,
+	CachedTexture &cached,
+	const SDL_Rect *rect,
+	const void *pixels,
+	int stride
+) {
+	if (cached.texture_format == cached.format) {
+		SDL_UpdateTexture(texture, rect, pixels, stride);
+		return;
+	}
+
+	void *locked;
+	int pitch;
+	if (SDL_LockTexture(texture, rect, &locked, &pitch) < 0) {
+		SDL_ClearError();
+		return;
+	}
+	int width = rect != nullptr ? rect->w : cached.width;
+	int height = rect != nullptr ? rect->h : cached.height;
+	pixels::convertRect(width, height, cached.format, pixels, stride, cached.texture_format, locked, pitch);
+	SDL_UnlockTexture(texture);
+}
+
+// Uploads the tiles of the image that differ from the previous frame and
+// returns how many there were. Consecutive changed tiles in a row of tiles
+// are uploaded together.
+static int
+uploadDamagedTiles (
+	SDL_Texture *texture,
+	CachedTexture &cached,
+	const char *pixels,
+	int stride,
+	bool is_new
+) {
+	int width = cached.width;
+	int height = cached.height;
+	int bytes_per_pixel = SDL_BYTESPERPIXEL(cached.format);
+	int row_size = width * bytes_per_pixel;
+	int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+	int tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+	std::vector<char> &previous = cached.previous;
+	size_t frame_size = (size_t) row_size * height;
+
+	if (is_new || previous.size() != frame_size) {
+		previous.resize(frame_size);
+		for (int y = 0; y < height; y++) {
+			memcpy(&previous[(size_t) y * row_size], pixels + (size_t) y * stride, row_size);
+		}
+		updateTexture(texture, cached, nullptr, pixels, stride);
+		return tiles_x * tiles_y;
+	}
+
+	int changed = 0;
+	for (int tile_y = 0; tile_y < tiles_y; tile_y++) {
+		int y_start = tile_y * TILE_SIZE;
+		int y_end = std::min(y_start + TILE_SIZE, height);
+
+		int run_start = -1;
+		for (int tile_x = 0; tile_x <= tiles_x; tile_x++) {
+			bool is_damaged = false;
+			if (tile_x < tiles_x) {
+				int offset = tile_x * TILE_SIZE * bytes_per_pixel;
+				int size = std::min(TILE_SIZE * bytes_per_pixel, row_size - offset);
+				for (int y = y_start; y < y_end; y++) {
+					const char *current_row = pixels + (size_t) y * stride + offset;
+					const char *previous_row = &previous[(size_t) y * row_size + offset];
+					if (memcmp(current_row, previous_row, size) != 0) {
+						is_damaged = true;
+						break;
+					}
+				}
+			}
+
+			if (is_damaged) {
+				changed += 1;
+				if (run_start == -1) { run_start = tile_x; }
+				continue;
+			}
+
+			if (run_start == -1) { continue; }
+
+			int x_start = run_start * TILE_SIZE;
+			int x_end = std::min(tile_x * TILE_SIZE, width);
+			int offset = x_start * bytes_per_pixel;
+			int size = (x_end - x_start) * bytes_per_pixel;
+
+			SDL_Rect rect = { x_start, y_start, x_end - x_start, y_end - y_start };
+			updateTexture(texture, cached, &rect, pixels + (size_t) y_start * stride + offset, stride);
+
+			for (int y = y_start; y < y_end; y++) {
+				memcpy(&previous[(size_t) y * row_size + offset], pixels + (size_t) y * stride + offset, size);
+			}
+
+			run_start = -1;
+		}
+	}
+
+	return changed;
+}
+
+static SDL_Rect *
+getRect (Napi::Value rectVal, SDL_Rect *rect)
+{
+	if (rectVal.IsNull()) { return nullptr; }
+
+	Napi::Object object = rectVal.As<Napi::Object>();
+	rect->x = object.Get("x").As<Napi::Number>().Int32Value();
+	rect->y = object.Get("y").As<Napi::Number>().Int32Value();
+	rect->w = object.Get("width").As<Napi::Number>().Int32Value();
+	rect->h = object.Get("height").As<Napi::Number>().Int32Value();
+	return rect;
+}
+
+// Draws the frame into the next capture target and hands it to the
+// recorder, if there is one.
+static void
+captureFrame (Napi::Env &env, WindowState *state, SDL_Texture *texture)
+{
+	SDL_Renderer *renderer = state->renderer;
+	FrameCapture &capture = state->capture;
+
+	int index = 1 - capture.latest;
+	if (false
+		|| SDL_SetRenderTarget(renderer, capture.targets[index]) < 0
+		|| SDL_RenderCopy(renderer, texture, nullptr, nullptr) < 0
+		|| SDL_SetRenderTarget(renderer, nullptr) < 0
+	) {
 		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
+		message << "capture(" << state->id << ") error: " << SDL_GetError();
 		SDL_ClearError();
+		SDL_SetRenderTarget(renderer, nullptr);
 		throw Napi::Error::New(env, message.str());
 	}
+	capture.latest = index;
+	capture.frames++;
 
-	SDL_RestoreWindow(window);
+	recorder::addFrame(state, renderer);
+}
 
-	return env.Undefined();
+// Frames built with draw() only exist in the back buffer, which can't be
+// drawn from. It is read back into a streaming texture instead, which
+// waits for the GPU to finish the frame.
+static void
+captureBackBuffer (Napi::Env &env, WindowState *state)
+{
+	SDL_Renderer *renderer = state->renderer;
+	FrameCapture &capture = state->capture;
+	std::ostringstream message;
+
+	int width, height;
+	if (SDL_GetRendererOutputSize(renderer, &width, &height) < 0) {
+		message << "SDL_GetRendererOutputSize(" << state->id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	if (capture.back_buffer == nullptr
+		|| capture.back_buffer_width != width
+		|| capture.back_buffer_height != height
+	) {
+		if (capture.back_buffer != nullptr) { SDL_DestroyTexture(capture.back_buffer); }
+
+		capture.back_buffer = SDL_CreateTexture(renderer, capture.format, SDL_TEXTUREACCESS_STREAMING, width, height);
+		if (capture.back_buffer == nullptr) {
+			message << "SDL_CreateTexture(" << width << ", " << height << ", " << capture.format << ") error: " << SDL_GetError();
+			SDL_ClearError();
+			throw Napi::Error::New(env, message.str());
+		}
+		SDL_SetTextureBlendMode(capture.back_buffer, SDL_BLENDMODE_NONE);
+
+		capture.back_buffer_width = width;
+		capture.back_buffer_height = height;
+	}
+
+	void *pixels;
+	int pitch;
+	if (SDL_LockTexture(capture.back_buffer, nullptr, &pixels, &pitch) < 0) {
+		message << "SDL_LockTexture(" << state->id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+	int result = SDL_RenderReadPixels(renderer, nullptr, capture.format, pixels, pitch);
+	SDL_UnlockTexture(capture.back_buffer);
+	if (result < 0) {
+		message << "SDL_RenderReadPixels(" << state->id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	captureFrame(env, state, capture.back_buffer);
+}
+
+static void
+presentTexture (
+	Napi::Env &env,
+	WindowState *state,
+	SDL_Texture *texture,
+	SDL_ScaleMode scaling,
+	const SDL_Rect *dst_rect
+) {
+	int window_id = state->id;
+	SDL_Renderer *renderer = state->renderer;
+
+	if(SDL_SetTextureScaleMode(texture, scaling) < 0) {
+		std::ostringstream message;
+		message << "SDL_SetTextureScaleMode(" << window_id << ", " << scaling << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	if (state->capture.targets[0] != nullptr) { captureFrame(env, state, texture); }
+
+	if (SDL_RenderClear(renderer) < 0) {
+		std::ostringstream message;
+		message << "SDL_RenderClear(" << window_id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	if (SDL_RenderCopy(renderer, texture, nullptr, dst_rect) < 0) {
+		std::ostringstream message;
+		message << "SDL_RenderCopy(" << window_id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
+
+	window::presentRenderer(state, renderer);
 }
 
 Napi::Value
@@ -573,95 +1089,260 @@ window::render (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
+	int window_id = state->id;
 	int width = info[1].As<Napi::Number>().Int32Value();
 	int height = info[2].As<Napi::Number>().Int32Value();
 	int stride = info[3].As<Napi::Number>().Int32Value();
 	unsigned int format = info[4].As<Napi::Number>().Int32Value();
 	void *pixels = info[5].As<Napi::Buffer<char>>().Data();
 	SDL_ScaleMode scaling = static_cast<SDL_ScaleMode>(info[6].As<Napi::Number>().Int32Value());
-	Napi::Value dstRectVal = info[7];
-	bool hasDstRect = !dstRectVal.IsNull();
 	SDL_Rect rect;
-	if (hasDstRect) {
-		Napi::Object dstRect = dstRectVal.As<Napi::Object>();
-		rect.x = dstRect.Get("x").As<Napi::Number>().Int32Value();
-		rect.y = dstRect.Get("y").As<Napi::Number>().Int32Value();
-		rect.w = dstRect.Get("width").As<Napi::Number>().Int32Value();
-		rect.h = dstRect.Get("height").As<Napi::Number>().Int32Value();
+	SDL_Rect *dst_rect = getRect(info[7], &rect);
+	Napi::Value dirtyRectsVal = info[8];
+	bool has_dirty_rects = !dirtyRectsVal.IsNull();
+	bool detect_damage = info[9].As<Napi::Boolean>().Value();
+
+	CachedTexture &cached = state->cached;
+	if (cached.locked != nullptr) {
+		std::ostringstream message;
+		message << "window_render(" << window_id << ") error: texture is locked";
+		throw Napi::Error::New(env, message.str());
 	}
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
+	bool is_new;
+	SDL_Texture *texture = getTexture(env, state, width, height, format, &is_new, true);
+
+	// A texture that was just created has no contents yet, and YUV data
+	// can't be addressed by a single offset, so those always get the full
+	// upload. Otherwise only the damaged parts of the image are copied over
+	// what the texture already holds from the previous frame.
+	Uint64 upload_start = SDL_GetPerformanceCounter();
+	Napi::Value result = env.Undefined();
+	if (detect_damage && !SDL_ISPIXELFORMAT_FOURCC(format)) {
+		int changed = uploadDamagedTiles(texture, cached, static_cast<char *>(pixels), stride, is_new);
+
+		Napi::Object damage = Napi::Object::New(env);
+		damage.Set("tileSize", TILE_SIZE);
+		damage.Set("tiles", ((width + TILE_SIZE - 1) / TILE_SIZE) * ((height + TILE_SIZE - 1) / TILE_SIZE));
+		damage.Set("changedTiles", changed);
+		result = damage;
+	}
+	else if (is_new || !has_dirty_rects || SDL_ISPIXELFORMAT_FOURCC(format)) {
+		forgetPreviousFrame(cached);
+		updateTexture(texture, cached, nullptr, pixels, stride);
+	}
+	else {
+		forgetPreviousFrame(cached);
+
+		Napi::Array dirtyRects = dirtyRectsVal.As<Napi::Array>();
+		int bytes_per_pixel = SDL_BYTESPERPIXEL(format);
+		int num_rects = dirtyRects.Length();
+		for (int i = 0; i < num_rects; i++) {
+			SDL_Rect dirty_rect;
+			getRect(dirtyRects.Get(i), &dirty_rect);
+
+			char *offset = static_cast<char *>(pixels)
+				+ dirty_rect.y * stride
+				+ dirty_rect.x * bytes_per_pixel;
+			updateTexture(texture, cached, &dirty_rect, offset, stride);
+		}
+	}
+	window::addUploadTime(state, upload_start);
+
+	presentTexture(env, state, texture, scaling, dst_rect);
+
+	return result;
+}
+
+Napi::Value
+window::renderYUV (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = getState(env, info[0]);
+	int window_id = state->id;
+	int width = info[1].As<Napi::Number>().Int32Value();
+	int height = info[2].As<Napi::Number>().Int32Value();
+	Uint8 *y_plane = info[3].As<Napi::Buffer<Uint8>>().Data();
+	int y_stride = info[4].As<Napi::Number>().Int32Value();
+	Uint8 *u_plane = info[5].As<Napi::Buffer<Uint8>>().Data();
+	int u_stride = info[6].As<Napi::Number>().Int32Value();
+	Uint8 *v_plane = info[7].As<Napi::Buffer<Uint8>>().Data();
+	int v_stride = info[8].As<Napi::Number>().Int32Value();
+	SDL_YUV_CONVERSION_MODE mode = static_cast<SDL_YUV_CONVERSION_MODE>(info[9].As<Napi::Number>().Int32Value());
+	SDL_ScaleMode scaling = static_cast<SDL_ScaleMode>(info[10].As<Napi::Number>().Int32Value());
+	SDL_Rect rect;
+	SDL_Rect *dst_rect = getRect(info[11], &rect);
+
+	CachedTexture &cached = state->cached;
+	if (cached.locked != nullptr) {
 		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
+		message << "window_renderYUV(" << window_id << ") error: texture is locked";
 		throw Napi::Error::New(env, message.str());
 	}
 
-	SDL_Renderer *renderer = SDL_GetRenderer(window);
-	if (renderer == nullptr) {
+	SDL_Texture *texture = getTexture(env, state, width, height, SDL_PIXELFORMAT_IYUV);
+	forgetPreviousFrame(cached);
+
+	// The conversion mode is global, so it has to be set for every frame.
+	// Renderers without native YUV support convert to RGB right away in the
+	// update call, the others look the mode up when the texture gets drawn.
+	SDL_SetYUVConversionMode(mode);
+
+	Uint64 upload_start = SDL_GetPerformanceCounter();
+	if (SDL_UpdateYUVTexture(texture, nullptr, y_plane, y_stride, u_plane, u_stride, v_plane, v_stride) < 0) {
 		std::ostringstream message;
-		message << "SDL_GetRenderer(" << window_id << ") error: " << SDL_GetError();
+		message << "SDL_UpdateYUVTexture(" << window_id << ") error: " << SDL_GetError();
 		SDL_ClearError();
 		throw Napi::Error::New(env, message.str());
 	}
 
-	CachedTexture &cached = cachedTextures[window];
-	SDL_Texture *texture = cached.texture;
+	window::addUploadTime(state, upload_start);
 
-	if (texture == nullptr
-		|| cached.width != width
-		|| cached.height != height
-		|| cached.format != format
-	) {
-		if (texture != nullptr) { SDL_DestroyTexture(texture); }
+	presentTexture(env, state, texture, scaling, dst_rect);
 
-		texture = SDL_CreateTexture(renderer, format, SDL_TEXTUREACCESS_STREAMING, width, height);
-		if (texture == nullptr) {
-			std::ostringstream message;
-			message << "SDL_CreateTexture(" << width << ", " << height << ", " << format << ") error: " << SDL_GetError();
-			SDL_ClearError();
-			throw Napi::Error::New(env, message.str());
-		}
+	return env.Undefined();
+}
 
-		if (SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE) < 0) {
-			std::ostringstream message;
-			message << "SDL_SetTextureBlendMode(" << window_id << ") error: " << SDL_GetError();
-			SDL_ClearError();
-			throw Napi::Error::New(env, message.str());
-		}
+Napi::Value
+window::renderNV (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = getState(env, info[0]);
+	int window_id = state->id;
+	int width = info[1].As<Napi::Number>().Int32Value();
+	int height = info[2].As<Napi::Number>().Int32Value();
+	unsigned int format = info[3].As<Napi::Number>().Int32Value();
+	Uint8 *y_plane = info[4].As<Napi::Buffer<Uint8>>().Data();
+	int y_stride = info[5].As<Napi::Number>().Int32Value();
+	Uint8 *uv_plane = info[6].As<Napi::Buffer<Uint8>>().Data();
+	int uv_stride = info[7].As<Napi::Number>().Int32Value();
+	SDL_YUV_CONVERSION_MODE mode = static_cast<SDL_YUV_CONVERSION_MODE>(info[8].As<Napi::Number>().Int32Value());
+	SDL_ScaleMode scaling = static_cast<SDL_ScaleMode>(info[9].As<Napi::Number>().Int32Value());
+	SDL_Rect rect;
+	SDL_Rect *dst_rect = getRect(info[10], &rect);
 
-		cached.texture = texture;
-		cached.width = width;
-		cached.height = height;
-		cached.format = format;
+	CachedTexture &cached = state->cached;
+	if (cached.locked != nullptr) {
+		std::ostringstream message;
+		message << "window_renderNV(" << window_id << ") error: texture is locked";
+		throw Napi::Error::New(env, message.str());
 	}
 
-	if(SDL_SetTextureScaleMode(texture, scaling) < 0) {
+	SDL_Texture *texture = getTexture(env, state, width, height, format);
+	forgetPreviousFrame(cached);
+
+	SDL_SetYUVConversionMode(mode);
+
+	Uint64 upload_start = SDL_GetPerformanceCounter();
+	if (SDL_UpdateNVTexture(texture, nullptr, y_plane, y_stride, uv_plane, uv_stride) < 0) {
 		std::ostringstream message;
-		message << "SDL_SetTextureScaleMode(" << window_id << ", " << scaling << ") error: " << SDL_GetError();
+		message << "SDL_UpdateNVTexture(" << window_id << ") error: " << SDL_GetError();
 		SDL_ClearError();
 		throw Napi::Error::New(env, message.str());
 	}
+	window::addUploadTime(state, upload_start);
 
-	SDL_UpdateTexture(texture, nullptr, pixels, stride);
+	presentTexture(env, state, texture, scaling, dst_rect);
 
-	if (SDL_RenderClear(renderer) < 0) {
+	return env.Undefined();
+}
+
+Napi::Value
+window::lockTexture (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = getState(env, info[0]);
+	int window_id = state->id;
+	int width = info[1].As<Napi::Number>().Int32Value();
+	int height = info[2].As<Napi::Number>().Int32Value();
+	unsigned int format = info[3].As<Napi::Number>().Int32Value();
+
+	CachedTexture &cached = state->cached;
+	if (cached.locked != nullptr) {
 		std::ostringstream message;
-		message << "SDL_RenderClear(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
+		message << "window_lockTexture(" << window_id << ") error: texture is already locked";
 		throw Napi::Error::New(env, message.str());
 	}
 
-	if (SDL_RenderCopy(renderer, texture, nullptr, hasDstRect ? &rect : nullptr) < 0) {
+	SDL_Texture *texture = getTexture(env, state, width, height, format);
+	forgetPreviousFrame(cached);
+
+	// The frame gets drawn into the locked pixels from here on
+	window::beginFrame(state, SDL_GetPerformanceCounter());
+
+	void *pixels;
+	int pitch;
+	if (SDL_LockTexture(texture, nullptr, &pixels, &pitch) < 0) {
 		std::ostringstream message;
-		message << "SDL_RenderCopy(" << window_id << ") error: " << SDL_GetError();
+		message << "SDL_LockTexture(" << window_id << ") error: " << SDL_GetError();
 		SDL_ClearError();
 		throw Napi::Error::New(env, message.str());
 	}
 
-	SDL_RenderPresent(renderer);
+	// The memory belongs to SDL, so there is nothing to free when the
+	// ArrayBuffer gets collected. It gets detached on unlock instead.
+	Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, pixels, getLockedSize(format, pitch, height));
+	cached.locked = new Napi::Reference<Napi::ArrayBuffer>(Napi::Reference<Napi::ArrayBuffer>::New(buffer, 1));
+
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("pixels", buffer);
+	result.Set("stride", pitch);
+	return result;
+}
+
+Napi::Value
+window::present (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = getState(env, info[0]);
+	SDL_ScaleMode scaling = static_cast<SDL_ScaleMode>(info[1].As<Napi::Number>().Int32Value());
+	SDL_Rect rect;
+	SDL_Rect *dst_rect = getRect(info[2], &rect);
+
+	SDL_Renderer *renderer = getRenderer(env, state);
+
+	// Without locked pixels, whatever was drawn since the last present
+	// is already in the back buffer.
+	CachedTexture &cached = state->cached;
+	if (cached.locked == nullptr) {
+		if (state->capture.targets[0] != nullptr) { captureBackBuffer(env, state); }
+		window::presentRenderer(state, renderer);
+		return env.Undefined();
+	}
+
+	// With accelerated renderers this is where the pixels get uploaded
+	Uint64 upload_start = SDL_GetPerformanceCounter();
+	unlockTexture(cached);
+	window::addUploadTime(state, upload_start);
+
+	presentTexture(env, state, cached.texture, scaling, dst_rect);
+
+	return env.Undefined();
+}
+
+Napi::Value
+window::clear (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = getState(env, info[0]);
+	int window_id = state->id;
+
+	SDL_Renderer *renderer = getRenderer(env, state);
+
+	window::beginFrame(state, SDL_GetPerformanceCounter());
+
+	if (SDL_RenderClear(renderer) < 0) {
+		std::ostringstream message;
+		message << "SDL_RenderClear(" << window_id << ") error: " << SDL_GetError();
+		SDL_ClearError();
+		throw Napi::Error::New(env, message.str());
+	}
 
 	return env.Undefined();
 }
@@ -671,20 +1352,15 @@ window::setIcon (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
+	int window_id = state->id;
 	int w = info[1].As<Napi::Number>().Int32Value();
 	int h = info[2].As<Napi::Number>().Int32Value();
 	int stride = info[3].As<Napi::Number>().Int32Value();
 	unsigned int format = info[4].As<Napi::Number>().Int32Value();
 	void *pixels = info[5].As<Napi::Buffer<char>>().Data();
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
-		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
-		throw Napi::Error::New(env, message.str());
-	}
+	SDL_Window *window = state->window;
 
 	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(pixels, w, h, SDL_BITSPERPIXEL(format), stride, format);
 	if (surface == nullptr) {
@@ -706,16 +1382,11 @@ window::flash (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
+	int window_id = state->id;
 	int type = info[1].As<Napi::Number>().Int32Value();
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
-		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
-		SDL_ClearError();
-		throw Napi::Error::New(env, message.str());
-	}
+	SDL_Window *window = state->window;
 
 	SDL_FlashOperation op;
 	switch (type) {
@@ -735,30 +1406,168 @@ window::flash (const Napi::CallbackInfo &info)
 }
 
 Napi::Value
-window::destroy (const Napi::CallbackInfo &info)
+window::getFrameStats (const Napi::CallbackInfo &info)
 {
 	Napi::Env env = info.Env();
 
-	int window_id = info[0].As<Napi::Number>().Int32Value();
+	WindowState *state = getState(env, info[0]);
 
-	SDL_Window *window = SDL_GetWindowFromID(window_id);
-	if (window == nullptr) {
+	// Copy under the lock and build the result after releasing it, so the
+	// render thread isn't kept waiting on allocations.
+	FrameStats &stats = state->frame_stats;
+	SDL_AtomicLock(&stats.lock);
+	Uint64 frames = stats.frames;
+	Uint64 missed_vblanks = stats.missed_vblanks;
+	int refresh_rate = stats.refresh_rate;
+	Histogram upload = stats.upload;
+	Histogram present = stats.present;
+	Histogram interval = stats.interval;
+	SDL_AtomicUnlock(&stats.lock);
+
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("frames", (double) frames);
+	result.Set("missedVblanks", (double) missed_vblanks);
+	result.Set("refreshRate", refresh_rate > 0 ? Napi::Number::New(env, refresh_rate) : env.Null());
+	result.Set("upload", histogram::getStats(env, upload));
+	result.Set("present", histogram::getStats(env, present));
+	result.Set("interval", histogram::getStats(env, interval));
+	return result;
+}
+
+Napi::Value
+window::resetFrameStats (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = getState(env, info[0]);
+
+	FrameStats &stats = state->frame_stats;
+	SDL_AtomicLock(&stats.lock);
+	stats.frames = 0;
+	stats.missed_vblanks = 0;
+	stats.last_present = 0;
+	stats.frame_start = 0;
+	stats.upload = {};
+	stats.present = {};
+	stats.interval = {};
+	SDL_AtomicUnlock(&stats.lock);
+
+	return env.Undefined();
+}
+
+Napi::Value
+window::setFrameCapture (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = getState(env, info[0]);
+	int window_id = state->id;
+	bool is_enabled = info[1].As<Napi::Boolean>().Value();
+	int width = info[2].As<Napi::Number>().Int32Value();
+	int height = info[3].As<Napi::Number>().Int32Value();
+	unsigned int format = info[4].As<Napi::Number>().Int32Value();
+
+	SDL_Renderer *renderer = getRenderer(env, state);
+
+	FrameCapture &capture = state->capture;
+	releaseCapture(capture);
+	if (!is_enabled) { return env.Undefined(); }
+
+	if (!SDL_RenderTargetSupported(renderer)) {
 		std::ostringstream message;
-		message << "SDL_GetWindowFromID(" << window_id << ") error: " << SDL_GetError();
+		message << "window_setFrameCapture(" << window_id << ") error: renderer doesn't support render targets";
+		throw Napi::Error::New(env, message.str());
+	}
+
+	for (SDL_Texture *&target : capture.targets) {
+		target = SDL_CreateTexture(renderer, format, SDL_TEXTUREACCESS_TARGET, width, height);
+		if (target == nullptr) {
+			std::ostringstream message;
+			message << "SDL_CreateTexture(" << width << ", " << height << ", " << format << ") error: " << SDL_GetError();
+			SDL_ClearError();
+			releaseCapture(capture);
+			throw Napi::Error::New(env, message.str());
+		}
+	}
+
+	capture.width = width;
+	capture.height = height;
+	capture.format = format;
+
+	return env.Undefined();
+}
+
+Napi::Value
+window::readFrame (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = getState(env, info[0]);
+	int window_id = state->id;
+
+	SDL_Renderer *renderer = getRenderer(env, state);
+
+	FrameCapture &capture = state->capture;
+	if (capture.targets[0] == nullptr || capture.frames == 0) { return env.Null(); }
+
+	// Once there are two frames, read the older one. The newer one might
+	// still be in flight, and reading it would wait for it to finish.
+	int index = capture.frames >= 2 ? 1 - capture.latest : capture.latest;
+
+	int stride = capture.width * SDL_BYTESPERPIXEL(capture.format);
+	Napi::Buffer<char> pixels = Napi::Buffer<char>::New(env, (size_t) stride * capture.height);
+
+	SDL_Texture *current_target = SDL_GetRenderTarget(renderer);
+	if (false
+		|| SDL_SetRenderTarget(renderer, capture.targets[index]) < 0
+		|| SDL_RenderReadPixels(renderer, nullptr, capture.format, pixels.Data(), stride) < 0
+	) {
+		std::ostringstream message;
+		message << "SDL_RenderReadPixels(" << window_id << ") error: " << SDL_GetError();
 		SDL_ClearError();
+		SDL_SetRenderTarget(renderer, current_target);
 		throw Napi::Error::New(env, message.str());
 	}
+	SDL_SetRenderTarget(renderer, current_target);
+
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("buffer", pixels);
+	result.Set("stride", stride);
+	result.Set("width", capture.width);
+	result.Set("height", capture.height);
+	return result;
+}
+
+Napi::Value
+window::destroy (const Napi::CallbackInfo &info)
+{
+	Napi::Env env = info.Env();
+
+	WindowState *state = getState(env, info[0]);
+
+	SDL_Window *window = state->window;
+
+	// The render thread presents to the window until it is stopped
+	render_thread::release(state);
+
+	if (state->renderer != nullptr) {
+		CachedTexture &cached = state->cached;
+		if (cached.texture != nullptr) {
+			unlockTexture(cached);
+			SDL_DestroyTexture(cached.texture);
+		}
+		cached = {};
 
-	SDL_Renderer *renderer = SDL_GetRenderer(window);
-	if (renderer != nullptr) {
-		SDL_DestroyRenderer(renderer);
+		recorder::release(state);
+		releaseCapture(state->capture);
+		texture::destroyAll(window);
 
-		CachedTexture &cached = cachedTextures[window];
-		if (cached.texture != nullptr) { SDL_DestroyTexture(cached.texture); }
-		cachedTextures.erase(window);
+		SDL_DestroyRenderer(state->renderer);
+		state->renderer = nullptr;
 	}
 
 	SDL_DestroyWindow(window);
+	state->window = nullptr;
 
 	return env.Undefined();
 }
@@ -3,9 +3,95 @@
 
 #include <napi.h>
 #include <SDL.h>
+#include <vector>
+#include "histogram.h"
+
+struct CachedTexture {
+	SDL_Texture *texture;
+	int width;
+	int height;
+	// Format of the frames that are uploaded.
+	unsigned int format;
+	// Format the texture was created with. Differs from the above when the
+	// renderer doesn't support it and the frames are converted on upload.
+	unsigned int texture_format;
+	// Set while JS holds a Buffer over the locked texture memory.
+	Napi::Reference<Napi::ArrayBuffer> *locked;
+	// Copy of what was last uploaded, with rows packed tightly. Only kept
+	// while render is called with damage detection.
+	std::vector<char> previous;
+};
+
+// Timings of the frames presented to a window, in milliseconds. Frames are
+// presented from the render thread while asyncRender is on, so access is
+// guarded by the spinlock.
+struct FrameStats {
+	SDL_SpinLock lock = 0;
+	Uint64 frames = 0;
+	Uint64 missed_vblanks = 0;
+	// Performance counter value at the last present, 0 before the first.
+	Uint64 last_present = 0;
+	// Performance counter value when work on the next frame started, 0 if
+	// nothing was uploaded or drawn since the last present.
+	Uint64 frame_start = 0;
+	int refresh_rate = 0;
+	Histogram upload;
+	Histogram present;
+	Histogram interval;
+};
+
+// While capture is on, every frame that gets presented is also drawn into
+// one of two render targets, taking turns. Reading back the older one
+// doesn't wait for the GPU to finish the frame that was just submitted.
+// Frames drawn straight to the window are first read back from the back
+// buffer into a window-sized texture, which does wait.
+struct FrameCapture {
+	SDL_Texture *targets[2] = {};
+	SDL_Texture *back_buffer = nullptr;
+	int back_buffer_width = 0;
+	int back_buffer_height = 0;
+	int width = 0;
+	int height = 0;
+	unsigned int format = 0;
+	// Index of the target holding the most recent frame.
+	int latest = 1;
+	Uint64 frames = 0;
+};
+
+struct Recorder;
+struct RenderThread;
+
+// Everything the bindings need to know about a window. It is handed to JS
+// as an External when the window is created and passed back as the first
+// argument of every call, so there is no lookup by id. The SDL resources
+// are released in window::destroy, the struct itself when JS lets go of it.
+struct WindowState {
+	int id;
+	SDL_Window *window;
+	// Null for opengl and webgpu windows.
+	SDL_Renderer *renderer;
+	// Index of the render driver to use, or -1 to let SDL choose. Kept so
+	// the renderer is recreated with the same one.
+	int render_driver;
+	bool is_render_batching;
+	CachedTexture cached;
+	FrameStats frame_stats;
+	FrameCapture capture;
+	// Set while the frames are being written to a file, see recorder.cpp
+	Recorder *recorder;
+	// Set while asyncRender is on, see render-thread.cpp
+	RenderThread *render_thread;
+};
 
 namespace window {
 
+		WindowState *getState(Napi::Env &env, Napi::Value value);
+		SDL_Renderer *getRenderer(Napi::Env &env, WindowState *state);
+		void beginFrame(WindowState *state, Uint64 start);
+		void addUploadTime(WindowState *state, Uint64 start);
+		void presentRenderer(WindowState *state, SDL_Renderer *renderer);
+
+
 		Napi::Value create(const Napi::CallbackInfo &info);
 		Napi::Value setTitle(const Napi::CallbackInfo &info);
 		Napi::Value setPosition(const Napi::CallbackInfo &info);
@@ -14,6 +100,7 @@ namespace window {
 		Napi::Value setResizable(const Napi::CallbackInfo &info);
 		Napi::Value setBorderless(const Napi::CallbackInfo &info);
 		Napi::Value setAcceleratedAndVsync(const Napi::CallbackInfo &info);
+		Napi::Value setVsync(const Napi::CallbackInfo &info);
 		Napi::Value focus(const Napi::CallbackInfo &info);
 		Napi::Value show(const Napi::CallbackInfo &info);
 		Napi::Value hide(const Napi::CallbackInfo &info);
@@ -21,8 +108,17 @@ namespace window {
 		Napi::Value minimize(const Napi::CallbackInfo &info);
 		Napi::Value restore(const Napi::CallbackInfo &info);
 		Napi::Value render(const Napi::CallbackInfo &info);
+		Napi::Value renderYUV(const Napi::CallbackInfo &info);
+		Napi::Value renderNV(const Napi::CallbackInfo &info);
+		Napi::Value lockTexture(const Napi::CallbackInfo &info);
+		Napi::Value present(const Napi::CallbackInfo &info);
+		Napi::Value clear(const Napi::CallbackInfo &info);
 		Napi::Value setIcon(const Napi::CallbackInfo &info);
 		Napi::Value flash(const Napi::CallbackInfo &info);
+		Napi::Value getFrameStats(const Napi::CallbackInfo &info);
+		Napi::Value resetFrameStats(const Napi::CallbackInfo &info);
+		Napi::Value setFrameCapture(const Napi::CallbackInfo &info);
+		Napi::Value readFrame(const Napi::CallbackInfo &info);
 		Napi::Value destroy(const Napi::CallbackInfo &info);
 
 }; // namespace window
@@ -1,7 +1,10 @@
 
 export namespace Events {
 
-	interface BaseEvent { readonly type: string }
+	interface BaseEvent {
+		readonly type: string
+		readonly timestamp?: number
+	}
 
 	export type PreventCallback = () => void
 
@@ -66,7 +69,12 @@ export namespace Events {
 			readonly touch: boolean
 		}
 
-		export interface MouseMove extends MouseEvent { readonly type: 'mouseMove' }
+		export interface MouseMove extends MouseEvent {
+			readonly type: 'mouseMove'
+			readonly dx: number
+			readonly dy: number
+			readonly merged: number
+		}
 
 		interface MouseButtonEvent extends MouseEvent {
 			readonly button: number
@@ -82,8 +90,6 @@ export namespace Events {
 			readonly flipped: boolean
 		}
 
-		export interface MouseMove extends MouseEvent { readonly type: 'mouseMove' }
-
 		interface FingerEvent extends WindowEvent {
 			readonly device: Sdl.Touch.Device
 			readonly fingerId: number
@@ -100,6 +106,7 @@ export namespace Events {
 			readonly type: 'fingerMove'
 			readonly dx: number
 			readonly dy: number
+			readonly merged: number
 		}
 
 		export interface Show extends WindowEvent { readonly type: 'show' }
@@ -144,6 +151,7 @@ export namespace Events {
 			readonly file: string
 		}
 		export interface DropComplete extends WindowEvent { readonly type: 'dropComplete' }
+		export interface FramePresented extends WindowEvent { readonly type: 'framePresented' }
 
 		export type Any
 			= KeyDown
@@ -175,6 +183,7 @@ export namespace Events {
 			| DropText
 			| DropFile
 			| DropComplete
+			| FramePresented
 
 	}
 
@@ -197,6 +206,7 @@ export namespace Events {
 			readonly type: 'axisMotion'
 			readonly axis: number
 			readonly value: number
+			readonly merged: number
 		}
 
 		export interface BallMotion extends JoystickEvent {
@@ -260,6 +270,7 @@ export namespace Events {
 			readonly type: 'axisMotion'
 			readonly axis: Sdl.Controller.Axis
 			readonly value: number
+			readonly merged: number
 		}
 
 		interface ButtonEvent extends ControllerEvent {
@@ -387,6 +398,9 @@ export namespace Sdl {
 				readonly all: string[]
 				readonly current: string
 			}
+			readonly render: {
+				readonly all: string[]
+			}
 		}
 		readonly initialized: {
 			readonly video: boolean
@@ -449,6 +463,19 @@ export namespace Sdl {
 			| 'linear'
 			| 'best'
 
+		export type YUVConversion
+			= 'automatic'
+			| 'bt601'
+			| 'bt709'
+			| 'jpeg'
+
+		export type BlendMode
+			= 'none'
+			| 'blend'
+			| 'add'
+			| 'mod'
+			| 'mul'
+
 		export interface Display {
 			readonly name: string | null
 			readonly format: Format
@@ -473,6 +500,44 @@ export namespace Sdl {
 			readonly orientation: Orientation | null
 		}
 
+		export interface LatencyPercentiles {
+			readonly count: number
+			readonly p50: number | null
+			readonly p90: number | null
+			readonly p95: number | null
+			readonly p99: number | null
+			readonly max: number | null
+		}
+
+		export interface LatencyStats {
+			readonly pumpToDispatch: LatencyPercentiles
+			readonly dispatchToRender: LatencyPercentiles
+		}
+
+		export interface FrameStats {
+			readonly frames: number
+			readonly missedVblanks: number
+			readonly refreshRate: number | null
+			readonly upload: LatencyPercentiles
+			readonly present: LatencyPercentiles
+			readonly interval: LatencyPercentiles
+		}
+
+		export interface RendererInfo {
+			readonly name: string
+			readonly textureFormats: Format[]
+			readonly preferredFormat: Format | null
+			readonly maxTextureWidth: number
+			readonly maxTextureHeight: number
+		}
+
+		export interface CaptureStats {
+			readonly frames: number
+			readonly dropped: number
+			readonly queued: number
+			readonly bytes: number
+		}
+
 		export class Window {
 			on (event: 'show', listener: (event: Events.Window.Show) => void): this
 			on (event: 'hide', listener: (event: Events.Window.Hide) => void): this
@@ -503,6 +568,7 @@ export namespace Sdl {
 			on (event: 'dropText', listener: (event: Events.Window.DropText) => void): this
 			on (event: 'dropFile', listener: (event: Events.Window.DropFile) => void): this
 			on (event: 'dropComplete', listener: (event: Events.Window.DropComplete) => void): this
+			on (event: 'framePresented', listener: (event: Events.Window.FramePresented) => void): this
 			on (event: '*', listener: (type: string, event: Events.Window.Any) => void): this
 
 			readonly id: number
@@ -545,6 +611,8 @@ export namespace Sdl {
 			readonly vsync: boolean
 			setVsync (vsync: boolean): void
 
+			readonly renderer: RendererInfo | null
+
 			readonly opengl: boolean
 			readonly webgpu: boolean
 			readonly native: { handle: Buffer | null }
@@ -568,6 +636,80 @@ export namespace Sdl {
 			readonly utility: boolean
 
 			render (width: number, height: number, stride: number, format: Format, buffer: Buffer, options?: {
+				scaling?: Scaling,
+				dstRect?: {
+					x: number,
+					y: number,
+					width: number,
+					height: number,
+				},
+				dirtyRects?: Array<{
+					x: number,
+					y: number,
+					width: number,
+					height: number,
+				}>,
+				detectDamage?: boolean,
+			}): void | Promise<boolean>
+
+			renderYUV (
+				width: number,
+				height: number,
+				yBuffer: Buffer,
+				yStride: number,
+				uBuffer: Buffer,
+				uStride: number,
+				vBuffer: Buffer,
+				vStride: number,
+				options?: {
+					scaling?: Scaling,
+					dstRect?: {
+						x: number,
+						y: number,
+						width: number,
+						height: number,
+					},
+					conversion?: YUVConversion,
+				},
+			): void
+
+			renderNV (
+				width: number,
+				height: number,
+				yBuffer: Buffer,
+				yStride: number,
+				uvBuffer: Buffer,
+				uvStride: number,
+				options?: {
+					format?: 'nv12' | 'nv21',
+					scaling?: Scaling,
+					dstRect?: {
+						x: number,
+						y: number,
+						width: number,
+						height: number,
+					},
+					conversion?: YUVConversion,
+				},
+			): void
+
+			readonly damage: {
+				tileSize: number,
+				tiles: number,
+				changedTiles: number,
+			} | null
+
+			readonly asyncRender: boolean
+			setAsyncRender (asyncRender: boolean, options?: {
+				queueDepth?: number,
+				dropOldest?: boolean,
+			}): void
+
+			lockPixels (width: number, height: number, format: Format): {
+				buffer: Buffer,
+				stride: number,
+			}
+			present (options?: {
 				scaling?: Scaling,
 				dstRect?: {
 					x: number,
@@ -577,16 +719,112 @@ export namespace Sdl {
 				}
 			}): void
 
+			createTexture (width: number, height: number, format: Format): Texture
+			createRenderTarget (width: number, height: number, format?: Format): Texture
+			readonly renderTarget: Texture | null
+			setRenderTarget (target: Texture | null): void
+			readonly frameCapture: boolean
+			setFrameCapture (frameCapture: boolean, options?: {
+				width?: number,
+				height?: number,
+				format?: Format,
+			}): void
+			readPixels (): {
+				width: number,
+				height: number,
+				stride: number,
+				format: Format,
+				buffer: Buffer,
+			} | null
+			readonly capturing: boolean
+			readonly captureStats: CaptureStats | null
+			startCapture (target: string | number, options?: {
+				format?: 'y4m' | 'rgb',
+				fps?: number,
+				width?: number,
+				height?: number,
+				queueDepth?: number,
+			}): void
+			stopCapture (): CaptureStats
+			clear (): void
+			draw (texture: Texture, options?: {
+				srcRect?: {
+					x: number,
+					y: number,
+					width: number,
+					height: number,
+				},
+				dstRect?: {
+					x: number,
+					y: number,
+					width: number,
+					height: number,
+				},
+				scaling?: Scaling,
+				blend?: BlendMode,
+				alpha?: number,
+				angle?: number,
+				flipX?: boolean,
+				flipY?: boolean,
+			}): void
+			drawGeometry (texture: Texture | null, vertices: Float32Array, indices?: Uint8Array | Uint16Array | Uint32Array | null, options?: {
+				scaling?: Scaling,
+				blend?: BlendMode,
+			}): void
+
 			setIcon (width: number, height: number, stride: number, format: Format, buffer: Buffer): void
 
 			flash (untilFocused?: boolean): void
 			stopFlashing (): void
 
+			readonly coalesceMotion: boolean
+			setCoalesceMotion (coalesceMotion: boolean): void
+
+			readonly latencyTracking: boolean
+			setLatencyTracking (latencyTracking: boolean): void
+			readonly latency: LatencyStats | null
+			resetLatency (): void
+
+			readonly frameStats: FrameStats | null
+			resetFrameStats (): void
+
 			readonly destroyed: boolean
 			destroy (): void
 			destroyGently (): void
 		}
 
+		export class Texture {
+			readonly id: number
+			readonly window: Window
+			readonly width: number
+			readonly height: number
+			readonly format: Format
+			readonly target: boolean
+
+			update (buffer: Buffer, stride: number, rect?: {
+				x: number,
+				y: number,
+				width: number,
+				height: number,
+			}): void
+
+			readPixels (rect?: {
+				x: number,
+				y: number,
+				width: number,
+				height: number,
+			}): {
+				width: number,
+				height: number,
+				stride: number,
+				format: Format,
+				buffer: Buffer,
+			}
+
+			readonly destroyed: boolean
+			destroy (): void
+		}
+
 		interface Module {
 			on (event: 'displayAdd', listener: (event: Events.Display.Add) => void): this
 			on (event: 'displayRemove', listener: (event: Events.Display.Remove) => void): this
@@ -616,10 +854,13 @@ export namespace Sdl {
 				vsync?: boolean
 				opengl?: boolean
 				webgpu?: boolean
+				renderDriver?: string | null
+				renderBatching?: boolean
 				skipTaskbar?: boolean
 				popupMenu?: boolean
 				tooltip?: boolean
 				utility?: boolean
+				coalesceMotion?: boolean
 			}): Window
 		}
 	}
@@ -1039,6 +1280,9 @@ export namespace Sdl {
 			rumbleTriggers (leftRumble: number, rightRumble: number, duration: number): void
 			stopRumbleTriggers (): void
 
+			readonly coalesceAxisMotion: boolean
+			setCoalesceAxisMotion (coalesceAxisMotion: boolean): void
+
 			readonly closed: boolean
 			close (): void
 		}
@@ -1177,6 +1421,9 @@ export namespace Sdl {
 			rumbleTriggers (leftRumble: number, rightRumble: number, duration: number): void
 			stopRumbleTriggers (): void
 
+			readonly coalesceAxisMotion: boolean
+			setCoalesceAxisMotion (coalesceAxisMotion: boolean): void
+
 			readonly closed: boolean
 			close (): void
 		}
@@ -1374,6 +1621,111 @@ export namespace Sdl {
 
 	}
 
+	export namespace Pixels {
+
+		export interface Image {
+			width: number
+			height: number
+			stride: number
+			format: Video.Format
+			buffer: Buffer
+		}
+
+		export interface Rect {
+			x: number
+			y: number
+			width: number
+			height: number
+		}
+
+		export interface Color {
+			r: number
+			g: number
+			b: number
+			a?: number
+		}
+
+		interface Module {
+			convert (width: number, height: number, stride: number, format: Video.Format, buffer: Buffer, dstFormat: Video.Format, options?: {
+				stride?: number,
+				buffer?: Buffer,
+			}): Image
+			scale (width: number, height: number, stride: number, format: Video.Format, buffer: Buffer, dstWidth: number, dstHeight: number, options?: {
+				scaling?: 'nearest' | 'linear',
+				stride?: number,
+				buffer?: Buffer,
+			}): Image
+
+			blit (dst: Image, src: Image, options?: {
+				x?: number,
+				y?: number,
+				srcRect?: Rect | null,
+				async?: false,
+			}): void
+			blit (dst: Image, src: Image, options: {
+				x?: number,
+				y?: number,
+				srcRect?: Rect | null,
+				async: true,
+			}): Promise<void>
+
+			blend (dst: Image, src: Image, options?: {
+				x?: number,
+				y?: number,
+				srcRect?: Rect | null,
+				alpha?: 'straight' | 'premultiplied',
+				opacity?: number,
+				async?: false,
+			}): void
+			blend (dst: Image, src: Image, options: {
+				x?: number,
+				y?: number,
+				srcRect?: Rect | null,
+				alpha?: 'straight' | 'premultiplied',
+				opacity?: number,
+				async: true,
+			}): Promise<void>
+
+			copyRect (image: Image, srcRect: Rect, x: number, y: number, options?: { async?: false }): void
+			copyRect (image: Image, srcRect: Rect, x: number, y: number, options: { async: true }): Promise<void>
+
+			fillRect (dst: Image, rect: Rect | null, color: Color, options?: { async?: false }): void
+			fillRect (dst: Image, rect: Rect | null, color: Color, options: { async: true }): Promise<void>
+		}
+
+	}
+
+	export namespace EventQueue {
+
+		type Pushable<T> = T extends { type: string }
+			? Pick<T, 'type'> & Partial<Omit<T, 'type'>>
+			: never
+
+		export type PushableEvent
+			= Pushable<Events.Window.KeyDown | Events.Window.KeyUp> & { window?: Video.Window }
+			| Pushable<Events.Window.MouseMove | Events.Window.MouseButtonDown | Events.Window.MouseButtonUp | Events.Window.MouseWheel> & { window?: Video.Window }
+			| Pushable<Events.Window.FingerDown | Events.Window.FingerUp | Events.Window.FingerMove> & { window?: Video.Window }
+			| Pushable<Events.Joystick.AxisMotion | Events.Joystick.BallMotion | Events.Joystick.ButtonDown | Events.Joystick.ButtonUp | Events.Joystick.HatMotion> & { joystick: Joystick.JoystickInstance }
+			| Pushable<Events.Controller.AxisMotion | Events.Controller.ButtonDown | Events.Controller.ButtonUp> & { controller: Controller.ControllerInstance }
+
+		export interface ReplayOptions {
+			speed?: number
+		}
+
+		interface Module {
+			push (events: PushableEvent[]): number
+
+			readonly recording: boolean
+			startRecording (path: string): void
+			stopRecording (): number
+
+			readonly replaying: boolean
+			replay (path: string, options?: ReplayOptions): Promise<void>
+			stopReplay (): void
+		}
+
+	}
+
 }
 
 export const info: Sdl.Info
@@ -1387,3 +1739,5 @@ export const sensor: Sdl.Sensor.Module
 export const audio: Sdl.Audio.Module
 export const clipboard: Sdl.Clipboard.Module
 export const power: Sdl.Power.Module
+export const pixels: Sdl.Pixels.Module
+export const events: Sdl.EventQueue.Module
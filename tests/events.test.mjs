@@ -0,0 +1,35 @@
+import T from '@kmamal/testing'
+import sdl from '../src/javascript/index.js'
+
+T.test("sdl::events", async (t) => {
+	t.equal(sdl.events.recording, false)
+	t.equal(sdl.events.replaying, false)
+
+	const window = sdl.video.createWindow({ visible: false })
+
+	const received = []
+	window.on('keyDown', (event) => { received.push(event) })
+	window.on('mouseMove', (event) => { received.push(event) })
+
+	const pushed = sdl.events.push([
+		{ type: 'keyDown', window, scancode: sdl.keyboard.SCANCODE.A, shift: true },
+		{ type: 'mouseMove', window, x: 10, y: 20, dx: 1, dy: 2 },
+	])
+	t.equal(pushed, 2)
+
+	await new Promise((resolve) => { setTimeout(resolve, 50) })
+
+	t.equal(received.length, 2)
+	t.equal(received[0].type, 'keyDown')
+	t.equal(received[0].scancode, sdl.keyboard.SCANCODE.A)
+	t.equal(received[0].shift, true)
+	t.equal(received[1].type, 'mouseMove')
+	t.equal(received[1].x, 10)
+	t.equal(received[1].dy, 2)
+
+	let error = null
+	try { sdl.events.push([ { type: 'axisMotion', axis: 0, value: 0 } ]) } catch (_error) { error = _error }
+	t.ok(error instanceof Error)
+
+	window.destroy()
+})
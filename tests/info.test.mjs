@@ -27,4 +27,7 @@ T.test("sdl::info", (t) => {
 	}
 	t.equal(typeof sdl.info.drivers.audio.current, 'string')
 	t.ok(sdl.info.drivers.audio.all.includes(sdl.info.drivers.audio.current))
+
+	t.ok(Array.isArray(sdl.info.drivers.render.all))
+	t.ok(sdl.info.drivers.render.all.includes('software'))
 })
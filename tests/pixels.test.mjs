@@ -0,0 +1,69 @@
+import T from '@kmamal/testing'
+import sdl from '../src/javascript/index.js'
+import Os from 'node:os'
+
+T.test("sdl::pixels", async (t) => {
+	const width = 19
+	const height = 3
+	const rgb = Buffer.alloc(width * height * 3)
+	for (let i = 0; i < rgb.length; i++) { rgb[i] = (i * 7) & 0xff }
+
+	const argb = sdl.pixels.convert(width, height, width * 3, 'rgb24', rgb, 'argb8888')
+	t.equal(argb.format, 'argb8888')
+	t.equal(argb.stride, width * 4)
+	t.equal(argb.buffer.length, width * height * 4)
+	const word = Os.endianness() === 'LE' ? argb.buffer.readUInt32LE(5 * 4) : argb.buffer.readUInt32BE(5 * 4)
+	t.equal(word, ((0xff << 24) | (rgb[15] << 16) | (rgb[16] << 8) | rgb[17]) >>> 0)
+
+	const bgr = sdl.pixels.convert(width, height, argb.stride, argb.format, argb.buffer, 'bgr24')
+	for (let i = 0; i < rgb.length; i += 3) {
+		t.equal(bgr.buffer[i], rgb[i + 2])
+		t.equal(bgr.buffer[i + 2], rgb[i])
+	}
+
+	const rgba = sdl.pixels.convert(width, height, width * 3, 'rgb24', rgb, 'rgba32', { stride: width * 4 + 8 })
+	t.equal(rgba.stride, width * 4 + 8)
+	t.equal(rgba.buffer[3], 0xff)
+	t.equal(rgba.buffer[rgba.stride], rgb[width * 3])
+
+	const big = sdl.pixels.scale(width, height, width * 3, 'rgb24', rgb, width * 2, height * 2)
+	t.equal(big.width, width * 2)
+	t.equal(big.height, height * 2)
+	t.equal(big.buffer.compare(big.buffer, 0, 3, 3, 6), 0)
+	t.equal(big.buffer.compare(rgb, 0, 3, 0, 3), 0)
+
+	const flat = Buffer.alloc(8 * 8 * 4, 0x40)
+	const small = sdl.pixels.scale(8, 8, 8 * 4, 'rgba32', flat, 3, 5, { scaling: 'linear' })
+	t.ok(small.buffer.every((x) => x === 0x40))
+
+	const canvas = { width: 8, height: 4, stride: 8 * 4, format: 'rgba32', buffer: Buffer.alloc(8 * 4 * 4) }
+	sdl.pixels.fillRect(canvas, null, { r: 0, g: 0, b: 200 })
+	t.equal(canvas.buffer.readUInt32BE(0), 0x0000c8ff)
+	sdl.pixels.fillRect(canvas, { x: 6, y: -1, width: 10, height: 2 }, { r: 10, g: 20, b: 30, a: 40 })
+	t.equal(canvas.buffer.readUInt32BE(7 * 4), 0x0a141e28)
+	t.equal(canvas.buffer.readUInt32BE(8 * 4 + 7 * 4), 0x0000c8ff)
+
+	const sprite = { width: 2, height: 2, stride: 2 * 4, format: 'rgba32', buffer: Buffer.from([
+		200, 100, 50, 128, 1, 2, 3, 0,
+		9, 9, 9, 255, 200, 100, 50, 128,
+	]) }
+	sdl.pixels.blend(canvas, sprite, { x: 1, y: 1 })
+	t.equal(canvas.buffer.readUInt32BE(canvas.stride + 4), 0x64327dff)
+	t.equal(canvas.buffer.readUInt32BE(canvas.stride + 8), 0x0000c8ff)
+	t.equal(canvas.buffer.readUInt32BE(canvas.stride * 2 + 4), 0x090909ff)
+
+	const copy = { width: 8, height: 4, stride: 8 * 4, format: 'argb8888', buffer: Buffer.alloc(8 * 4 * 4) }
+	sdl.pixels.blit(copy, canvas)
+	const back = sdl.pixels.convert(copy.width, copy.height, copy.stride, copy.format, copy.buffer, 'rgba32')
+	t.equal(back.buffer.compare(canvas.buffer), 0)
+
+	sdl.pixels.copyRect(canvas, { x: 0, y: 0, width: 8, height: 3 }, 0, 1)
+	t.equal(canvas.buffer.readUInt32BE(canvas.stride * 2 + 4), 0x64327dff)
+	t.equal(canvas.buffer.readUInt32BE(canvas.stride * 3 + 4), 0x090909ff)
+
+	const large = { width: 512, height: 512, stride: 512 * 4, format: 'bgra32', buffer: Buffer.alloc(512 * 512 * 4) }
+	const promise = sdl.pixels.fillRect(large, null, { r: 1, g: 2, b: 3 }, { async: true })
+	t.ok(promise instanceof Promise)
+	await promise
+	t.equal(large.buffer.readUInt32BE(large.buffer.length - 4), 0x030201ff)
+})
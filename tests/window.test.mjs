@@ -1,5 +1,8 @@
 import T from '@kmamal/testing'
 import sdl from '../src/javascript/index.js'
+import Fs from 'node:fs'
+import Os from 'node:os'
+import Path from 'node:path'
 
 T.test("sdl::window", (t) => {
 	t.ok(Array.isArray(sdl.video.windows))
@@ -58,6 +61,9 @@ T.test("sdl::window", (t) => {
 
 	t.equal(typeof window1.pixelWidth, 'number')
 	t.equal(typeof window1.pixelHeight, 'number')
+	window1.setSizeInPixels(window1.pixelWidth, window1.pixelHeight)
+	t.equal(window1.width, 89)
+	t.equal(window1.height, 90)
 
 	t.equal(window1.visible, true)
 	t.equal(window2.visible, false)
@@ -116,6 +122,21 @@ T.test("sdl::window", (t) => {
 	window1.setVsync(true)
 	t.equal(window1.vsync, true)
 
+	{
+		const window3 = sdl.video.createWindow({ renderDriver: 'software', renderBatching: false })
+		t.equal(window3.accelerated, false)
+		t.equal(window3.renderer.name, 'software')
+		t.ok(window3.renderer.textureFormats.includes(window3.renderer.preferredFormat))
+		t.equal(typeof window3.renderer.maxTextureWidth, 'number')
+		t.equal(typeof window3.renderer.maxTextureHeight, 'number')
+		const texture = window3.createTexture(4, 4, 'rgba32')
+		window3.setVsync(false)
+		t.equal(texture.destroyed, false)
+		window3.destroy()
+	}
+
+	t.equal(typeof window1.renderer.name, 'string')
+	t.ok(Array.isArray(window1.renderer.textureFormats))
 	t.equal(window1.opengl, false)
 	t.equal(window1.webgpu, false)
 	t.ok(Buffer.isBuffer(window1.native.handle))
@@ -153,11 +174,130 @@ T.test("sdl::window", (t) => {
 
 	t.equal(typeof window1.render, 'function')
 
+	const { buffer, stride } = window1.lockPixels(16, 8, 'rgba32')
+	t.ok(stride >= 16 * 4)
+	t.ok(buffer.length >= stride * 8)
+	buffer.fill(0xff, 0, stride * 8)
+	window1.present()
+	t.equal(buffer.length, 0)
+
+	const image = Buffer.alloc(16 * 8 * 4)
+	window1.render(16, 8, 16 * 4, 'rgba32', image)
+	window1.render(16, 8, 16 * 4, 'rgba32', image, { dirtyRects: [ { x: 2, y: 2, width: 4, height: 4 } ] })
+	window1.render(16, 8, 16 * 4, 'rgba32', image, { dirtyRects: [] })
+
+	t.equal(window1.damage, null)
+	window1.render(16, 8, 16 * 4, 'rgba32', image, { detectDamage: true })
+	window1.render(16, 8, 16 * 4, 'rgba32', image, { detectDamage: true })
+	t.equal(window1.damage.tiles, 1)
+	t.equal(window1.damage.changedTiles, 0)
+	image[0] = 0xff
+	window1.render(16, 8, 16 * 4, 'rgba32', image, { detectDamage: true })
+	t.equal(window1.damage.changedTiles, 1)
+
+	const luma = Buffer.alloc(16 * 8)
+	const chroma = Buffer.alloc(8 * 4, 0x80)
+	window1.renderYUV(16, 8, luma, 16, chroma, 8, chroma, 8, { conversion: 'bt709' })
+	t.equal(window1.damage, null)
+	window1.renderNV(16, 8, luma, 16, Buffer.alloc(16 * 4, 0x80), 16, { format: 'nv21' })
+
+	const texture = window1.createTexture(16, 8, 'rgba32')
+	t.equal(texture.width, 16)
+	t.equal(texture.height, 8)
+	t.equal(texture.format, 'rgba32')
+	t.equal(texture.window, window1)
+	texture.update(image, 16 * 4)
+	texture.update(image, 16 * 4, { x: 4, y: 4, width: 4, height: 4 })
+	window1.draw(texture)
+	window1.draw(texture, { dstRect: { x: 2, y: 2, width: 8, height: 4 }, alpha: 0.5, angle: 90, flipX: true })
+	const vertices = new Float32Array([
+		0, 0, 0, 0, 0,
+		8, 0, 0, 1, 0,
+		8, 8, 0, 1, 1,
+		0, 8, 0, 0, 1,
+	])
+	new Uint8Array(vertices.buffer).fill(0xff, 8, 12)
+	window1.drawGeometry(texture, vertices, new Uint16Array([ 0, 1, 2, 2, 3, 0 ]))
+	window1.drawGeometry(null, vertices.subarray(0, 15))
+	window1.present()
+	t.equal(texture.destroyed, false)
+	texture.destroy()
+	t.equal(texture.destroyed, true)
+
+	const target = window1.createRenderTarget(4, 2)
+	t.equal(target.target, true)
+	window1.setRenderTarget(target)
+	t.equal(window1.renderTarget, target)
+	window1.clear()
+	window1.setRenderTarget(null)
+	const readback = target.readPixels()
+	t.equal(readback.width, 4)
+	t.equal(readback.buffer.length, readback.stride * 2)
+	target.destroy()
+
+	t.equal(window1.frameCapture, false)
+	window1.setFrameCapture(true, { width: 8, height: 4 })
+	t.equal(window1.readPixels(), null)
+	window1.render(16, 8, 16 * 4, 'rgba32', image)
+	window1.render(16, 8, 16 * 4, 'rgba32', image)
+	t.equal(window1.readPixels().width, 8)
+	window1.setFrameCapture(false)
+	t.equal(window1.frameCapture, false)
+
+	const capturePath = Path.join(Os.tmpdir(), `sdl-capture-${process.pid}.y4m`)
+	t.equal(window1.capturing, false)
+	t.equal(window1.captureStats, null)
+	window1.startCapture(capturePath, { width: 8, height: 4, fps: 1000 })
+	t.equal(window1.capturing, true)
+	t.equal(window1.frameCapture, true)
+	window1.render(16, 8, 16 * 4, 'rgba32', image)
+	window1.render(16, 8, 16 * 4, 'rgba32', image)
+	const captureStats = window1.stopCapture()
+	t.equal(window1.capturing, false)
+	t.equal(window1.frameCapture, false)
+	t.ok(captureStats.frames >= 1)
+	const capture = Fs.readFileSync(capturePath)
+	t.ok(capture.toString('latin1').startsWith('YUV4MPEG2 W8 H4 F1000:1'))
+	t.equal(capture.length, capture.indexOf('\n') + 1 + captureStats.frames * (6 + 8 * 4 * 3 / 2))
+	Fs.unlinkSync(capturePath)
+
+	t.equal(window1.asyncRender, false)
+	if (process.platform !== 'darwin') {
+		window1.setAsyncRender(true, { queueDepth: 2 })
+		t.equal(window1.asyncRender, true)
+		t.ok(window1.render(16, 8, 16 * 4, 'rgba32', image) instanceof Promise)
+		window1.setAsyncRender(false)
+		t.equal(window1.asyncRender, false)
+	}
+
 	t.equal(typeof window1.setIcon, 'function')
+	window1.setIcon(2, 2, 2 * 4, 'rgba32', Buffer.alloc(2 * 2 * 4, 0xff))
 
 	t.equal(typeof window1.flash, 'function')
 	t.equal(typeof window1.stopFlashing, 'function')
 
+	t.equal(window1.coalesceMotion, false)
+	window1.setCoalesceMotion(true)
+	t.equal(window1.coalesceMotion, true)
+	window1.setCoalesceMotion(false)
+	t.equal(window1.coalesceMotion, false)
+
+	t.equal(window1.latencyTracking, false)
+	t.equal(window1.latency, null)
+	window1.setLatencyTracking(true)
+	t.equal(window1.latencyTracking, true)
+	t.equal(window1.latency.pumpToDispatch.count, 0)
+	t.equal(window1.latency.dispatchToRender.p99, null)
+	window1.setLatencyTracking(false)
+
+	t.ok(window1.frameStats.frames > 0)
+	t.equal(window1.frameStats.upload.count > 0, true)
+	window1.resetFrameStats()
+	t.equal(window1.frameStats.frames, 0)
+	t.equal(window1.frameStats.interval.p95, null)
+	window1.render(16, 8, 16 * 4, 'rgba32', image)
+	t.equal(window1.frameStats.present.count, 1)
+
 	t.equal(window1.display, sdl.video.displays[0])
 	t.equal(window2.display, sdl.video.displays[0])
 